@@ -2,7 +2,164 @@
 #ifndef MODULES_TASK_1_ARTEMIEV_A_INTEGR_RECT_INTEGR_RECT_H_
 #define MODULES_TASK_1_ARTEMIEV_A_INTEGR_RECT_INTEGR_RECT_H_
 
+#include <mpi.h>
+#include <cmath>
+#include <queue>
+#include <vector>
+
 double integrateSequential(double (*f)(double), double a, double b, int n);
 double integrateParallel(double (*f)(double), double a, double b, int n);
 
+// Result of the 15-point Kronrod rule on [a, b]. The difference from the
+// embedded 7-point Gauss rule is the error estimate.
+struct Segment {
+    double a;
+    double b;
+    double integral;
+    double error;
+
+    bool operator<(const Segment& other) const { return error < other.error; }
+};
+
+// Adaptive integration stops after this many segments even if the error
+// is still larger than eps
+const int maxSegments = 1 << 16;
+
+const double kronrodNodes[8] = {
+    0.991455371120812639206854697526329, 0.949107912342758524526189684047851,
+    0.864864423359769072789712788640926, 0.741531185599394439863864773280788,
+    0.586087235467691130294144845693013, 0.405845151377397166906606412076961,
+    0.207784955007898467600689403773245, 0.0};
+const double kronrodWeights[8] = {
+    0.022935322010529224963732008058970, 0.063092092629978553290700663189204,
+    0.104790010322250183839876322541518, 0.140653259715525918745189590510238,
+    0.169004726639267902826583426598550, 0.190350578064785409913256402421014,
+    0.204432940075298892414161999234649, 0.209482141084727828012999174891714};
+// Weights of the Gauss nodes kronrodNodes[1], [3], [5] and [7]
+const double gaussWeights[4] = {
+    0.129484966168869693270611432679082, 0.279705391489276667901467771423780,
+    0.381830050505118944950369775488975, 0.417959183673469387755102040816327};
+
+template <typename F>
+Segment gaussKronrod(F f, double a, double b) {
+    double center = (a + b) / 2;
+    double half = (b - a) / 2;
+
+    double fc = f(center);
+    double kronrod = fc * kronrodWeights[7];
+    double gauss = fc * gaussWeights[3];
+    for (int i = 0; i < 7; i++) {
+        double dx = half * kronrodNodes[i];
+        double sum = f(center - dx) + f(center + dx);
+        kronrod += sum * kronrodWeights[i];
+        if (i % 2 == 1) gauss += sum * gaussWeights[i / 2];
+    }
+    return Segment{a, b, kronrod * half, std::abs((kronrod - gauss) * half)};
+}
+
+// Adaptive G7K15 integration: the segment with the largest error is
+// halved until the sum of the errors is not greater than eps
+template <typename F>
+double integrateAdaptiveSequential(F f, double a, double b, double eps,
+                                   int* evaluations = nullptr) {
+    std::priority_queue<Segment> segments;
+    segments.push(gaussKronrod(f, a, b));
+    double error = segments.top().error;
+
+    while (error > eps && static_cast<int>(segments.size()) < maxSegments) {
+        Segment worst = segments.top();
+        segments.pop();
+        double middle = (worst.a + worst.b) / 2;
+        Segment left = gaussKronrod(f, worst.a, middle);
+        Segment right = gaussKronrod(f, middle, worst.b);
+        error += left.error + right.error - worst.error;
+        segments.push(left);
+        segments.push(right);
+    }
+
+    if (evaluations != nullptr)
+        *evaluations = 15 * (2 * static_cast<int>(segments.size()) - 1);
+    double integralValue = 0.0;
+    for (; !segments.empty(); segments.pop())
+        integralValue += segments.top().integral;
+    return integralValue;
+}
+
+// The same integration with a work pool on the root process: a process
+// that is done with its segment gets the currently worst one, so the
+// processes never wait for each other. The result is returned on every
+// process.
+template <typename F>
+double integrateAdaptiveParallel(F f, double a, double b, double eps,
+                                 int* evaluations = nullptr) {
+    enum Tag { WORK = 0, STOP = 1 };
+    int comm_size, rank;
+    MPI_Comm_size(MPI_COMM_WORLD, &comm_size);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    if (comm_size == 1)
+        return integrateAdaptiveSequential(f, a, b, eps, evaluations);
+
+    double result[2] = {0.0, 0.0};
+    if (rank != 0) {
+        double bounds[2];
+        MPI_Status stat;
+        while (true) {
+            MPI_Recv(bounds, 2, MPI_DOUBLE, 0, MPI_ANY_TAG, MPI_COMM_WORLD,
+                     &stat);
+            if (stat.MPI_TAG == STOP) break;
+            double middle = (bounds[0] + bounds[1]) / 2;
+            Segment left = gaussKronrod(f, bounds[0], middle);
+            Segment right = gaussKronrod(f, middle, bounds[1]);
+            double halves[4] = {left.integral, left.error, right.integral,
+                                right.error};
+            MPI_Send(halves, 4, MPI_DOUBLE, 0, WORK, MPI_COMM_WORLD);
+        }
+    } else {
+        std::priority_queue<Segment> segments;
+        segments.push(gaussKronrod(f, a, b));
+        double error = segments.top().error;
+        int count = 1;
+
+        // a segment keeps its error in the sum while its halves are computed
+        std::vector<Segment> inWork(comm_size);
+        std::vector<int> idle;
+        for (int i = comm_size - 1; i > 0; i--) idle.push_back(i);
+        while (true) {
+            while (!idle.empty() && !segments.empty() && error > eps &&
+                   count < maxSegments) {
+                int worker = idle.back();
+                idle.pop_back();
+                inWork[worker] = segments.top();
+                segments.pop();
+                double bounds[2] = {inWork[worker].a, inWork[worker].b};
+                MPI_Send(bounds, 2, MPI_DOUBLE, worker, WORK, MPI_COMM_WORLD);
+                count++;
+            }
+            if (static_cast<int>(idle.size()) == comm_size - 1) break;
+
+            double halves[4];
+            MPI_Status stat;
+            MPI_Recv(halves, 4, MPI_DOUBLE, MPI_ANY_SOURCE, WORK,
+                     MPI_COMM_WORLD, &stat);
+            const Segment& parent = inWork[stat.MPI_SOURCE];
+            double middle = (parent.a + parent.b) / 2;
+            segments.push(Segment{parent.a, middle, halves[0], halves[1]});
+            segments.push(Segment{middle, parent.b, halves[2], halves[3]});
+            error += halves[1] + halves[3] - parent.error;
+            idle.push_back(stat.MPI_SOURCE);
+        }
+
+        for (int i = 1; i < comm_size; i++)
+            MPI_Send(nullptr, 0, MPI_DOUBLE, i, STOP, MPI_COMM_WORLD);
+        for (; !segments.empty(); segments.pop())
+            result[0] += segments.top().integral;
+        result[1] = 15 * (2 * count - 1);
+    }
+
+    MPI_Bcast(result, 2, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    if (evaluations != nullptr) *evaluations = static_cast<int>(result[1]);
+    return result[0];
+}
+
 #endif  // MODULES_TASK_1_ARTEMIEV_A_INTEGR_RECT_INTEGR_RECT_H_
@@ -58,6 +58,46 @@ TEST(RectIntegration, RectIntegration_complex) {
     test(f, a, b, n);
 }
 
+TEST(RectIntegration, Adaptive_Polynom) {
+    double c = 2;
+    auto f = [c](double x) { return c * x * x * x + x; };
+    int evaluations = 0;
+
+    double result = integrateAdaptiveParallel(f, -1, 3, 1e-10, &evaluations);
+
+    EXPECT_NEAR(result, 2 * (81.0 - 1.0) / 4 + (9.0 - 1.0) / 2, 1e-10);
+    EXPECT_EQ(15, evaluations);
+}
+
+TEST(RectIntegration, Adaptive_Peak) {
+    // the peak of width 0.01 needs small steps only around 0.3
+    auto f = [](double x) { return 1 / (1e-4 + (x - 0.3) * (x - 0.3)); };
+    double exact = (atan(70.0) + atan(30.0)) / 0.01;
+    int rank, evaluations = 0;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    double result = integrateAdaptiveParallel(f, 0, 1, 1e-8, &evaluations);
+
+    EXPECT_NEAR(result, exact, 1e-7);
+    EXPECT_LT(evaluations, 3000);
+    if (rank == 0) {
+        double seqResult =
+            integrateAdaptiveSequential(f, 0.0, 1.0, 1e-8, &evaluations);
+        EXPECT_NEAR(seqResult, exact, 1e-7);
+        double rectResult = integrateSequential(f, 0, 1, evaluations);
+        EXPECT_GT(fabs(rectResult - exact), 1e-6);
+    }
+}
+
+TEST(RectIntegration, Adaptive_Oscillating) {
+    auto f = [](double x) { return x * sin(2 * x); };
+    auto primitive = [](double x) { return sin(2 * x) / 4 - x * cos(2 * x) / 2; };
+
+    double result = integrateAdaptiveParallel(f, -3, 100, 1e-9);
+
+    EXPECT_NEAR(result, primitive(100) - primitive(-3), 1e-8);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     MPI_Init(&argc, &argv);
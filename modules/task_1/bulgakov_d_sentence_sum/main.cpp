@@ -4,6 +4,7 @@
 #include <string>
 #include <iostream>
 #include <fstream>
+#include <cstdio>
 #include "./sentence_sum.h"
 #include <gtest-mpi-listener.hpp>
 
@@ -118,8 +119,155 @@ TEST(Parallel_Operations_MPI, Test_5) {
         ASSERT_EQ(local_cnt, global_sum);
     }
 }
+// Delimiter runs crossing the vector blocks, compared with a byte by byte count
+TEST(Parallel_Operations_MPI, Test_6) {
+    std::string text;
+    const std::string pieces[] = {"a", "b c", ".", "?", "!", " ", "\xE9", "..."};
+    unsigned seed = 7;
+    for (int i = 0; i < 2000; i++) {
+        seed = seed * 1103515245u + 12345u;
+        text += pieces[(seed >> 16) % 8];
+    }
+
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    if (rank == 0) {
+        for (size_t offset = 0; offset < 40; offset += 3) {
+            for (size_t len = 0; len + offset <= text.length(); len += 97) {
+                int expected = 0;
+                bool isDelimStarted = false;
+                for (size_t i = offset; i < offset + len; i++) {
+                    if (text[i] == '?' || text[i] == '!' || text[i] == '.') {
+                        isDelimStarted = true;
+                    } else if (isDelimStarted) {
+                        isDelimStarted = false;
+                        expected++;
+                    }
+                }
+                if (isDelimStarted) expected++;
+                ASSERT_EQ(expected, countSentenceEnds(text.data() + offset, len));
+            }
+        }
+    }
+}
 
 
+namespace {
+
+std::string randomText(size_t pieces_count, unsigned seed) {
+    std::string text;
+    const std::string pieces[] = {"word", " ", ".", "?!", "...", "\xD0\x96", "\xE2\x82\xAC", "!"};
+    for (size_t i = 0; i < pieces_count; i++) {
+        seed = seed * 1103515245u + 12345u;
+        text += pieces[(seed >> 16) % 8];
+    }
+    return text;
+}
+
+}  // namespace
+
+// Delimiter runs are cut by the split of the string between the ranks
+TEST(Parallel_Operations_MPI, Test_7) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    for (size_t pieces_count : {1, 3, 10, 1000, 5000}) {
+        std::string test_string;
+        if (rank == 0) test_string = randomText(pieces_count, 11 + pieces_count);
+
+        int global_sum = parallelSentenceCount(test_string);
+
+        if (rank == 0) {
+            ASSERT_EQ(computeSenteceCount(test_string), global_sum);
+        }
+    }
+}
+
+// Range boundaries split neither delimiter runs nor UTF-8 characters and cover the text
+TEST(Parallel_Operations_MPI, Test_8) {
+    std::string text = randomText(3000, 5);
+    for (int procs = 1; procs <= 9; procs++) {
+        int sum = 0;
+        const char* expected_begin = text.data();
+        for (int proc = 0; proc < procs; proc++) {
+            TextChunk chunk = rankChunk(text.data(), text.length(), proc, procs);
+            ASSERT_EQ(expected_begin, chunk.data);
+            expected_begin = chunk.data + chunk.size;
+            if (chunk.size > 0) {
+                ASSERT_NE(0x80, static_cast<unsigned char>(chunk.data[0]) & 0xC0);
+            }
+            sum += countSentenceEnds(chunk.data, chunk.size);
+        }
+        ASSERT_EQ(text.data() + text.length(), expected_begin);
+        ASSERT_EQ(computeSenteceCount(text), sum);
+    }
+}
+
+// Every rank maps the file and counts its own range
+TEST(Parallel_Operations_MPI, Test_9) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    const std::string path = "bulgakov_d_sentence_sum_test.txt";
+    std::string text = randomText(20000, 3);
+    if (rank == 0) {
+        std::ofstream out(path, std::ios::binary);
+        out << text;
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    int global_sum = parallelSentenceCountFile(path);
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    if (rank == 0) {
+        std::remove(path.c_str());
+        ASSERT_EQ(computeSenteceCount(text), global_sum);
+    }
+}
+
+// An empty file can't be mapped but still has no sentences
+TEST(Parallel_Operations_MPI, Test_10) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    const std::string path = "bulgakov_d_sentence_sum_empty.txt";
+    if (rank == 0) {
+        std::ofstream out(path, std::ios::binary);
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    int global_sum = parallelSentenceCountFile(path);
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    if (rank == 0) {
+        std::remove(path.c_str());
+        ASSERT_EQ(0, global_sum);
+    }
+    ASSERT_ANY_THROW(MappedText("bulgakov_d_sentence_sum_missing.txt"));
+}
+
+TEST(Parallel_Operations_MPI, Test_11) {
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    const std::string path = "bulgakov_d_sentence_sum_one_missing.txt";
+    if (rank == 0) {
+        std::ofstream out(path, std::ios::binary);
+        out << "One. Two! Three?";
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    // Only the last rank can't open its file, but every rank has to throw
+    const std::string rankPath = rank == size - 1 ? "bulgakov_d_sentence_sum_missing.txt" : path;
+    ASSERT_ANY_THROW(parallelSentenceCountFile(rankPath));
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    if (rank == 0) {
+        std::remove(path.c_str());
+    }
+}
 
 
 int main(int argc, char** argv) {
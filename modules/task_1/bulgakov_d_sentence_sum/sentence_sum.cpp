@@ -3,10 +3,26 @@
 #include "../../../modules/task_1/bulgakov_d_sentence_sum/sentence_sum.h"
 
 #include <mpi.h>
+#include <algorithm>
+#include <cstdint>
 #include <string>
 #include <random>
 
 #include <iostream>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 // #define debug
 
@@ -48,83 +64,217 @@ std::vector<std::string> parseText(std::string str, int proc_num) {
     return vectorParts;
 }
 
-// isDelimStarted is boolean value that means that we are
-// at the end of line and the following special characters before
-// space or alphabetic symbol contains in
-// delimChatCases are a part of that ending line
-int computeSenteceCount(std::string str) {
+namespace {
+
+// Character class table of the sentence delimiters "?!."
+struct DelimTable {
+    bool isDelim[256];
+    DelimTable() {
+        for (int c = 0; c < 256; c++) isDelim[c] = false;
+        isDelim[static_cast<unsigned char>('?')] = true;
+        isDelim[static_cast<unsigned char>('!')] = true;
+        isDelim[static_cast<unsigned char>('.')] = true;
+    }
+};
+
+const DelimTable delimTable;
+
+bool isDelim(char c) {
+    return delimTable.isDelim[static_cast<unsigned char>(c)];
+}
+
+// A boundary may not cut a run of delimiters or land on a UTF-8 continuation byte
+bool isSafeBoundary(const char* text, size_t size, size_t pos) {
+    if (pos == 0 || pos >= size) return true;
+    if ((static_cast<unsigned char>(text[pos]) & 0xC0) == 0x80) return false;
+    return !(isDelim(text[pos - 1]) && isDelim(text[pos]));
+}
+
+size_t safeBoundary(const char* text, size_t size, size_t pos) {
+    while (!isSafeBoundary(text, size, pos)) pos++;
+    return pos;
+}
+
+#if defined(__AVX2__)
+unsigned delimMask(const char* p) {
+    __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    __m256i delim = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8('?')),
+                        _mm256_cmpeq_epi8(block, _mm256_set1_epi8('!'))),
+        _mm256_cmpeq_epi8(block, _mm256_set1_epi8('.')));
+    return static_cast<unsigned>(_mm256_movemask_epi8(delim));
+}
+const size_t blockSize = 32;
+#elif defined(__SSE2__)
+unsigned delimMask(const char* p) {
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i delim = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('?')),
+                     _mm_cmpeq_epi8(block, _mm_set1_epi8('!'))),
+        _mm_cmpeq_epi8(block, _mm_set1_epi8('.')));
+    return static_cast<unsigned>(_mm_movemask_epi8(delim));
+}
+const size_t blockSize = 16;
+#endif
+
+}  // namespace
+
+// A sentence ends where a run of the delimiters "?!." ends: at a delimiter
+// followed by another character or by the end of the text. The delimiter
+// masks of a block and of the same block shifted by one byte give all such
+// positions at once.
+int countSentenceEnds(const char* str, size_t size) {
     int cnt = 0;
-    std::string delimCharCases = "?!.";
-    bool isDelimStarted = false;
-
-    for (int i = 0; i < static_cast<int>(str.length()); i++) {
-        if (delimCharCases.find(str[i]) < delimCharCases.length()) {
-            isDelimStarted = true;
-        } else {
-            if (isDelimStarted) {
-                isDelimStarted = false;
-                cnt++;
-            }
-        }
+    size_t i = 0;
+
+#if defined(__AVX2__) || defined(__SSE2__)
+    for (; i + blockSize < size; i += blockSize) {
+        unsigned ends = delimMask(str + i) & ~delimMask(str + i + 1);
+        cnt += __builtin_popcount(ends);
     }
+#endif
 
-    if (isDelimStarted) cnt++;
+    for (; i < size; i++) {
+        bool isDelim = delimTable.isDelim[static_cast<unsigned char>(str[i])];
+        bool nextDelim = i + 1 < size &&
+            delimTable.isDelim[static_cast<unsigned char>(str[i + 1])];
+        if (isDelim && !nextDelim) cnt++;
+    }
 
     return cnt;
 }
 
+int computeSenteceCount(std::string str) {
+    return countSentenceEnds(str.data(), str.length());
+}
+
+#ifdef _WIN32
+MappedText::MappedText(const std::string& path)
+    : textData(nullptr), textSize(0), fileHandle(nullptr), mappingHandle(nullptr) {
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) throw "Can't open the text file";
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        CloseHandle(file);
+        throw "Can't get the text file size";
+    }
+    fileHandle = file;
+    textSize = static_cast<size_t>(fileSize.QuadPart);
+    if (textSize == 0) return;
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    const void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (view == NULL) {
+        if (mapping) CloseHandle(mapping);
+        CloseHandle(file);
+        throw "Can't map the text file";
+    }
+    mappingHandle = mapping;
+    textData = static_cast<const char*>(view);
+}
+
+MappedText::~MappedText() {
+    if (textData) UnmapViewOfFile(textData);
+    if (mappingHandle) CloseHandle(mappingHandle);
+    if (fileHandle) CloseHandle(fileHandle);
+}
+#else
+MappedText::MappedText(const std::string& path) : textData(nullptr), textSize(0) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw "Can't open the text file";
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0) {
+        close(fd);
+        throw "Can't get the text file size";
+    }
+    textSize = static_cast<size_t>(fileStat.st_size);
+    if (textSize == 0) {
+        close(fd);
+        return;
+    }
+
+    void* view = mmap(nullptr, textSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) throw "Can't map the text file";
+    madvise(view, textSize, MADV_SEQUENTIAL);
+    textData = static_cast<const char*>(view);
+}
+
+MappedText::~MappedText() {
+    if (textData) munmap(const_cast<char*>(textData), textSize);
+}
+#endif
+
+TextChunk rankChunk(const char* text, size_t size, int rank, int procs) {
+    uint64_t total = size;
+    size_t begin = safeBoundary(text, size, static_cast<size_t>(total * rank / procs));
+    size_t end = safeBoundary(text, size, static_cast<size_t>(total * (rank + 1) / procs));
+    TextChunk chunk = {text + begin, end - begin};
+    return chunk;
+}
+
 int parallelSentenceCount(const std::string& str) {
     int size, rank;
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &size);
 
-    int mes_len, num_used_procs;
-    std::vector<std::string> vectorText;
+    int length = rank == 0 ? static_cast<int>(str.length()) : 0;
+    MPI_Bcast(&length, 1, MPI_INT, 0, MPI_COMM_WORLD);
 
-    if (rank == 0) {
-        vectorText = parseText(str, size);
-        num_used_procs = vectorText.size();
-        mes_len = vectorText[0].length();
-        for (int proc = 1; proc < vectorText.size(); proc++) {
-            std::string mes = vectorText[proc];
-
-            #ifdef debug
-            std::cout  << " SEND rank " << proc << " " << mes << std::endl;
-            #endif
-            MPI_Send(mes.c_str(), mes.length(), MPI_CHAR, proc, 0, MPI_COMM_WORLD);
-        }
+    // every used rank gets at least one byte, so its right neighbour holds the next one
+    int num_used_procs = std::min(size, length);
+    std::vector<int> counts(size, 0), displs(size, 0);
+    for (int proc = 0; proc < num_used_procs; proc++) {
+        displs[proc] = static_cast<int>(static_cast<int64_t>(length) * proc / num_used_procs);
+        counts[proc] = static_cast<int>(static_cast<int64_t>(length) * (proc + 1) / num_used_procs) - displs[proc];
     }
 
-    MPI_Barrier(MPI_COMM_WORLD);
-    MPI_Bcast(&mes_len, 1, MPI_INT, 0, MPI_COMM_WORLD);
-    MPI_Bcast(&num_used_procs, 1, MPI_INT, 0, MPI_COMM_WORLD);
-
-    std::string local_str;
-
-    if (rank == 0) {
-        local_str = vectorText[0];
-    } else if (rank < num_used_procs) {
-        MPI_Status status;
-        int maxbuffsize = mes_len + 1;
-        char * buff = new char[maxbuffsize];
-        MPI_Recv(buff, maxbuffsize, MPI_CHAR, 0, 0, MPI_COMM_WORLD, &status);
-
-        local_str = std::string(buff);
-        local_str = local_str.substr(0, mes_len);
-        #ifdef debug
-        std::cout  << "GET rank " << rank << " " << local_str << std::endl;
-        #endif
+    std::vector<char> local_str(counts[rank]);
+    MPI_Scatterv(rank == 0 ? str.data() : nullptr, counts.data(), displs.data(), MPI_CHAR,
+                 local_str.data(), counts[rank], MPI_CHAR, 0, MPI_COMM_WORLD);
+
+    int local_sum = countSentenceEnds(local_str.data(), local_str.size());
+
+    // A run of delimiters cut by the split is counted at the end of the left
+    // piece as well, so each piece checks the first byte of the next one.
+    int left = rank > 0 && rank < num_used_procs ? rank - 1 : MPI_PROC_NULL;
+    int right = rank + 1 < num_used_procs ? rank + 1 : MPI_PROC_NULL;
+    char first = local_str.empty() ? ' ' : local_str.front();
+    char next = ' ';
+    MPI_Sendrecv(&first, 1, MPI_CHAR, left, 0, &next, 1, MPI_CHAR, right, 0,
+                 MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    if (!local_str.empty() && isDelim(local_str.back()) && isDelim(next)) {
+        local_sum--;
     }
 
     int global_sum = 0;
-    int local_sum = computeSenteceCount(local_str);
+    MPI_Reduce(&local_sum, &global_sum, 1, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
+
+    return global_sum;
+}
+
+int parallelSentenceCountFile(const std::string& path) {
+    int size, rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
 
-    #ifdef debug
-    if (local_sum > 0) std::cout << "RANKK" << rank << std::endl;
-    #endif
+    // A rank that can't map the file must not leave the others waiting in the reduce
+    const char* error = nullptr;
+    int local_sum = 0;
+    try {
+        MappedText text(path);
+        TextChunk chunk = rankChunk(text.data(), text.size(), rank, size);
+        local_sum = countSentenceEnds(chunk.data, chunk.size);
+    } catch (const char* message) {
+        error = message;
+    }
+    int failed = error != nullptr;
+    MPI_Allreduce(MPI_IN_PLACE, &failed, 1, MPI_INT, MPI_LOR, MPI_COMM_WORLD);
+    if (failed) throw error ? error : "Can't map the text file on another rank";
 
+    int global_sum = 0;
     MPI_Reduce(&local_sum, &global_sum, 1, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
 
     return global_sum;
 }
-
@@ -3,13 +3,55 @@
 #ifndef MODULES_TASK_1_BULGAKOV_D_SENTENCE_SUM_SENTENCE_SUM_H_
 #define MODULES_TASK_1_BULGAKOV_D_SENTENCE_SUM_SENTENCE_SUM_H_
 
+#include <cstddef>
 #include <string>
 #include <vector>
 
+// Part of a text: size chars starting at data, owned by someone else.
+struct TextChunk {
+    const char* data;
+    size_t size;
+};
+
+// Text file mapped into memory (mmap, or a file mapping on Windows). Ranks on
+// one node that map the same file share its pages, so nobody has to send the
+// text around.
+class MappedText {
+ public:
+    explicit MappedText(const std::string& path);
+    ~MappedText();
+    MappedText(const MappedText&) = delete;
+    MappedText& operator=(const MappedText&) = delete;
+
+    const char* data() const { return textData; }
+    size_t size() const { return textSize; }
+
+ private:
+    const char* textData;
+    size_t textSize;
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#endif
+};
+
 std::vector<std::string> parseText(std::string str, int proc_num);
 
+// Number of runs of "?!." delimiters among size bytes starting at str.
+int countSentenceEnds(const char* str, size_t size);
+
 int computeSenteceCount(std::string str);
 
+// Byte range of rank among procs ranks. Both ends are moved forward until they
+// split neither a run of delimiters nor a UTF-8 code point, so the counts of
+// the ranges add up to the count of the whole text.
+TextChunk rankChunk(const char* text, size_t size, int rank, int procs);
+
+// The string lives on rank 0 only; the result is returned on rank 0.
 int parallelSentenceCount(const std::string& str);
 
+// Every rank maps the file and counts its own range; the result is returned on rank 0.
+// If the file can't be mapped on some rank, every rank throws.
+int parallelSentenceCountFile(const std::string& path);
+
 #endif  // MODULES_TASK_1_BULGAKOV_D_SENTENCE_SUM_SENTENCE_SUM_H_
@@ -6,6 +6,11 @@
 #include <algorithm>
 #include <numeric>
 #include <iostream>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 #include "../../../modules/task_1/chernova_a_counting_alphabetic_char/counting_alphabetic_char.h"
 
 
@@ -19,9 +24,60 @@ std::string getRandomString(size_t  size) {
     return str;
 }
 
+namespace {
+
+// Character class table: 1 for the latin letters, as isalpha in the "C" locale.
+struct AlphaTable {
+    unsigned char is_alpha[256];
+    AlphaTable() {
+        for (int c = 0; c < 256; c++) {
+            is_alpha[c] = (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+        }
+    }
+};
+
+const AlphaTable alpha_table;
+
+}  // namespace
+
+int CountingAlphabeticChar(const char* str, size_t size) {
+    int count = 0;
+    size_t i = 0;
+    // c | 0x20 folds the case; a letter then lies in ['a', 'z'], which after
+    // adding 128 - 'a' becomes the signed byte range [-128, -103]
+#if defined(__AVX2__)
+    const __m256i fold = _mm256_set1_epi8(0x20);
+    const __m256i shift = _mm256_set1_epi8(static_cast<char>(128 - 'a'));
+    const __m256i limit = _mm256_set1_epi8(static_cast<char>(-128 + 26));
+    for (; i + 32 <= size; i += 32) {
+        __m256i block = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(str + i));
+        __m256i shifted = _mm256_add_epi8(_mm256_or_si256(block, fold), shift);
+        unsigned mask = static_cast<unsigned>(
+            _mm256_movemask_epi8(_mm256_cmpgt_epi8(limit, shifted)));
+        count += __builtin_popcount(mask);
+    }
+#elif defined(__SSE2__)
+    const __m128i fold = _mm_set1_epi8(0x20);
+    const __m128i shift = _mm_set1_epi8(static_cast<char>(128 - 'a'));
+    const __m128i limit = _mm_set1_epi8(static_cast<char>(-128 + 26));
+    for (; i + 16 <= size; i += 16) {
+        __m128i block = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(str + i));
+        __m128i shifted = _mm_add_epi8(_mm_or_si128(block, fold), shift);
+        unsigned mask = static_cast<unsigned>(
+            _mm_movemask_epi8(_mm_cmplt_epi8(shifted, limit)));
+        count += __builtin_popcount(mask);
+    }
+#endif
+    for (; i < size; i++) {
+        count += alpha_table.is_alpha[static_cast<unsigned char>(str[i])];
+    }
+    return count;
+}
+
 int CountingAlphabeticCharSequential(const std::string& str) {
-    auto l = [](int b, char c) { if (isalpha(c))b++; return b; };
-    return std::accumulate(str.begin(), str.end(), 0, l);
+    return CountingAlphabeticChar(str.data(), str.size());
 }
 
 int CountingAlphabeticCharParallel(const std::string& str) {
@@ -37,9 +93,12 @@ int CountingAlphabeticCharParallel(const std::string& str) {
     }
 
     std::string local_string;
+    int local_count = 0;
     if (rank == 0) {
-        local_string = std::string(str.begin(),
-                                     str.begin() + delta);
+        // the null process also takes the characters left after the split
+        local_count = CountingAlphabeticChar(str.data(), delta) +
+            CountingAlphabeticChar(str.data() + delta * size,
+                                   str.length() - delta * size);
     } else {
         MPI_Status status;
         MPI_Probe(0, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
@@ -49,8 +108,10 @@ int CountingAlphabeticCharParallel(const std::string& str) {
             0, MPI_COMM_WORLD, &status);
     }
 
+    if (rank != 0) {
+        local_count = CountingAlphabeticCharSequential(local_string);
+    }
     int global_count = 0;
-    int local_count = CountingAlphabeticCharSequential(local_string);
     MPI_Reduce(&local_count, &global_count, 1,
         MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
     return global_count;
@@ -8,5 +8,7 @@
 std::string getRandomString(size_t  size);
 int CountingAlphabeticCharParallel(const std::string& str);
 int CountingAlphabeticCharSequential(const std::string& str);
+// Number of latin letters among size bytes starting at str.
+int CountingAlphabeticChar(const char* str, size_t size);
 
 #endif  // MODULES_TASK_1_CHERNOVA_A_COUNTING_ALPHABETIC_CHAR_COUNTING_ALPHABETIC_CHAR_H_
@@ -1,5 +1,7 @@
 // Copyright 2018 Nesterov Alexander
 #include <gtest/gtest.h>
+#include <cctype>
+#include <string>
 #include <vector>
 #include "./counting_alphabetic_char.h"
 #include <gtest-mpi-listener.hpp>
@@ -93,6 +95,51 @@ TEST(Parallel_Operations_MPI, Test_Max_2) {
         ASSERT_EQ(reference_max, global_max);
     }
 }
+TEST(Parallel_Operations_MPI, Test_All_Bytes) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    if (rank == 0) {
+        std::string str;
+        for (int repeat = 0; repeat < 3; repeat++) {
+            for (int c = 0; c < 256; c++) {
+                str.push_back(static_cast<char>(c));
+            }
+        }
+        for (size_t offset = 0; offset < 40; offset += 3) {
+            for (size_t len = 0; len + offset <= str.size(); len += 29) {
+                int expected = 0;
+                for (size_t i = offset; i < offset + len; i++) {
+                    unsigned char c = static_cast<unsigned char>(str[i]);
+                    expected += c < 128 && isalpha(c);
+                }
+                ASSERT_EQ(expected,
+                    CountingAlphabeticChar(str.data() + offset, len));
+            }
+        }
+    }
+}
+
+TEST(Parallel_Operations_MPI, Test_Size_Not_Divisible) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    std::string global_vec;
+    const int count_size_vector = 100003;
+
+    if (rank == 0) {
+        global_vec = getRandomString(count_size_vector);
+    }
+
+    int global_count = CountingAlphabeticCharParallel(global_vec);
+
+    if (rank == 0) {
+        int reference_count = 0;
+        for (char c : global_vec) {
+            reference_count += isalpha(c) != 0;
+        }
+        ASSERT_EQ(reference_count, global_count);
+    }
+}
 
 
 int main(int argc, char** argv) {
@@ -1,7 +1,9 @@
 // Copyright 2022 Kandrin Alexey
 #include <gtest/gtest.h>
+#include <cmath>
 #include <vector>
 #include "./min_value_by_rows.h"
+#include "./reduction.h"
 #include <gtest-mpi-listener.hpp>
 
 namespace {
@@ -112,6 +114,144 @@ TEST(Parallel_Operations_MPI, Test_Sum_5) {
   }
 }
 
+namespace {
+// Reference reduction by definition, element by element.
+template <ReduceOp Op, class T>
+std::vector<double> NaiveReduce(const Matrix<T>& matrix, Axis axis) {
+  size_t rowCount = matrix.GetRowCount();
+  size_t colCount = matrix.GetColCount();
+  size_t outer = axis == Axis::Rows   ? rowCount
+                 : axis == Axis::Cols ? colCount
+                                      : 1;
+  size_t inner = rowCount * colCount / outer;
+  std::vector<double> result(outer);
+  for (size_t k = 0; k < outer; ++k) {
+    double best = 0;
+    size_t bestIndex = 0;
+    for (size_t i = 0; i < inner; ++i) {
+      size_t row = axis == Axis::Rows ? k : axis == Axis::Cols ? i : i / colCount;
+      size_t col = axis == Axis::Rows ? i : axis == Axis::Cols ? k : i % colCount;
+      double value = matrix[row][col];
+      bool isMin = Op == ReduceOp::Min || Op == ReduceOp::ArgMin;
+      bool better = isMin ? value < best : value > best;
+      if (i == 0 || better) {
+        best = value;
+        bestIndex = i;
+      }
+      if (Op == ReduceOp::Sum || Op == ReduceOp::Mean) {
+        result[k] += value;
+      }
+    }
+    if (Op == ReduceOp::Min || Op == ReduceOp::Max) {
+      result[k] = best;
+    } else if (Op == ReduceOp::ArgMin || Op == ReduceOp::ArgMax) {
+      result[k] = bestIndex;
+    } else if (Op == ReduceOp::Mean) {
+      result[k] /= inner;
+    }
+  }
+  return result;
+}
+
+template <ReduceOp Op, class T>
+void CheckReduce(const Matrix<T>& matrix, Axis axis, size_t threadCount) {
+  int rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  auto result = ReduceParallel<Op>(matrix, axis, threadCount);
+
+  if (rank == 0) {
+    auto reference = NaiveReduce<Op>(matrix, axis);
+    auto sequential = Reduce<Op>(matrix, axis, threadCount);
+    ASSERT_EQ(reference.size(), result.size());
+    ASSERT_EQ(reference.size(), sequential.size());
+    for (size_t i = 0; i < reference.size(); ++i) {
+      double eps = 1e-9 * (1 + std::abs(reference[i]));
+      ASSERT_NEAR(reference[i], result[i], eps);
+      ASSERT_NEAR(reference[i], sequential[i], eps);
+    }
+  }
+}
+
+template <class T>
+void CheckAllOperators(const Matrix<T>& matrix, size_t threadCount) {
+  for (Axis axis : {Axis::Rows, Axis::Cols, Axis::All}) {
+    CheckReduce<ReduceOp::Min>(matrix, axis, threadCount);
+    CheckReduce<ReduceOp::Max>(matrix, axis, threadCount);
+    CheckReduce<ReduceOp::Sum>(matrix, axis, threadCount);
+    CheckReduce<ReduceOp::ArgMin>(matrix, axis, threadCount);
+    CheckReduce<ReduceOp::ArgMax>(matrix, axis, threadCount);
+    CheckReduce<ReduceOp::Mean>(matrix, axis, threadCount);
+  }
+}
+}  // namespace
+
+TEST(Parallel_Operations_MPI, Test_Reduce_Int_All_Operators) {
+  int rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  Matrix<int> matrix;
+
+  if (rank == 0) {
+    // values repeat, so the arg-reductions must return the first extremum
+    matrix = GetRandomMatrix<int>(37, 23, random_0_to_99);
+  }
+
+  CheckAllOperators(matrix, 1);
+}
+
+TEST(Parallel_Operations_MPI, Test_Reduce_Double_Threads) {
+  int rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  Matrix<double> matrix;
+
+  if (rank == 0) {
+    std::mt19937 gen(3);
+    std::uniform_real_distribution<double> dist(-1e3, 1e3);
+    matrix = GetRandomMatrix<double>(101, 64, [&]() { return dist(gen); });
+  }
+
+  CheckAllOperators(matrix, 3);
+}
+
+TEST(Parallel_Operations_MPI, Test_Reduce_Fewer_Rows_Than_Processes) {
+  int rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  Matrix<float> matrix;
+
+  if (rank == 0) {
+    matrix = GetRandomMatrix<float>(2, 50, random_0_to_99);
+  }
+
+  CheckAllOperators(matrix, 4);
+}
+
+TEST(Parallel_Operations_MPI, Test_Reduce_Sum_Does_Not_Overflow) {
+  int rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  Matrix<int> matrix;
+
+  if (rank == 0) {
+    matrix = GetRandomMatrix<int>(3, 4, []() { return 2000000000; });
+  }
+
+  auto sums = ReduceParallel<ReduceOp::Sum>(matrix, Axis::All);
+
+  if (rank == 0) {
+    ASSERT_EQ(1u, sums.size());
+    ASSERT_EQ(24000000000LL, sums[0]);
+  }
+}
+
+TEST(Parallel_Operations_MPI, Test_Reduce_Empty_Matrix) {
+  int rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  Matrix<int> matrix;
+
+  auto result = ReduceParallel<ReduceOp::Max>(matrix, Axis::Cols);
+
+  ASSERT_TRUE(result.empty());
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   MPI_Init(&argc, &argv);
@@ -0,0 +1,434 @@
+// Copyright 2022 Kandrin Alexey
+#ifndef MODULES_TASK_1_KANDRIN_A_MIN_VALUE_BY_ROWS_REDUCTION_H_
+#define MODULES_TASK_1_KANDRIN_A_MIN_VALUE_BY_ROWS_REDUCTION_H_
+
+#include <mpi.h>
+#include <algorithm>
+#include <thread>  // NOLINT [build/c++11]
+#include <type_traits>
+#include <vector>
+#include "../../../modules/task_1/kandrin_a_min_value_by_rows/min_value_by_rows.h"
+
+//=============================================================================
+// Enum    : Axis
+// Purpose : What the reduction runs along: every row gives one value, every
+//           column gives one value, or the whole matrix gives one value.
+//=============================================================================
+enum class Axis { Rows, Cols, All };
+
+//=============================================================================
+// Enum    : ReduceOp
+// Purpose : Reduction operator. ArgMin and ArgMax return the index of the
+//           first extremum: the column for Axis::Rows, the row for
+//           Axis::Cols and the flat row-major index for Axis::All.
+//=============================================================================
+enum class ReduceOp { Min, Max, Sum, ArgMin, ArgMax, Mean };
+
+//=============================================================================
+// Class   : MpiType
+// Purpose : MPI datatype of an element type.
+//=============================================================================
+template <class T>
+struct MpiType;
+
+template <>
+struct MpiType<int> {
+  static MPI_Datatype Get() { return MPI_INT; }
+};
+
+template <>
+struct MpiType<unsigned int> {
+  static MPI_Datatype Get() { return MPI_UNSIGNED; }
+};
+
+template <>
+struct MpiType<long> {  // NOLINT [runtime/int]
+  static MPI_Datatype Get() { return MPI_LONG; }
+};
+
+template <>
+struct MpiType<unsigned long> {  // NOLINT [runtime/int]
+  static MPI_Datatype Get() { return MPI_UNSIGNED_LONG; }
+};
+
+template <>
+struct MpiType<long long> {  // NOLINT [runtime/int]
+  static MPI_Datatype Get() { return MPI_LONG_LONG; }
+};
+
+template <>
+struct MpiType<unsigned long long> {  // NOLINT [runtime/int]
+  static MPI_Datatype Get() { return MPI_UNSIGNED_LONG_LONG; }
+};
+
+template <>
+struct MpiType<float> {
+  static MPI_Datatype Get() { return MPI_FLOAT; }
+};
+
+template <>
+struct MpiType<double> {
+  static MPI_Datatype Get() { return MPI_DOUBLE; }
+};
+
+// Index of an arg-reduction.
+using ReduceIndex = long long;  // NOLINT [runtime/int]
+
+//=============================================================================
+// Class   : ReduceKernel
+// Purpose : Accumulator type and inner loops of one operator. The loops run
+//           over contiguous memory without branches (except the arg
+//           updates), so the compiler turns them into SIMD code.
+//=============================================================================
+template <ReduceOp Op, class T>
+struct ReduceKernel {
+  static constexpr bool kIsArg =
+      Op == ReduceOp::ArgMin || Op == ReduceOp::ArgMax;
+  static constexpr bool kIsSum = Op == ReduceOp::Sum || Op == ReduceOp::Mean;
+  static constexpr bool kIsMin = Op == ReduceOp::Min || Op == ReduceOp::ArgMin;
+
+  // Integers are summed in 64 bits, floating point values in double.
+  using SignedSum = long long;             // NOLINT [runtime/int]
+  using UnsignedSum = unsigned long long;  // NOLINT [runtime/int]
+  using SumType = typename std::conditional<
+      std::is_floating_point<T>::value, double,
+      typename std::conditional<std::is_signed<T>::value, SignedSum,
+                                UnsignedSum>::type>::type;
+  using Acc = typename std::conditional<kIsSum, SumType, T>::type;
+  using Result = typename std::conditional<
+      kIsArg, ReduceIndex,
+      typename std::conditional<Op == ReduceOp::Mean, double, Acc>::type>::type;
+
+  // true if a replaces b: strictly smaller for min, strictly greater for max.
+  static bool Better(Acc a, Acc b) { return kIsMin ? a < b : b < a; }
+
+  static Acc Combine(Acc a, Acc b) {
+    return kIsSum ? a + b : (Better(b, a) ? b : a);
+  }
+
+  // Reduces a contiguous span. index is the position of the first extremum.
+  static void ReduceSpan(const T* data, size_t size, Acc* value,
+                         ReduceIndex* index) {
+    *index = 0;
+    if (kIsSum) {
+      // four independent sums break the dependency chain of the additions
+      Acc partial[4] = {0, 0, 0, 0};
+      size_t i = 0;
+      for (; i + 4 <= size; i += 4) {
+        partial[0] += data[i];
+        partial[1] += data[i + 1];
+        partial[2] += data[i + 2];
+        partial[3] += data[i + 3];
+      }
+      for (; i < size; ++i) {
+        partial[0] += data[i];
+      }
+      *value = (partial[0] + partial[1]) + (partial[2] + partial[3]);
+      return;
+    }
+    Acc best = data[0];
+    for (size_t i = 1; i < size; ++i) {
+      best = Combine(best, data[i]);
+    }
+    *value = best;
+    if (kIsArg) {
+      // the second pass finds the first position of the extremum
+      *index = std::find(data, data + size, static_cast<T>(best)) - data;
+    }
+  }
+
+  // Adds one row of the matrix to the column accumulators.
+  static void AccumulateRow(const T* row, size_t size, ReduceIndex rowIndex,
+                            Acc* values, ReduceIndex* indices) {
+    if (kIsArg) {
+      for (size_t j = 0; j < size; ++j) {
+        if (Better(row[j], values[j])) {
+          values[j] = row[j];
+          indices[j] = rowIndex;
+        }
+      }
+    } else {
+      for (size_t j = 0; j < size; ++j) {
+        values[j] = Combine(values[j], row[j]);
+      }
+    }
+  }
+
+  static Result Finish(Acc value, ReduceIndex index, size_t count) {
+    if (kIsArg) {
+      return static_cast<Result>(index);
+    }
+    if (Op == ReduceOp::Mean) {
+      return static_cast<Result>(static_cast<double>(value) / count);
+    }
+    return static_cast<Result>(value);
+  }
+};
+
+//=============================================================================
+// Class   : ReducePartial
+// Purpose : Accumulators of a part of the matrix: one per row, per column or
+//           a single one, and how many elements every accumulator has seen.
+//=============================================================================
+template <ReduceOp Op, class T>
+struct ReducePartial {
+  using Kernel = ReduceKernel<Op, T>;
+
+  std::vector<typename Kernel::Acc> values;
+  std::vector<ReduceIndex> indices;
+  size_t count{0};
+
+  // Merges the partial of the rows that follow this one.
+  void Merge(const ReducePartial& next) {
+    if (next.count == 0) {
+      return;
+    }
+    if (count == 0) {
+      *this = next;
+      return;
+    }
+    for (size_t j = 0; j < values.size(); ++j) {
+      if (Kernel::kIsArg) {
+        if (Kernel::Better(next.values[j], values[j])) {
+          values[j] = next.values[j];
+          indices[j] = next.indices[j];
+        }
+      } else {
+        values[j] = Kernel::Combine(values[j], next.values[j]);
+      }
+    }
+    count += next.count;
+  }
+};
+
+//=============================================================================
+// Function : ReduceBlock
+// Purpose  : Reduces rowCount rows of a row-major block that start at row
+//            firstRow of the whole matrix. For Axis::Rows the partial holds
+//            the rows of the block, otherwise it can be merged with the
+//            partials of the other blocks.
+//=============================================================================
+template <ReduceOp Op, class T>
+ReducePartial<Op, T> ReduceBlock(const T* data, size_t rowCount,
+                                 size_t colCount, size_t firstRow, Axis axis) {
+  using Kernel = ReduceKernel<Op, T>;
+  ReducePartial<Op, T> partial;
+
+  if (axis == Axis::Rows) {
+    if (colCount == 0) {
+      return partial;
+    }
+    partial.values.resize(rowCount);
+    partial.indices.resize(rowCount);
+    partial.count = colCount;
+    for (size_t i = 0; i < rowCount; ++i) {
+      Kernel::ReduceSpan(data + i * colCount, colCount, &partial.values[i],
+                         &partial.indices[i]);
+    }
+    return partial;
+  }
+
+  size_t width = axis == Axis::Cols ? colCount : 1;
+  partial.values.resize(width);
+  partial.indices.resize(width);
+  if (rowCount == 0 || colCount == 0) {
+    return partial;
+  }
+  partial.count = axis == Axis::Cols ? rowCount : rowCount * colCount;
+
+  if (axis == Axis::Cols) {
+    // columns are accumulated row by row, the matrix is read once in order
+    std::copy(data, data + colCount, partial.values.begin());
+    std::fill(partial.indices.begin(), partial.indices.end(), firstRow);
+    for (size_t i = 1; i < rowCount; ++i) {
+      Kernel::AccumulateRow(data + i * colCount, colCount, firstRow + i,
+                            partial.values.data(), partial.indices.data());
+    }
+  } else {
+    Kernel::ReduceSpan(data, rowCount * colCount, &partial.values[0],
+                       &partial.indices[0]);
+    partial.indices[0] += firstRow * colCount;
+  }
+  return partial;
+}
+
+//=============================================================================
+// Function : ReduceBlockThreaded
+// Purpose  : Same as ReduceBlock, the rows are split between threadCount
+//            threads by WorkSplitter and the partials are merged in order.
+//=============================================================================
+template <ReduceOp Op, class T>
+ReducePartial<Op, T> ReduceBlockThreaded(const T* data, size_t rowCount,
+                                         size_t colCount, size_t firstRow,
+                                         Axis axis, size_t threadCount) {
+  threadCount = std::max<size_t>(1, std::min(threadCount, rowCount));
+  if (threadCount == 1) {
+    return ReduceBlock<Op>(data, rowCount, colCount, firstRow, axis);
+  }
+
+  WorkSplitter workSplitter(rowCount, threadCount);
+  std::vector<ReducePartial<Op, T>> partials(threadCount);
+  std::vector<std::thread> threads;
+  size_t row = 0;
+  for (size_t thread = 0; thread < threadCount; ++thread) {
+    size_t rows = workSplitter.GetPartWork(thread);
+    threads.emplace_back([&partials, data, rows, colCount, firstRow, axis,
+                          row, thread]() {
+      partials[thread] = ReduceBlock<Op>(data + row * colCount, rows, colCount,
+                                         firstRow + row, axis);
+    });
+    row += rows;
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  ReducePartial<Op, T> result = partials[0];
+  for (size_t thread = 1; thread < threadCount; ++thread) {
+    if (axis == Axis::Rows) {
+      result.values.insert(result.values.end(), partials[thread].values.begin(),
+                           partials[thread].values.end());
+      result.indices.insert(result.indices.end(),
+                            partials[thread].indices.begin(),
+                            partials[thread].indices.end());
+    } else {
+      result.Merge(partials[thread]);
+    }
+  }
+  return result;
+}
+
+//=============================================================================
+// Function : FinishReduce
+// Purpose  : Converts accumulators into the results of the operator.
+//=============================================================================
+template <ReduceOp Op, class T>
+std::vector<typename ReduceKernel<Op, T>::Result> FinishReduce(
+    const ReducePartial<Op, T>& partial) {
+  std::vector<typename ReduceKernel<Op, T>::Result> result;
+  if (partial.count == 0) {
+    return result;
+  }
+  result.resize(partial.values.size());
+  for (size_t j = 0; j < result.size(); ++j) {
+    result[j] = ReduceKernel<Op, T>::Finish(partial.values[j],
+                                            partial.indices[j], partial.count);
+  }
+  return result;
+}
+
+//=============================================================================
+// Function : Reduce
+// Purpose  : Sequential reduction of the matrix along axis with operator Op.
+//            The result has one value per row, per column, or one value for
+//            Axis::All; an empty matrix gives an empty result.
+//=============================================================================
+template <ReduceOp Op, class T>
+std::vector<typename ReduceKernel<Op, T>::Result> Reduce(
+    const Matrix<T>& matrix, Axis axis, size_t threadCount = 1) {
+  const T* data = matrix[0];
+  return FinishReduce(ReduceBlockThreaded<Op>(data, matrix.GetRowCount(),
+                                              matrix.GetColCount(), 0, axis,
+                                              threadCount));
+}
+
+//=============================================================================
+// Function : ReduceParallel
+// Purpose  : Same as Reduce, the matrix of the null process is split into row
+//            blocks by WorkSplitter and sent with MPI_Scatterv; each process
+//            reduces its block with threadCount threads. The result is
+//            returned by the null process.
+//=============================================================================
+template <ReduceOp Op, class T>
+std::vector<typename ReduceKernel<Op, T>::Result> ReduceParallel(
+    const Matrix<T>& matrix, Axis axis, size_t threadCount = 1) {
+  using Acc = typename ReduceKernel<Op, T>::Acc;
+
+  int mpiReturnValue = 0;
+  MPI_Comm_size(MPI_COMM_WORLD, &mpiReturnValue);
+  size_t proccessCount = static_cast<size_t>(mpiReturnValue);
+
+  MPI_Comm_rank(MPI_COMM_WORLD, &mpiReturnValue);
+  size_t rank = static_cast<size_t>(mpiReturnValue);
+
+  size_t sizes[2] = {matrix.GetRowCount(), matrix.GetColCount()};
+  MPI_Bcast(sizes, 2, MPI_UNSIGNED_LONG, 0, MPI_COMM_WORLD);
+  size_t rowCount = sizes[0], colCount = sizes[1];
+
+  WorkSplitter workSplitter(rowCount, proccessCount);
+  std::vector<int> sendCounts(proccessCount), sendDispls(proccessCount);
+  std::vector<size_t> firstRows(proccessCount);
+  size_t row = 0;
+  for (size_t proccess = 0; proccess < proccessCount; ++proccess) {
+    firstRows[proccess] = row;
+    sendCounts[proccess] =
+        static_cast<int>(workSplitter.GetPartWork(proccess) * colCount);
+    sendDispls[proccess] = static_cast<int>(row * colCount);
+    row += workSplitter.GetPartWork(proccess);
+  }
+
+  size_t localRows = workSplitter.GetPartWork(rank);
+  Matrix<T> localMatrix(localRows, colCount);
+  const T* sendPtr = rank == 0 ? matrix[0] : nullptr;
+  MPI_Scatterv(sendPtr, sendCounts.data(), sendDispls.data(),
+               MpiType<T>::Get(), localMatrix.data(), sendCounts[rank],
+               MpiType<T>::Get(), 0, MPI_COMM_WORLD);
+
+  ReducePartial<Op, T> local = ReduceBlockThreaded<Op>(
+      localMatrix.data(), localRows, colCount, firstRows[rank], axis,
+      threadCount);
+
+  // Axis::Rows gathers the results of the rows, the other axes gather one
+  // partial of every process and merge them in the order of the rows.
+  std::vector<int> recvCounts(proccessCount), recvDispls(proccessCount);
+  std::vector<unsigned long> counts(proccessCount);  // NOLINT [runtime/int]
+  unsigned long localCount = local.count;  // NOLINT [runtime/int]
+  MPI_Gather(&localCount, 1, MPI_UNSIGNED_LONG, counts.data(), 1,
+             MPI_UNSIGNED_LONG, 0, MPI_COMM_WORLD);
+  int offset = 0;
+  for (size_t proccess = 0; proccess < proccessCount; ++proccess) {
+    if (axis == Axis::Rows) {
+      size_t rows = colCount == 0 ? 0 : workSplitter.GetPartWork(proccess);
+      recvCounts[proccess] = static_cast<int>(rows);
+    } else {
+      recvCounts[proccess] = static_cast<int>(local.values.size());
+    }
+    recvDispls[proccess] = offset;
+    offset += recvCounts[proccess];
+  }
+
+  std::vector<Acc> values(rank == 0 ? offset : 0);
+  std::vector<ReduceIndex> indices(rank == 0 ? offset : 0);
+  MPI_Gatherv(local.values.data(), static_cast<int>(local.values.size()),
+              MpiType<Acc>::Get(), values.data(), recvCounts.data(),
+              recvDispls.data(), MpiType<Acc>::Get(), 0, MPI_COMM_WORLD);
+  MPI_Gatherv(local.indices.data(), static_cast<int>(local.indices.size()),
+              MPI_LONG_LONG, indices.data(), recvCounts.data(),
+              recvDispls.data(), MPI_LONG_LONG, 0, MPI_COMM_WORLD);
+
+  if (rank != 0) {
+    return {};
+  }
+
+  ReducePartial<Op, T> global;
+  if (axis == Axis::Rows) {
+    global.values = values;
+    global.indices = indices;
+    global.count = colCount;
+  } else {
+    for (size_t proccess = 0; proccess < proccessCount; ++proccess) {
+      ReducePartial<Op, T> partial;
+      partial.values.assign(values.begin() + recvDispls[proccess],
+                            values.begin() + recvDispls[proccess] +
+                                recvCounts[proccess]);
+      partial.indices.assign(indices.begin() + recvDispls[proccess],
+                             indices.begin() + recvDispls[proccess] +
+                                 recvCounts[proccess]);
+      partial.count = counts[proccess];
+      global.Merge(partial);
+    }
+  }
+  return FinishReduce(global);
+}
+
+#endif  // MODULES_TASK_1_KANDRIN_A_MIN_VALUE_BY_ROWS_REDUCTION_H_
@@ -120,6 +120,56 @@ TEST(matrix_column_min, test4) {
   }
 }
 
+TEST(matrix_column_min, more_processes_than_columns) {
+  int rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  std::vector<int> matrix;
+  int n = 1000;
+  int m = 3;
+  if (rank == 0) {
+    matrix = generateMatrix(n, m);
+  }
+
+  std::vector<int> paralelRes = getColumnMinParalel(matrix, n, m);
+
+  if (rank == 0) {
+    std::vector<int> check(m);
+    std::vector<int> t = transposeMatrix(matrix, n, m);
+
+    for (int i = 0; i < m; i++) {
+      check[i] = getMinInSequence(std::vector<int>(t.begin() + i*n, t.begin() + i*n + n));
+    }
+
+    ASSERT_EQ(check, paralelRes);
+    ASSERT_EQ(check, getRowsMin(matrix.data(), n, m));
+  }
+}
+
+TEST(matrix_column_min, scatter_keeps_rows) {
+  int rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  std::vector<int> matrix;
+  int n = 4;
+  int m = 9;
+  if (rank == 0) {
+    for (int i = 0; i < n * m; i++) {
+      matrix.push_back(i);
+    }
+  }
+
+  std::vector<int> counts, displs;
+  std::vector<int> part = scatterColumns(matrix, n, m, &counts, &displs);
+
+  ASSERT_EQ(n * counts[rank], static_cast<int>(part.size()));
+  for (int i = 0; i < n; i++) {
+    for (int j = 0; j < counts[rank]; j++) {
+      ASSERT_EQ(i * m + displs[rank] + j, part[i * counts[rank] + j]);
+    }
+  }
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   MPI_Init(&argc, &argv);
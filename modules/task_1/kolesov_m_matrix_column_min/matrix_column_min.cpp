@@ -1,5 +1,6 @@
 // Copyright 2022 Kolesov Maxim
 #include <mpi.h>
+#include <algorithm>
 #include <random>
 #include <limits>
 
@@ -41,53 +42,66 @@ int getMinInSequence(const std::vector<int> &sec) {
   return min;
 }
 
-std::vector<int> getColumnMinParalel(const std::vector<int> &matrix, int n, int m) {
+std::vector<int> getRowsMin(const int *block, int n, int m) {
+  std::vector<int> res(m, std::numeric_limits<int>::max());
+  // row by row, so the inner loop is a vectorizable min over contiguous ints
+  for (int i = 0; i < n; i++) {
+    const int *row = block + i * m;
+    for (int j = 0; j < m; j++) {
+      res[j] = std::min(res[j], row[j]);
+    }
+  }
+
+  return res;
+}
+
+std::vector<int> scatterColumns(const std::vector<int> &matrix, int n, int m,
+                                std::vector<int> *counts, std::vector<int> *displs) {
   int size, rank;
   MPI_Comm_size(MPI_COMM_WORLD, &size);
   MPI_Comm_rank(MPI_COMM_WORLD, &rank);
 
-  const int delta = n;
-  const int count = m / size;
-  const int remain = m % size;
-  int start = 0;
-
-  std::vector<int> part(delta*count);
-  std::vector<int> end(delta*remain);
-  std::vector<int> localResult(m, std::numeric_limits<int>::max());
-  std::vector<int> globalResult(m);
-
-  if (rank == 0) {
-    std::vector<int> t = transposeMatrix(matrix, n, m);
-    start = count;
-    for (int i = 1; i < size; i++) {
-      MPI_Send(&start, 1, MPI_INT, i, 0, MPI_COMM_WORLD);
-      MPI_Send(t.data() + count * i * delta, delta * count, MPI_INT, i, 0, MPI_COMM_WORLD);
-      start += count;
-    }
-
-    start = 0;
-
-    part = std::vector<int>(t.begin(), t.begin() + delta * count);
-    if (remain != 0) {
-      end = std::vector<int>(t.end() - remain*delta, t.end());
-    }
-  } else {
-    MPI_Status status;
-    MPI_Recv(&start, 1, MPI_INT, 0, 0, MPI_COMM_WORLD, &status);
-    MPI_Recv(part.data(), delta*count, MPI_INT, 0, 0, MPI_COMM_WORLD, &status);
+  counts->resize(size);
+  displs->resize(size);
+  for (int i = 0; i < size; i++) {
+    (*displs)[i] = m / size * i + std::min(i, m % size);
+    (*counts)[i] = m / size + (i < m % size ? 1 : 0);
   }
+  const int count = (*counts)[rank];
+
+  // a column of the n x m matrix resized to one int, so column j starts at displacement j
+  MPI_Datatype column, columnType;
+  MPI_Type_vector(n, 1, m, MPI_INT, &column);
+  MPI_Type_create_resized(column, 0, sizeof(int), &columnType);
+  MPI_Type_commit(&columnType);
+
+  // the same for the local n x count block, which stays row-major
+  MPI_Datatype part, partType;
+  MPI_Type_vector(n, 1, std::max(count, 1), MPI_INT, &part);
+  MPI_Type_create_resized(part, 0, sizeof(int), &partType);
+  MPI_Type_commit(&partType);
+
+  std::vector<int> block(n * count);
+  MPI_Scatterv(rank == 0 ? matrix.data() : nullptr, counts->data(), displs->data(), columnType,
+               block.data(), count, partType, 0, MPI_COMM_WORLD);
+
+  MPI_Type_free(&column);
+  MPI_Type_free(&columnType);
+  MPI_Type_free(&part);
+  MPI_Type_free(&partType);
+  return block;
+}
 
-  for (int i = 0; i < count; i++) {
-    localResult[start + i] = getMinInSequence(std::vector<int>(part.begin() + i*delta, part.begin() + i*delta + delta));
-  }
+std::vector<int> getColumnMinParalel(const std::vector<int> &matrix, int n, int m) {
+  int rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
 
-  if (rank == 0 && remain != 0) {
-    start = m - remain;
-    for (int i = 0; i < remain; i++) {
-      localResult[start + i] = getMinInSequence(std::vector<int>(end.begin() + i*delta, end.begin() + i*delta + delta));
-    }
-  }
+  std::vector<int> counts, displs;
+  std::vector<int> part = scatterColumns(matrix, n, m, &counts, &displs);
+  std::vector<int> localResult = getRowsMin(part.data(), n, counts[rank]);
 
-  MPI_Reduce(localResult.data(), globalResult.data(), m, MPI_INT, MPI_MIN, 0, MPI_COMM_WORLD);
+  std::vector<int> globalResult(m);
+  MPI_Gatherv(localResult.data(), counts[rank], MPI_INT, globalResult.data(), counts.data(), displs.data(),
+              MPI_INT, 0, MPI_COMM_WORLD);
   return globalResult;
 }
@@ -7,4 +7,10 @@ std::vector<int> generateMatrix(int n, int m);
 std::vector<int> transposeMatrix(const std::vector<int> &matrix, int n, int m);
 
 int getMinInSequence(const std::vector<int> &sec);
+// Minimum of every column of a row-major n x m block in one pass over its rows.
+std::vector<int> getRowsMin(const int *block, int n, int m);
+// Scatters column blocks of the row-major matrix on rank 0 without transposing it;
+// every process gets its n x counts[rank] block in row-major order.
+std::vector<int> scatterColumns(const std::vector<int> &matrix, int n, int m,
+                                std::vector<int> *counts, std::vector<int> *displs);
 std::vector<int> getColumnMinParalel(const std::vector<int> &matrix, int n, int m);
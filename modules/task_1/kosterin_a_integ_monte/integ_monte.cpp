@@ -1,43 +1,175 @@
 // Copyright 2022 Kosterin Alexey
 #include <mpi.h>
-#include <random>
+#include <algorithm>
+#include <vector>
 
 #include "../../../modules/task_1/kosterin_a_integ_monte/integ_monte.h"
 
-double monteCarlo(int low, int high, int count, double (*f)(double)) {
-  std::random_device dev;
-  std::mt19937 gen(dev());
-  std::uniform_real_distribution<> distx(low, high);
+namespace {
+
+const double kTwoPow53 = 9007199254740992.0;
+const double kTwoPow32 = 4294967296.0;
+
+double toUnit(uint32_t hi, uint32_t lo) {
+  uint64_t bits = (static_cast<uint64_t>(hi) << 32) | lo;
+  return static_cast<double>(bits >> 11) / kTwoPow53;
+}
+
+uint32_t reverseBits(uint32_t x) {
+  x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+  x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+  x = ((x >> 4) & 0x0F0F0F0Fu) | ((x & 0x0F0F0F0Fu) << 4);
+  x = ((x >> 8) & 0x00FF00FFu) | ((x & 0x00FF00FFu) << 8);
+  return (x >> 16) | (x << 16);
+}
+
+// Laine-Karras hash, scrambles the reversed bits like a nested permutation
+uint32_t laineKarras(uint32_t x, uint32_t seed) {
+  x += seed;
+  x ^= x * 0x6c50b47cu;
+  x ^= x * 0xb82f1e52u;
+  x ^= x * 0xc7afe638u;
+  x ^= x * 0x8d22f6e6u;
+  return x;
+}
+
+void chunkBounds(int chunks, int size, int rank, int* first, int* last) {
+  *first = static_cast<int>(static_cast<int64_t>(chunks) * rank / size);
+  *last = static_cast<int>(static_cast<int64_t>(chunks) * (rank + 1) / size);
+}
+
+double chunkSum(double low, double high, int chunk, int count,
+                double (*f)(double), uint64_t seed) {
+  double x[kBatch];
+  double sum = 0;
+  int last = std::min((chunk + 1) * kChunk, count);
+  for (int first = chunk * kChunk; first < last; first += kBatch) {
+    int n = std::min(kBatch, last - first);
+    sobolPoints(seed, first, n, x);
+    for (int i = 0; i < n; i++) sum += f(low + (high - low) * x[i]);
+  }
+  return sum;
+}
+
+}  // namespace
+
+void philox4x32(const uint32_t counter[4], const uint32_t key[2],
+                uint32_t out[4]) {
+  uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+  uint32_t k0 = key[0], k1 = key[1];
+  for (int round = 0; round < 10; round++) {
+    uint64_t p0 = static_cast<uint64_t>(0xD2511F53u) * c0;
+    uint64_t p1 = static_cast<uint64_t>(0xCD9E8D57u) * c2;
+    c0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+    c1 = static_cast<uint32_t>(p1);
+    c2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+    c3 = static_cast<uint32_t>(p0);
+    k0 += 0x9E3779B9u;
+    k1 += 0xBB67AE85u;
+  }
+  out[0] = c0;
+  out[1] = c1;
+  out[2] = c2;
+  out[3] = c3;
+}
+
+void philoxPoints(uint64_t seed, int64_t first, int count, double* x,
+                  double* y) {
+  const uint32_t key[2] = {static_cast<uint32_t>(seed),
+                           static_cast<uint32_t>(seed >> 32)};
+  uint32_t counter[4] = {0, 0, 0, 0};
+  uint32_t r[4];
+  for (int i = 0; i < count; i++) {
+    uint64_t index = first + i;
+    counter[0] = static_cast<uint32_t>(index);
+    counter[1] = static_cast<uint32_t>(index >> 32);
+    philox4x32(counter, key, r);
+    x[i] = toUnit(r[0], r[1]);
+    y[i] = toUnit(r[2], r[3]);
+  }
+}
+
+void sobolPoints(uint64_t seed, int64_t first, int count, double* x) {
+  // the first Sobol dimension is van der Corput: point i is reverse(i), and
+  // scrambling its reversed bits gives reverse(scramble(i))
+  const uint32_t key[2] = {static_cast<uint32_t>(seed),
+                           static_cast<uint32_t>(seed >> 32)};
+  const uint32_t counter[4] = {0, 0, 0, 1};
+  uint32_t r[4];
+  philox4x32(counter, key, r);
+  for (int i = 0; i < count; i++) {
+    uint32_t index = static_cast<uint32_t>(first + i);
+    x[i] = (reverseBits(laineKarras(index, r[0])) + 0.5) / kTwoPow32;
+  }
+}
+
+double monteCarlo(int low, int high, int count, double (*f)(double),
+                  uint64_t seed) {
   int size, rank;
   MPI_Comm_rank(MPI_COMM_WORLD, &rank);
   MPI_Comm_size(MPI_COMM_WORLD, &size);
-  int delta = count / size;
-  int ibeg = rank * delta + 1;
-  int iend = (rank + 1) * delta;
-  double res;
-  float x, y;
-  double iter, res1;
+  int64_t ibeg = static_cast<int64_t>(count) * rank / size;
+  int64_t iend = static_cast<int64_t>(count) * (rank + 1) / size;
+  double iter;
   double d = f(low);
   for (iter = low; iter <= high; iter += (high - low) / 500.0) {
     // if (f(iter) < c)  c = f(iter);
     if (f(iter) > d)
       d = f(iter);
   }
-  std::uniform_real_distribution<> disty(0, d);
-
-  MPI_Bcast(&count, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
-  double sum = 0;
 
-  for (int i = ibeg; i < iend; i++) {
-    x = distx(gen);
-    y = disty(gen);
-    if (y <= f(x)) {
-      sum++;
+  // hits are counted as integers, so any split of the points gives the same
+  // total and the result does not depend on the number of processes
+  double x[kBatch], y[kBatch];
+  int64_t sum = 0;
+  for (int64_t first = ibeg; first < iend; first += kBatch) {
+    int n = static_cast<int>(std::min<int64_t>(kBatch, iend - first));
+    philoxPoints(seed, first, n, x, y);
+    for (int i = 0; i < n; i++) {
+      if (d * y[i] <= f(low + (high - low) * x[i])) {
+        sum++;
+      }
     }
   }
-  double localSum = sum * (high - low) * d / (iend - ibeg);
-  MPI_Reduce(&localSum, &res, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+  int64_t res;
+  MPI_Allreduce(&sum, &res, 1, MPI_INT64_T, MPI_SUM, MPI_COMM_WORLD);
+
+  return static_cast<double>(res) * (high - low) * d / count;
+}
 
-  res = localSum;
-  return res;
+double quasiMonteCarlo(double low, double high, int count, double (*f)(double),
+                       uint64_t seed) {
+  int size, rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &size);
+  int chunks = (count + kChunk - 1) / kChunk;
+
+  std::vector<int> counts(size), displs(size);
+  for (int i = 0; i < size; i++) {
+    int first, last;
+    chunkBounds(chunks, size, i, &first, &last);
+    displs[i] = first;
+    counts[i] = last - first;
+  }
+
+  std::vector<double> local(counts[rank]);
+  for (int i = 0; i < counts[rank]; i++)
+    local[i] = chunkSum(low, high, displs[rank] + i, count, f, seed);
+
+  // the chunk sums are added in the same order for any number of processes
+  std::vector<double> sums(chunks);
+  MPI_Allgatherv(local.data(), counts[rank], MPI_DOUBLE, sums.data(),
+                 counts.data(), displs.data(), MPI_DOUBLE, MPI_COMM_WORLD);
+  double sum = 0;
+  for (int i = 0; i < chunks; i++) sum += sums[i];
+  return sum / count * (high - low);
+}
+
+double quasiMonteCarloSequential(double low, double high, int count,
+                                 double (*f)(double), uint64_t seed) {
+  int chunks = (count + kChunk - 1) / kChunk;
+  double sum = 0;
+  for (int i = 0; i < chunks; i++)
+    sum += chunkSum(low, high, i, count, f, seed);
+  return sum / count * (high - low);
 }
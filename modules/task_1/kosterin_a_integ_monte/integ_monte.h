@@ -2,6 +2,30 @@
 #ifndef MODULES_TASK_1_KOSTERIN_A_INTEG_MONTE_INTEG_MONTE_H_
 #define MODULES_TASK_1_KOSTERIN_A_INTEG_MONTE_INTEG_MONTE_H_
 
-double monteCarlo(int low, int high, int count, double (*f)(double));
+#include <cstdint>
+
+const uint64_t kDefaultSeed = 0x9E3779B97F4A7C15ull;
+// points generated at once before f is called on them
+const int kBatch = 1 << 10;
+// quasi Monte Carlo sums are combined per chunk of kChunk points
+const int kChunk = 1 << 12;
+
+// Philox4x32-10: the same counter and key always give the same four words.
+void philox4x32(const uint32_t counter[4], const uint32_t key[2], uint32_t out[4]);
+
+// Point i of a seed is philox4x32(i, seed), so every rank and thread can
+// generate its own points without sharing a generator state.
+void philoxPoints(uint64_t seed, int64_t first, int count, double* x,
+                  double* y);
+// Owen-scrambled Sobol points first .. first + count - 1 in (0, 1).
+void sobolPoints(uint64_t seed, int64_t first, int count, double* x);
+
+double monteCarlo(int low, int high, int count, double (*f)(double),
+                  uint64_t seed = kDefaultSeed);
+double quasiMonteCarlo(double low, double high, int count, double (*f)(double),
+                       uint64_t seed = kDefaultSeed);
+double quasiMonteCarloSequential(double low, double high, int count,
+                                 double (*f)(double),
+                                 uint64_t seed = kDefaultSeed);
 
 #endif  // MODULES_TASK_1_KOSTERIN_A_INTEG_MONTE_INTEG_MONTE_H_
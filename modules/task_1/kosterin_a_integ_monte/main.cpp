@@ -1,5 +1,6 @@
 // Copyright 2022 Kosterin Alexey
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <cmath>
 #include "./integ_monte.h"
 #include <gtest-mpi-listener.hpp>
@@ -9,6 +10,7 @@ double f2(double x) { return (1 / log(x)); }
 double f3(double x) { return (exp(x) / x); }
 double f4(double x) { return (log(x) + (5 * x)); }
 double f5(double x) { return (exp(x) * pow(x, 2)); }
+double f6(double x) { return (1 - x * x); }
 TEST(Parallel_Operations_MPI, Test_xx) {
   double err = 0.1;
   bool flag = false;
@@ -88,6 +90,55 @@ TEST(Parallel_Operations_MPI, Test_exp) {
   }
 }
 
+TEST(Parallel_Operations_MPI, Test_philox_known_answer) {
+  const uint32_t counter[4] = {0, 0, 0, 0};
+  const uint32_t key[2] = {0, 0};
+  uint32_t out[4];
+  philox4x32(counter, key, out);
+  ASSERT_EQ(0x6627e8d5u, out[0]);
+  ASSERT_EQ(0xe169c58du, out[1]);
+  ASSERT_EQ(0xbc57ac4cu, out[2]);
+  ASSERT_EQ(0x9b00dbd8u, out[3]);
+}
+
+TEST(Parallel_Operations_MPI, Test_reproducible) {
+  int rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  int count = 100003;
+  double res = monteCarlo(0, 1, count, &f6, 5);
+  double quasiRes = quasiMonteCarlo(0, 1, count, &f5, 5);
+  if (rank == 0) {
+    double x[kBatch], y[kBatch];
+    int64_t hits = 0;
+    for (int first = 0; first < count; first += kBatch) {
+      int n = std::min(kBatch, count - first);
+      philoxPoints(5, first, n, x, y);
+      for (int i = 0; i < n; i++)
+        if (y[i] <= f6(x[i])) hits++;
+    }
+    ASSERT_EQ(static_cast<double>(hits) / count, res);
+    ASSERT_EQ(quasiMonteCarloSequential(0, 1, count, &f5, 5), quasiRes);
+  }
+}
+
+TEST(Parallel_Operations_MPI, Test_quasi_exp) {
+  int rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  double res = quasiMonteCarlo(0, 1, 1 << 14, &f5);
+  if (rank == 0) {
+    ASSERT_NEAR(exp(1) - 2, res, 1e-6);
+  }
+}
+
+TEST(Parallel_Operations_MPI, Test_quasi_hard_log) {
+  int rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  double res = quasiMonteCarlo(2, 3, 1 << 14, &f2);
+  if (rank == 0) {
+    ASSERT_NEAR(1.1184248, res, 1e-6);
+  }
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   MPI_Init(&argc, &argv);
@@ -1,5 +1,7 @@
 // Copyright 2022 Kruglikova Valeriia
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <vector>
 #include "./max_columns.h"
 #include <gtest-mpi-listener.hpp>
 
@@ -43,6 +45,44 @@ TEST(Max_Columns, sequental_and_paralles_have_same_answer_size100) {
     }
 }
 
+TEST(Max_Columns, sequental_and_paralles_have_same_answer_tall_matrix) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    std::vector<int> a;
+    if ( rank == 0 ) {
+        a = getMatrix(500, 3);
+    }
+
+    std::vector<int> cmp1 = getParallelMax(a, 500, 3);
+
+    if ( rank == 0 ) {
+        std::vector<int> tmat = getTransposeMtx(a, 500, 3);
+        for (int j = 0; j < 3; j++) {
+            ASSERT_EQ(*std::max_element(tmat.begin() + j*500, tmat.begin() + (j+1)*500), cmp1[j]);
+        }
+    }
+}
+
+TEST(Max_Columns, scatter_gives_row_major_blocks) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    std::vector<int> a;
+    if ( rank == 0 ) {
+        for (int i = 0; i < 2*11; i++)
+            a.push_back(i);
+    }
+
+    std::vector<int> counts, displs;
+    std::vector<int> local = scatterColumnBlocks(a, 2, 11, &counts, &displs);
+
+    ASSERT_EQ(2*counts[rank], static_cast<int>(local.size()));
+    for (int i = 0; i < 2; i++) {
+        for (int j = 0; j < counts[rank]; j++) {
+            ASSERT_EQ(i*11 + displs[rank] + j, local[i*counts[rank] + j]);
+        }
+    }
+}
+
 TEST(Max_Columns, zeroSize_test) {
     int rank;
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
@@ -22,13 +22,59 @@ std::vector<int> getMatrix(int n, int m) {
     return res;
 }
 
+std::vector<int> getRowsMax(const int* block, int n, int m) {
+    if (m == 0)
+        return std::vector<int>();
+    std::vector<int> res(block, block + m);
+    // the rows are contiguous, so the max over a row vectorizes
+    for (int i = 1; i < n; i++) {
+        const int* row = block + i*m;
+        for (int j = 0; j < m; j++)
+            res[j] = std::max(res[j], row[j]);
+    }
+    return res;
+}
+
+std::vector<int> scatterColumnBlocks(const std::vector<int>& mat, int n, int m,
+                                     std::vector<int>* counts, std::vector<int>* displs) {
+    int ProcRank, ProcNum;
+    MPI_Comm_size(MPI_COMM_WORLD, &ProcNum);
+    MPI_Comm_rank(MPI_COMM_WORLD, &ProcRank);
+    counts->resize(ProcNum);
+    displs->resize(ProcNum);
+    for (int prcs = 0; prcs < ProcNum; prcs++) {
+        (*displs)[prcs] = m / ProcNum * prcs + std::min(prcs, m % ProcNum);
+        (*counts)[prcs] = m / ProcNum + (prcs < m % ProcNum ? 1 : 0);
+    }
+    int cols = (*counts)[ProcRank];
+
+    // column of the n x m matrix, resized so that column j starts at displacement j
+    MPI_Datatype col, colType;
+    MPI_Type_vector(n, 1, m, MPI_INT, &col);
+    MPI_Type_create_resized(col, 0, sizeof(int), &colType);
+    MPI_Type_commit(&colType);
+    // column of the local n x cols block, so the block arrives row-major
+    MPI_Datatype localCol, localColType;
+    MPI_Type_vector(n, 1, std::max(cols, 1), MPI_INT, &localCol);
+    MPI_Type_create_resized(localCol, 0, sizeof(int), &localColType);
+    MPI_Type_commit(&localColType);
+
+    std::vector<int> local_vec(cols*n);
+    MPI_Scatterv(ProcRank == 0 ? mat.data() : nullptr, counts->data(), displs->data(), colType,
+                 local_vec.data(), cols, localColType, 0, MPI_COMM_WORLD);
+
+    MPI_Type_free(&col);
+    MPI_Type_free(&colType);
+    MPI_Type_free(&localCol);
+    MPI_Type_free(&localColType);
+    return local_vec;
+}
+
 std::vector<int> getParallelMax(const std::vector<int>& mat, int n, int m) {
     int ProcRank, ProcNum;
     MPI_Comm_size(MPI_COMM_WORLD, &ProcNum);
     MPI_Comm_rank(MPI_COMM_WORLD, &ProcRank);
     int codeErr = 0;
-    int cols_delta = m / ProcNum;
-    int cols_left = m % ProcNum;
 
     if ( ProcRank == 0 ) {
         if (static_cast<int>(mat.size()) != n*m)
@@ -42,61 +88,23 @@ std::vector<int> getParallelMax(const std::vector<int>& mat, int n, int m) {
     }
     if (codeErr == -1)
         throw -1;
-    std::vector<int> local_vec(cols_delta*n);
 
-    if (ProcRank == 0) {
-        std::vector<int> tmat(m*n);
-        tmat = getTransposeMtx(mat, n, m);
-        for (int prcs = 1; prcs < ProcNum; prcs++) {
-            MPI_Send(&tmat[cols_left*n] + cols_delta*prcs*n, cols_delta*n, MPI_INT, prcs, 0, MPI_COMM_WORLD);
-        }
-        local_vec = std::vector<int>(tmat.begin(), tmat.begin() + cols_left*n + cols_delta*n);
-    } else {
-        MPI_Status status;
-        MPI_Recv(&local_vec[0], cols_delta*n, MPI_INT, 0, 0, MPI_COMM_WORLD, &status);
-    }
+    std::vector<int> counts, displs;
+    std::vector<int> local_vec = scatterColumnBlocks(mat, n, m, &counts, &displs);
+    std::vector<int> local_res = getRowsMax(local_vec.data(), n, counts[ProcRank]);
 
     std::vector<int> res;
-
-    if (ProcRank == 0) {
-        MPI_Status status;
-        int elem;
-        std::vector<int> append(n);
-        for (int i = 0; i < cols_delta + cols_left; i++) {
-            auto pos = local_vec.begin() + i*n;
-            std::vector<int> tmp(pos, local_vec.begin() + (i+1)*n);
-            elem = *std::max_element(tmp.begin(), tmp.end());
-            res.push_back(elem);
-        }
-
-        for (int prcs = 1; prcs < ProcNum; prcs++) {
-            MPI_Recv(&append[0], cols_delta, MPI_INT, prcs, 1, MPI_COMM_WORLD, &status);
-            res.insert(res.end(), append.begin(), append.begin()+cols_delta);
-        }
-    } else {
-        int elem;
-        for (int i = 0; i < cols_delta; i++) {
-            auto pos = local_vec.begin() + i*n;
-            std::vector<int> tmp(pos, local_vec.begin() + (i+1)*n);
-            elem = *std::max_element(tmp.begin(), tmp.end());
-            res.push_back(elem);
-        }
-        MPI_Send(&res[0], cols_delta, MPI_INT, 0, 1, MPI_COMM_WORLD);
-    }
+    if (ProcRank == 0)
+        res.resize(m);
+    MPI_Gatherv(local_res.data(), counts[ProcRank], MPI_INT, res.data(), counts.data(), displs.data(),
+                MPI_INT, 0, MPI_COMM_WORLD);
     return res;
 }
 
 std::vector<int> getSequentialMax(const std::vector<int>& mat, int n, int m) {
     if (m*n != static_cast<int>(mat.size()))
         throw -1;
-    std::vector<int> tmat = getTransposeMtx(mat, n, m);
-    std::vector<int> maxes;
-    int max_el;
-    for (int i = 0; i < m; i++) {
-        max_el = *std::max_element(tmat.begin() + i*n, tmat.begin() + (i+1)*n);
-        maxes.push_back(max_el);
-    }
-    return maxes;
+    return getRowsMax(mat.data(), n, m);
 }
 std::vector<int> getTransposeMtx(const std::vector<int>& mat, int n, int m) {
     if (m*n != static_cast<int>(mat.size()))
@@ -9,5 +9,11 @@ std::vector<int> getMatrix(int n, int m);
 std::vector<int> getSequentialMax(const std::vector<int>& mat, int n, int m);
 std::vector<int> getParallelMax(const std::vector<int>& mat, int n, int m);
 std::vector<int> getTransposeMtx(const std::vector<int>& mat, int n, int m);
+// Max of every column of a row-major n x m block, one pass over the rows.
+std::vector<int> getRowsMax(const int* block, int n, int m);
+// Column blocks of the matrix on rank 0 scattered without a transposed copy,
+// each process receives its block row-major.
+std::vector<int> scatterColumnBlocks(const std::vector<int>& mat, int n, int m,
+                                     std::vector<int>* counts, std::vector<int>* displs);
 
 #endif  // MODULES_TASK_1_KRUGLIKOVA_V_COLUMNS_MAX_MAX_COLUMNS_H_
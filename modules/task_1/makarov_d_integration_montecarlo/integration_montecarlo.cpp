@@ -3,10 +3,9 @@
 
 #include <mpi.h>
 
+#include <algorithm>
 #include <cmath>
-#include <ctime>
-#include <iostream>
-#include <random>
+#include <vector>
 
 double function1(double x) { return x / 2; }
 
@@ -16,68 +15,152 @@ double function3(double x) { return sqrt(x); }
 
 double function4(double x) { return sin(x) + 1; }
 
-double notMPIintegration(int N, int a, int b, int h, double (*func)(double)) {
-  if (b < a) throw -1;
-  if (N == 0) throw -1;
+static void philox4x32(uint32_t counter[4], uint32_t k0, uint32_t k1) {
+  for (int round = 0; round < 10; round++) {
+    uint64_t p0 = static_cast<uint64_t>(0xD2511F53u) * counter[0];
+    uint64_t p1 = static_cast<uint64_t>(0xCD9E8D57u) * counter[2];
+    counter[0] = static_cast<uint32_t>(p1 >> 32) ^ counter[1] ^ k0;
+    counter[1] = static_cast<uint32_t>(p1);
+    counter[2] = static_cast<uint32_t>(p0 >> 32) ^ counter[3] ^ k1;
+    counter[3] = static_cast<uint32_t>(p0);
+    k0 += 0x9E3779B9u;
+    k1 += 0xBB67AE85u;
+  }
+}
 
-  double x, y = 0;
-  double result;
-  int cnt = 0;
+static double toUnit(uint32_t hi, uint32_t lo) {
+  uint64_t bits = (static_cast<uint64_t>(hi) << 32) | lo;
+  return static_cast<double>(bits >> 11) / 9007199254740992.0;
+}
 
-  std::mt19937 gen(time(0));
-  std::uniform_real_distribution<> urdx(static_cast<double>(a),
-                                        static_cast<double>(b));
-  std::uniform_real_distribution<> urdy(0., static_cast<double>(h));
+static uint32_t reverseBits(uint32_t x) {
+  x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+  x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+  x = ((x >> 4) & 0x0F0F0F0Fu) | ((x & 0x0F0F0F0Fu) << 4);
+  x = ((x >> 8) & 0x00FF00FFu) | ((x & 0x00FF00FFu) << 8);
+  return (x >> 16) | (x << 16);
+}
+
+void philoxPoints(uint64_t seed, int64_t first, int count, double* x,
+                  double* y) {
+  for (int i = 0; i < count; i++) {
+    uint64_t index = first + i;
+    uint32_t r[4] = {static_cast<uint32_t>(index),
+                     static_cast<uint32_t>(index >> 32), 0, 0};
+    philox4x32(r, static_cast<uint32_t>(seed),
+               static_cast<uint32_t>(seed >> 32));
+    x[i] = toUnit(r[0], r[1]);
+    y[i] = toUnit(r[2], r[3]);
+  }
+}
+
+void sobolPoints(uint64_t seed, int64_t first, int count, double* x) {
+  uint32_t scramble[4] = {0, 0, 0, 1};
+  philox4x32(scramble, static_cast<uint32_t>(seed),
+             static_cast<uint32_t>(seed >> 32));
+  for (int i = 0; i < count; i++) {
+    // point i of the first Sobol dimension is reverse(i); the Laine-Karras
+    // hash of i is an Owen scramble of its reversed bits
+    uint32_t v = static_cast<uint32_t>(first + i) + scramble[0];
+    v ^= v * 0x6c50b47cu;
+    v ^= v * 0xb82f1e52u;
+    v ^= v * 0xc7afe638u;
+    v ^= v * 0x8d22f6e6u;
+    x[i] = (reverseBits(v) + 0.5) / 4294967296.0;
+  }
+}
+
+static int64_t countHits(int64_t first, int64_t last, int a, int b, int h,
+                         double (*func)(double), uint64_t seed) {
+  double x[BatchSize], y[BatchSize];
+  int64_t cnt = 0;
+  for (; first < last; first += BatchSize) {
+    int n = static_cast<int>(std::min<int64_t>(BatchSize, last - first));
+    philoxPoints(seed, first, n, x, y);
+    for (int i = 0; i < n; i++)
+      if (h * y[i] <= func(a + (b - a) * x[i])) cnt++;
+  }
+  return cnt;
+}
 
-  for (int i = 0; i < N; i++) {
-    x = urdx(gen);
-    y = urdy(gen);
-    if (y <= func(x)) cnt++;
+static double chunkSum(int chunk, int N, double a, double b,
+                       double (*func)(double), uint64_t seed) {
+  double x[BatchSize];
+  double sum = 0.;
+  int last = std::min((chunk + 1) * ChunkSize, N);
+  for (int first = chunk * ChunkSize; first < last; first += BatchSize) {
+    int n = std::min(BatchSize, last - first);
+    sobolPoints(seed, first, n, x);
+    for (int i = 0; i < n; i++) sum += func(a + (b - a) * x[i]);
   }
-  result = (cnt / static_cast<double>(N)) * (b - a) * h;
-  // std::cout << "Result is " << result << std::endl;
-  return result;
+  return sum;
 }
 
-double MPIintegration(int N, int a, int b, int h, double (*func)(double)) {
+double notMPIintegration(int N, int a, int b, int h, double (*func)(double),
+                         uint64_t seed) {
   if (b < a) throw -1;
+  if (N <= 0) throw -1;
 
-  double tm;
-  double y, x, result = 0.;
+  int64_t cnt = countHits(0, N, a, b, h, func, seed);
+  return (cnt / static_cast<double>(N)) * (b - a) * h;
+}
 
-  int cntl = 0;
-  int cntg = 0;
+double MPIintegration(int N, int a, int b, int h, double (*func)(double),
+                      uint64_t seed) {
+  if (b < a) throw -1;
+  if (N <= 0) throw -1;
 
   int ProcNum, ProcRank;
   MPI_Comm_size(MPI_COMM_WORLD, &ProcNum);
   MPI_Comm_rank(MPI_COMM_WORLD, &ProcRank);
 
-  tm = MPI_Wtime();
-  MPI_Bcast(&ProcNum, 1, MPI_INT, 0, MPI_COMM_WORLD);
+  // every point index has its own Philox counter, so the hits do not depend
+  // on how the points are split between the processes
+  int64_t first = static_cast<int64_t>(N) * ProcRank / ProcNum;
+  int64_t last = static_cast<int64_t>(N) * (ProcRank + 1) / ProcNum;
+  int64_t cntl = countHits(first, last, a, b, h, func, seed);
+  int64_t cntg = 0;
+  MPI_Allreduce(&cntl, &cntg, 1, MPI_INT64_T, MPI_SUM, MPI_COMM_WORLD);
 
-  int Nlocal = N / ProcNum;
-  if (ProcRank == 0) Nlocal += N % ProcNum;
+  return (cntg / static_cast<double>(N)) * (b - a) * h;
+}
 
-  std::mt19937 gen(time(0) + ProcRank);
-  std::uniform_real_distribution<> urdx(static_cast<double>(a),
-                                        static_cast<double>(b));
-  std::uniform_real_distribution<> urdy(0., static_cast<double>(h));
+double notMPIquasiIntegration(int N, double a, double b,
+                              double (*func)(double), uint64_t seed) {
+  if (b < a) throw -1;
+  if (N <= 0) throw -1;
 
-  for (int i = 1; i < Nlocal; i++) {
-    x = urdx(gen);
-    y = urdy(gen);
-    if (y <= func(x)) cntl++;
-  }
+  int chunks = (N + ChunkSize - 1) / ChunkSize;
+  double sum = 0.;
+  for (int c = 0; c < chunks; c++) sum += chunkSum(c, N, a, b, func, seed);
+  return sum / N * (b - a);
+}
 
-  // std::cout << "Local cnt " << ProcRank << " is " << cntl << std::endl;
-  MPI_Reduce(&cntl, &cntg, 1, MPI_FLOAT, MPI_SUM, 0, MPI_COMM_WORLD);
+double MPIquasiIntegration(int N, double a, double b, double (*func)(double),
+                           uint64_t seed) {
+  if (b < a) throw -1;
+  if (N <= 0) throw -1;
+
+  int ProcNum, ProcRank;
+  MPI_Comm_size(MPI_COMM_WORLD, &ProcNum);
+  MPI_Comm_rank(MPI_COMM_WORLD, &ProcRank);
 
-  if (ProcRank == 0) {
-    result = (cntg / static_cast<double>(N)) * (b - a) * h;
-    // std::cout << "Global cnt is " << cntg << std::endl;
-    // std::cout << "Time is " << MPI_Wtime() - tm << std::endl;
-    // std::cout << "MPI Result is " << result << std::endl;
+  int chunks = (N + ChunkSize - 1) / ChunkSize;
+  std::vector<int> counts(ProcNum), displs(ProcNum);
+  for (int i = 0; i < ProcNum; i++) {
+    displs[i] = static_cast<int>(static_cast<int64_t>(chunks) * i / ProcNum);
+    counts[i] = static_cast<int>(static_cast<int64_t>(chunks) * (i + 1) /
+                                 ProcNum) - displs[i];
   }
 
-  return result;
+  std::vector<double> local(counts[ProcRank]);
+  for (int i = 0; i < counts[ProcRank]; i++)
+    local[i] = chunkSum(displs[ProcRank] + i, N, a, b, func, seed);
+
+  std::vector<double> sums(chunks);
+  MPI_Allgatherv(local.data(), counts[ProcRank], MPI_DOUBLE, sums.data(),
+                 counts.data(), displs.data(), MPI_DOUBLE, MPI_COMM_WORLD);
+  double sum = 0.;
+  for (int c = 0; c < chunks; c++) sum += sums[c];
+  return sum / N * (b - a);
 }
@@ -2,12 +2,36 @@
 #ifndef MODULES_TASK_1_MAKAROV_D_INTEGRATION_MONTECARLO_INTEGRATION_MONTECARLO_H_
 #define MODULES_TASK_1_MAKAROV_D_INTEGRATION_MONTECARLO_INTEGRATION_MONTECARLO_H_
 
+#include <cstdint>
+
+const uint64_t DefaultSeed = 0x9E3779B97F4A7C15ull;
+// points generated at once before func is called on them
+const int BatchSize = 1024;
+// quasi Monte Carlo sums are added per chunk, in the same order on any
+// number of processes
+const int ChunkSize = 4096;
+
 double function1(double x);
 double function2(double x);
 double function3(double x);
 double function4(double x);
 
-double notMPIintegration(int N, int a, int b, int h, double (*func)(double));
-double MPIintegration(int N, int a, int b, int h, double (*func)(double));
+// Point i of a seed is Philox4x32-10 of the counter i, so the points of any
+// process or thread are known without a shared generator state.
+void philoxPoints(uint64_t seed, int64_t first, int count, double* x,
+                  double* y);
+// Owen-scrambled Sobol points first .. first + count - 1 in (0, 1).
+void sobolPoints(uint64_t seed, int64_t first, int count, double* x);
+
+double notMPIintegration(int N, int a, int b, int h, double (*func)(double),
+                         uint64_t seed = DefaultSeed);
+double MPIintegration(int N, int a, int b, int h, double (*func)(double),
+                      uint64_t seed = DefaultSeed);
+
+double notMPIquasiIntegration(int N, double a, double b,
+                              double (*func)(double),
+                              uint64_t seed = DefaultSeed);
+double MPIquasiIntegration(int N, double a, double b, double (*func)(double),
+                           uint64_t seed = DefaultSeed);
 
 #endif  // MODULES_TASK_1_MAKAROV_D_INTEGRATION_MONTECARLO_INTEGRATION_MONTECARLO_H_
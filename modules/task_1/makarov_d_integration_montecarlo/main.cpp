@@ -1,6 +1,8 @@
 // Copyright 2022 Makarov Danila
 #include <gtest/gtest.h>
 
+#include <cmath>
+
 #include <gtest-mpi-listener.hpp>
 
 #include "./integration_montecarlo.h"
@@ -115,6 +117,61 @@ TEST(Integration_montecarlo_throw, test7) {
   ASSERT_ANY_THROW(MPIintegration(N, a, b, h, function3));
 }
 
+TEST(Integration_montecarlo_reproducible, test8) {
+  int ProcRank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &ProcRank);
+  int a, b, h, N;
+  h = 4;
+  a = 0;
+  b = 10;
+  N = 100003;
+
+  double MPI_result = MPIintegration(N, a, b, h, function3, 11);
+  double MPI_quasi_result = MPIquasiIntegration(N, a, b, function3, 11);
+  if (ProcRank == 0) {
+    ASSERT_EQ(notMPIintegration(N, a, b, h, function3, 11), MPI_result);
+    ASSERT_EQ(notMPIquasiIntegration(N, a, b, function3, 11),
+              MPI_quasi_result);
+  }
+}
+
+TEST(Integration_montecarlo_reproducible, test9) {
+  int ProcRank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &ProcRank);
+  int N = 20000;
+  double x1[BatchSize], y1[BatchSize], x2[BatchSize], y2[BatchSize];
+  philoxPoints(1, 0, BatchSize, x1, y1);
+  philoxPoints(1, 0, BatchSize, x2, y2);
+  for (int i = 0; i < BatchSize; i++) {
+    ASSERT_EQ(x1[i], x2[i]);
+    ASSERT_EQ(y1[i], y2[i]);
+  }
+
+  double first = MPIintegration(N, 0, 8, 4, function1, 1);
+  double second = MPIintegration(N, 0, 8, 4, function1, 2);
+  if (ProcRank == 0) {
+    ASSERT_NE(first, second);
+    ASSERT_NEAR(16, first, 0.5);
+    ASSERT_NEAR(16, second, 0.5);
+  }
+}
+
+TEST(Integration_montecarlo_quasi, test10) {
+  int ProcRank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &ProcRank);
+  double a = -2, b = 11;
+  int N = 1 << 14;
+
+  double MPI_result = MPIquasiIntegration(N, a, b, function4);
+  if (ProcRank == 0) {
+    ASSERT_NEAR(b - a + cos(a) - cos(b), MPI_result, 1e-4);
+  }
+}
+
+TEST(Integration_montecarlo_throw, test11) {
+  ASSERT_ANY_THROW(MPIquasiIntegration(0, 0, 1, function3));
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   MPI_Init(&argc, &argv);
@@ -1,21 +1,108 @@
 // Copyright 2022 Mitin Roman
 #include "../../modules/task_1/mitin_r_integr_mon_carl/integr_mon_carl.h"
-#include <random>
+#include <vector>
 
-std::pair<double, double> get_rand_point(double a, double b, double h_min, double h_max) {
-    int rank = 0;
-    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+namespace {
+
+constexpr double two_pow_53 = 9007199254740992.0;
+constexpr double two_pow_32 = 4294967296.0;
 
-    static std::random_device device;
-    static std::mt19937_64 r(device() * rank);
+inline uint32_t mul_hi_lo(uint32_t a, uint32_t b, uint32_t* hi) {
+    uint64_t product = static_cast<uint64_t>(a) * b;
+    *hi = static_cast<uint32_t>(product >> 32);
+    return static_cast<uint32_t>(product);
+}
 
-    std::uniform_real_distribution<double> uniform_dist1(a, b);
-    std::uniform_real_distribution<double> uniform_dist2(h_min, h_max);
+// 53 random bits in [0, 1)
+inline double to_unit(uint32_t hi, uint32_t lo) {
+    return static_cast<double>(((static_cast<uint64_t>(hi) << 32) | lo) >> 11) / two_pow_53;
+}
 
-    std::pair<double, double> point;
-    point.first = uniform_dist1(r);
-    point.second = uniform_dist2(r);
+inline uint32_t reverse_bits(uint32_t x) {
+    x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+    x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+    x = ((x >> 4) & 0x0F0F0F0Fu) | ((x & 0x0F0F0F0Fu) << 4);
+    x = ((x >> 8) & 0x00FF00FFu) | ((x & 0x00FF00FFu) << 8);
+    return (x >> 16) | (x << 16);
+}
 
-    return point;
+// Laine-Karras hash, a nested uniform scramble when applied to reversed bits
+inline uint32_t laine_karras(uint32_t x, uint32_t seed) {
+    x += seed;
+    x ^= x * 0x6c50b47cu;
+    x ^= x * 0xb82f1e52u;
+    x ^= x * 0xc7afe638u;
+    x ^= x * 0x8d22f6e6u;
+    return x;
 }
 
+void chunk_bounds(int64_t num_chunks, int size, int rank, int64_t* first, int64_t* last) {
+    *first = num_chunks * rank / size;
+    *last = num_chunks * (rank + 1) / size;
+}
+
+}  // namespace
+
+std::array<uint32_t, 4> philox4x32(std::array<uint32_t, 4> counter, std::array<uint32_t, 2> key) {
+    for (int round = 0; round < 10; round++) {
+        uint32_t hi0, hi1;
+        uint32_t lo0 = mul_hi_lo(0xD2511F53u, counter[0], &hi0);
+        uint32_t lo1 = mul_hi_lo(0xCD9E8D57u, counter[2], &hi1);
+        counter = {hi1 ^ counter[1] ^ key[0], lo1, hi0 ^ counter[3] ^ key[1], lo0};
+        key[0] += 0x9E3779B9u;
+        key[1] += 0xBB67AE85u;
+    }
+    return counter;
+}
+
+void philox_points(uint64_t seed, int64_t first, int64_t count, double* x, double* y) {
+    std::array<uint32_t, 2> key = {static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)};
+    for (int64_t i = 0; i < count; i++) {
+        uint64_t index = first + i;
+        std::array<uint32_t, 4> r = philox4x32(
+            {static_cast<uint32_t>(index), static_cast<uint32_t>(index >> 32), 0, 0}, key);
+        x[i] = to_unit(r[0], r[1]);
+        y[i] = to_unit(r[2], r[3]);
+    }
+}
+
+void sobol_points(uint64_t seed, int64_t first, int64_t count, double* x) {
+    // the first dimension of Sobol is van der Corput, so the scrambled point i
+    // is reverse(scramble(reverse(reverse(i)))) = reverse(scramble(i))
+    uint32_t scramble = philox4x32({0, 0, 0, 1},
+        {static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)})[0];
+    for (int64_t i = 0; i < count; i++) {
+        uint32_t index = static_cast<uint32_t>(first + i);
+        x[i] = (reverse_bits(laine_karras(index, scramble)) + 0.5) / two_pow_32;
+    }
+}
+
+void rank_chunks(int64_t num_chunks, int64_t* first, int64_t* last) {
+    int size, rank;
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    chunk_bounds(num_chunks, size, rank, first, last);
+}
+
+double ordered_sum(const std::vector<double>& local_sums, int64_t num_chunks) {
+    int size;
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    std::vector<int> counts(size), displs(size);
+    for (int i = 0; i < size; i++) {
+        int64_t first, last;
+        chunk_bounds(num_chunks, size, i, &first, &last);
+        displs[i] = static_cast<int>(first);
+        counts[i] = static_cast<int>(last - first);
+    }
+
+    std::vector<double> sums(num_chunks);
+    MPI_Allgatherv(local_sums.data(), static_cast<int>(local_sums.size()), MPI_DOUBLE,
+        sums.data(), counts.data(), displs.data(), MPI_DOUBLE, MPI_COMM_WORLD);
+
+    double sum = 0.0;
+    for (double chunk_sum : sums) {
+        sum += chunk_sum;
+    }
+    return sum;
+}
@@ -3,38 +3,65 @@
 #define MODULES_TASK_1_MITIN_R_INTEGR_MON_CARL_INTEGR_MON_CARL_H_
 
 #include <mpi.h>
+#include <algorithm>
+#include <array>
 #include <cinttypes>
-#include <utility>
+#include <vector>
 
-std::pair<double, double> get_rand_point(double a, double b, double h_min, double h_max);
+constexpr uint64_t default_seed = 0x9E3779B97F4A7C15ull;
+// points generated at once before func is called on them
+constexpr int64_t batch_points = 1 << 10;
+// quasi Monte Carlo sums are combined per chunk, so the rounding does not depend on the ranks
+constexpr int64_t chunk_points = 1 << 12;
+
+// Philox4x32-10 counter-based generator: the output depends only on the counter and the key
+std::array<uint32_t, 4> philox4x32(std::array<uint32_t, 4> counter, std::array<uint32_t, 2> key);
+
+// Point i of the stream is philox4x32(i, seed), so any rank or thread can start anywhere.
+// Fills x and y with the points first .. first + count - 1 of [0, 1)^2.
+void philox_points(uint64_t seed, int64_t first, int64_t count, double* x, double* y);
+
+// Owen-scrambled Sobol points first .. first + count - 1 of (0, 1), at most 2^32 of them.
+void sobol_points(uint64_t seed, int64_t first, int64_t count, double* x);
+
+// Range [first, last) of the num_chunks chunks evaluated by this rank.
+void rank_chunks(int64_t num_chunks, int64_t* first, int64_t* last);
+
+// Sum of the chunk sums of all ranks taken in chunk order.
+double ordered_sum(const std::vector<double>& local_sums, int64_t num_chunks);
 
 template<typename func_t>
-int64_t integrate_monte_carlo_seq(func_t func, double a, double b, double h_max, int64_t num_points) {
+int64_t integrate_monte_carlo_seq(func_t func, double a, double b, double h_max, int64_t num_points,
+                                  int64_t first = 0, uint64_t seed = default_seed) {
     int64_t count_under_points = 0;
-
-    for (int64_t i = 0; i < num_points; i++) {
-        auto point = get_rand_point(a, b, 0, h_max);
-        if (func(point.first) > point.second) {
-            count_under_points++;
+    std::array<double, batch_points> x, y;
+
+    for (int64_t done = 0; done < num_points; done += batch_points) {
+        int64_t count = std::min(batch_points, num_points - done);
+        philox_points(seed, first + done, count, x.data(), y.data());
+        for (int64_t i = 0; i < count; i++) {
+            if (func(a + (b - a) * x[i]) > h_max * y[i]) {
+                count_under_points++;
+            }
         }
     }
 
-    // double rectangle_area = (b - a) * h_max;
-    // double result = static_cast<double>(count_under_points) / num_points * rectangle_area;
-
     return count_under_points;
 }
 
 template<typename func_t>
-double integrate_monte_carlo(func_t func, double a, double b, double h_max, int64_t num_points) {
+double integrate_monte_carlo(func_t func, double a, double b, double h_max, int64_t num_points,
+                             uint64_t seed = default_seed) {
     int size, rank;
     MPI_Comm_size(MPI_COMM_WORLD, &size);
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
 
-    num_points = ((num_points + size - 1) / size) * size;
+    // the counts are integers, so the split does not change the result
+    int64_t first = num_points * rank / size;
+    int64_t last = num_points * (rank + 1) / size;
 
     int64_t local_points_count =
-        integrate_monte_carlo_seq(func, a, b, h_max, num_points / size);
+        integrate_monte_carlo_seq(func, a, b, h_max, last - first, first, seed);
 
     int64_t global_points_count;
 
@@ -48,5 +75,51 @@ double integrate_monte_carlo(func_t func, double a, double b, double h_max, int6
     return result;
 }
 
+template<typename func_t>
+double quasi_chunk_sum(func_t func, double a, double b, int64_t chunk, int64_t num_points, uint64_t seed) {
+    std::array<double, batch_points> x;
+    double sum = 0.0;
+
+    int64_t last = std::min((chunk + 1) * chunk_points, num_points);
+    for (int64_t first = chunk * chunk_points; first < last; first += batch_points) {
+        int64_t count = std::min(batch_points, last - first);
+        sobol_points(seed, first, count, x.data());
+        for (int64_t i = 0; i < count; i++) {
+            sum += func(a + (b - a) * x[i]);
+        }
+    }
+
+    return sum;
+}
+
+// Mean value estimate on scrambled Sobol points, the error falls as O(1/N) for smooth func.
+template<typename func_t>
+double integrate_quasi_monte_carlo_seq(func_t func, double a, double b, int64_t num_points,
+                                       uint64_t seed = default_seed) {
+    int64_t num_chunks = (num_points + chunk_points - 1) / chunk_points;
+    double sum = 0.0;
+
+    for (int64_t chunk = 0; chunk < num_chunks; chunk++) {
+        sum += quasi_chunk_sum(func, a, b, chunk, num_points, seed);
+    }
+
+    return sum / num_points * (b - a);
+}
+
+template<typename func_t>
+double integrate_quasi_monte_carlo(func_t func, double a, double b, int64_t num_points,
+                                   uint64_t seed = default_seed) {
+    int64_t num_chunks = (num_points + chunk_points - 1) / chunk_points;
+    int64_t first, last;
+    rank_chunks(num_chunks, &first, &last);
+
+    std::vector<double> local_sums(last - first);
+    for (int64_t chunk = first; chunk < last; chunk++) {
+        local_sums[chunk - first] = quasi_chunk_sum(func, a, b, chunk, num_points, seed);
+    }
+
+    return ordered_sum(local_sums, num_chunks) / num_points * (b - a);
+}
+
 
 #endif  // MODULES_TASK_1_MITIN_R_INTEGR_MON_CARL_INTEGR_MON_CARL_H_
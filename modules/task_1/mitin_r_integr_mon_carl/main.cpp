@@ -1,7 +1,9 @@
 // Copyright 2022 Mitin Roman
 #include <gtest/gtest.h>
 
+#include <array>
 #include <cmath>
+#include <vector>
 #include "./integr_mon_carl.h"
 #include <gtest-mpi-listener.hpp>
 
@@ -88,6 +90,63 @@ TEST(integrate_monte_carlo, test_exp) {
     EXPECT_LE(abs(res - expected), max_err);
 }
 
+TEST(integrate_monte_carlo, philox_known_answer) {
+    std::array<uint32_t, 4> zero = philox4x32({0, 0, 0, 0}, {0, 0});
+    EXPECT_EQ(0x6627e8d5u, zero[0]);
+    EXPECT_EQ(0xe169c58du, zero[1]);
+    EXPECT_EQ(0xbc57ac4cu, zero[2]);
+    EXPECT_EQ(0x9b00dbd8u, zero[3]);
+
+    std::array<uint32_t, 4> ones = philox4x32({~0u, ~0u, ~0u, ~0u}, {~0u, ~0u});
+    EXPECT_EQ(0x408f276du, ones[0]);
+    EXPECT_EQ(0x41c83b0eu, ones[1]);
+    EXPECT_EQ(0xa20bc7c6u, ones[2]);
+    EXPECT_EQ(0x6d5451fdu, ones[3]);
+}
+
+TEST(integrate_monte_carlo, same_bits_for_any_rank_count) {
+    constexpr int64_t num_points = 300007;
+    auto func = [](double x) { return sin(x) * sin(x); };
+
+    double res = integrate_monte_carlo(func, 0.0, M_PI, 1.0, num_points, 17);
+    double quasi_res = integrate_quasi_monte_carlo(func, 0.0, M_PI, num_points, 17);
+
+    int64_t count = integrate_monte_carlo_seq(func, 0.0, M_PI, 1.0, num_points, 0, 17);
+    EXPECT_EQ(static_cast<double>(count) / num_points * M_PI, res);
+    EXPECT_EQ(integrate_quasi_monte_carlo_seq(func, 0.0, M_PI, num_points, 17), quasi_res);
+}
+
+TEST(integrate_monte_carlo, quasi_needs_fewer_points) {
+    constexpr double start = 0.0;
+    constexpr double finish = M_PI;
+    constexpr double expected = 1.2512081731;
+
+    auto exp_func = [=](double x) { return exp(-x * x / 2.0); };
+
+    double res = integrate_quasi_monte_carlo(exp_func, start, finish, 1 << 14);
+
+    EXPECT_LE(abs(res - expected), 1e-6);
+}
+
+TEST(integrate_monte_carlo, seeds_give_independent_points) {
+    std::vector<double> x1(batch_points), y1(batch_points), x2(batch_points), y2(batch_points);
+    philox_points(1, 0, batch_points, x1.data(), y1.data());
+    philox_points(2, 0, batch_points, x2.data(), y2.data());
+
+    double mean = 0.0;
+    int equal = 0;
+    for (int64_t i = 0; i < batch_points; i++) {
+        mean += x1[i] + y1[i];
+        equal += x1[i] == x2[i];
+    }
+    EXPECT_NEAR(1.0, mean / batch_points, 0.05);
+    EXPECT_EQ(0, equal);
+
+    philox_points(1, 100, 1, x2.data(), y2.data());
+    EXPECT_EQ(x1[100], x2[0]);
+    EXPECT_EQ(y1[100], y2[0]);
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     MPI_Init(&argc, &argv);
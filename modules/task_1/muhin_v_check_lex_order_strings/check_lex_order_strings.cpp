@@ -4,6 +4,12 @@
 #include <string>
 #include <random>
 #include <algorithm>
+#include <cstdint>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 #include "../../../modules/task_1/muhin_v_check_lex_order_strings/check_lex_order_strings.h"
 
 
@@ -17,88 +23,89 @@ std::vector<char> getRandomString(std::vector<char>::size_type size) {
     return vec;
 }
 
-int getSequentialOperations(const std::vector<char>& str1, const std::vector<char>& str2) {
-    for (std::vector<char>::size_type i = 0; i < str1.size(); i++) {
-        if (str1[i] < str2[i]) {
-            return -1;
-        } else {
-            if (str1[i] > str2[i]) {
-                return 1;
-            }
+std::vector<char>::size_type getFirstMismatch(const char* a, const char* b, std::vector<char>::size_type n) {
+    std::vector<char>::size_type i = 0;
+#if defined(__AVX2__)
+    for (; i + 32 <= n; i += 32) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        unsigned diff = ~static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y)));
+        if (diff != 0) {
+            return i + __builtin_ctz(diff);
+        }
+    }
+#elif defined(__SSE2__)
+    for (; i + 16 <= n; i += 16) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        unsigned diff = ~static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(x, y))) & 0xFFFFu;
+        if (diff != 0) {
+            return i + __builtin_ctz(diff);
         }
     }
-    return 0;
+#endif
+    for (; i < n; i++) {
+        if (a[i] != b[i]) {
+            return i;
+        }
+    }
+    return n;
+}
+
+int getSequentialOperations(const std::vector<char>& str1, const std::vector<char>& str2) {
+    std::vector<char>::size_type i = getFirstMismatch(str1.data(), str2.data(), str1.size());
+    if (i == str1.size()) {
+        return 0;
+    }
+    return str1[i] < str2[i] ? -1 : 1;
+}
+
+int reduceFirstMismatch(std::vector<char>::size_type pos, int order) {
+    // The order sits in the low bits of the key, so the smallest key belongs to
+    // the first position and still tells the order found there
+    int64_t key = static_cast<int64_t>(pos) * 4 + (order + 1);
+    MPI_Allreduce(MPI_IN_PLACE, &key, 1, MPI_INT64_T, MPI_MIN, MPI_COMM_WORLD);
+    return static_cast<int>(key % 4) - 1;
 }
 
 int getParallelOperations(const std::vector<char>&str1, const std::vector<char>&str2,
-                          std::vector<char>::size_type global_size) {
+                          std::vector<char>::size_type global_size,
+                          std::vector<char>::size_type prefix) {
     int size, rank;
     MPI_Comm_size(MPI_COMM_WORLD, &size);
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
-    std::vector<char>::size_type local_size = global_size / size;
 
+    // sorted keys usually differ early, then nothing else has to be sent
+    prefix = std::min(prefix, global_size);
+    int prefix_res = 0;
     if (rank == 0) {
-        for (int proc = 1; proc < size; proc++) {
-            std::vector<char>::size_type step = proc * local_size;
-
-            if (global_size % size != 0) {
-                step += global_size % size;
-            }
-
-            std::vector<char> send_vector;
-            for (std::vector<char>::size_type i = step; i < step + local_size; i++) {
-                send_vector.push_back(str1[i]);
-            }
-            for (std::vector<char>::size_type i = step; i < step + local_size; i++) {
-                send_vector.push_back(str2[i]);
-            }
-            MPI_Send(send_vector.data(), static_cast<int>(send_vector.size()),
-                MPI_CHAR, proc, 0, MPI_COMM_WORLD);
+        std::vector<char>::size_type i = getFirstMismatch(str1.data(), str2.data(), prefix);
+        if (i < prefix) {
+            prefix_res = str1[i] < str2[i] ? -1 : 1;
         }
     }
-
-    if (rank == 0) {
-        local_size += global_size % size;
-    }
-
-    std::vector<char> local_vector(local_size * 2);
-    if (rank == 0) {
-        for (std::vector<int>::size_type i = 0; i < local_size; i++) {
-            local_vector[i] = str1[i];
-            local_vector[i + local_size] = str2[i];
-        }
-    } else {
-        MPI_Status status;
-        MPI_Recv(local_vector.data(), static_cast<int>(local_vector.size()),
-            MPI_CHAR, 0, 0, MPI_COMM_WORLD, &status);
+    MPI_Bcast(&prefix_res, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    if (prefix_res != 0) {
+        return prefix_res;
     }
-    std::vector<char> local_str1(local_size);
-    std::vector<char> local_str2(local_size);
 
-    for (std::vector<char>::size_type i = 0; i < local_size; i++) {
-        local_str1[i] = local_vector[i];
-        local_str2[i] = local_vector[i + local_size];
+    std::vector<int> counts(size), displs(size);
+    std::vector<char>::size_type rest = global_size - prefix;
+    for (int proc = 0; proc < size; proc++) {
+        displs[proc] = static_cast<int>(prefix + rest * proc / size);
+        counts[proc] = static_cast<int>(prefix + rest * (proc + 1) / size) - displs[proc];
     }
 
-    std::vector<int> local_res(size, 0);
-    local_res[rank] = getSequentialOperations(local_str1, local_str2);
-
-    std::vector<int> global_res(size, 0);
-    MPI_Reduce(local_res.data(), global_res.data(), size,
-        MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
+    std::vector<char> local_str1(counts[rank]);
+    std::vector<char> local_str2(counts[rank]);
+    MPI_Scatterv(str1.data(), counts.data(), displs.data(), MPI_CHAR,
+        local_str1.data(), counts[rank], MPI_CHAR, 0, MPI_COMM_WORLD);
+    MPI_Scatterv(str2.data(), counts.data(), displs.data(), MPI_CHAR,
+        local_str2.data(), counts[rank], MPI_CHAR, 0, MPI_COMM_WORLD);
 
-    if (rank == 0) {
-        for (const auto& res : global_res) {
-            if (res == 1) {
-                return 1;
-            } else {
-                if (res == -1) {
-                    return -1;
-                }
-            }
-        }
-        return 0;
+    std::vector<char>::size_type i = getFirstMismatch(local_str1.data(), local_str2.data(), local_str1.size());
+    if (i == local_str1.size()) {
+        return reduceFirstMismatch(global_size, 0);
     }
-
-    return 0;
+    return reduceFirstMismatch(displs[rank] + i, local_str1[i] < local_str2[i] ? -1 : 1);
 }
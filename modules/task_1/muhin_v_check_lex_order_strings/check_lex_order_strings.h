@@ -4,8 +4,19 @@
 #include <vector>
 
 std::vector<char> getRandomString(std::vector<char>::size_type size);
+
+// Position of the first byte where a and b differ among n bytes, or n if they are equal.
+std::vector<char>::size_type getFirstMismatch(const char* a, const char* b, std::vector<char>::size_type n);
+
+// Order at the first mismatch over all ranks. Each rank passes its first mismatch
+// at the global position pos, or the global size if it found none.
+int reduceFirstMismatch(std::vector<char>::size_type pos, int order);
+
+// With prefix > 0 rank 0 compares that many leading chars itself and sends out
+// the rest only if they are equal. The result is returned on every rank.
 int getParallelOperations(const std::vector<char>&str1, const std::vector<char>&str2,
-                          std::vector<char>::size_type global_size);
+                          std::vector<char>::size_type global_size,
+                          std::vector<char>::size_type prefix = 0);
 int getSequentialOperations(const std::vector<char>& str1, const std::vector<char>& str2);
 
 #endif  //  MODULES_TASK_1_MUHIN_V_CHECK_LEX_ORDER_STRINGS_CHECK_LEX_ORDER_STRINGS_H_
@@ -137,6 +137,76 @@ TEST(Parallel_Operations_MPI, getParallelOperations_can_define_larger_strings) {
     }
 }
 
+TEST(Sequential_Operations_MPI, getFirstMismatch_finds_first_difference) {
+    std::vector<char> str1 = getRandomString(150);
+    for (std::vector<char>::size_type n = 0; n <= 100; n++) {
+        for (std::vector<char>::size_type pos = 0; pos < n; pos += 5) {
+            std::vector<char> str2 = str1;
+            str2[pos] = static_cast<char>(str2[pos] + 1);
+            ASSERT_EQ(pos, getFirstMismatch(str1.data(), str2.data(), n));
+        }
+        ASSERT_EQ(n, getFirstMismatch(str1.data(), str1.data(), n));
+    }
+}
+
+TEST(Parallel_Operations_MPI, getParallelOperations_finds_first_mismatch_of_all_ranks) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    std::vector<char>::size_type size = 1000;
+    std::vector<char> base = getRandomString(size);
+
+    for (std::vector<char>::size_type pos : { 0, 31, 499, 500, 997, 998 }) {
+        std::vector<char> str1, str2;
+        if (rank == 0) {
+            str1 = base;
+            str2 = base;
+            str2[pos] = static_cast<char>(str2[pos] + 1);
+            str2[size - 1] = static_cast<char>(str2[size - 1] - 2);
+        }
+
+        int res = getParallelOperations(str1, str2, size);
+
+        ASSERT_EQ(-1, res);
+    }
+}
+
+TEST(Parallel_Operations_MPI, reduceFirstMismatch_takes_positions_past_int_range) {
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    std::vector<char>::size_type global_size = static_cast<std::vector<char>::size_type>(6) << 30;
+    std::vector<char>::size_type pos = (static_cast<std::vector<char>::size_type>(5) << 30) - rank;
+
+    ASSERT_EQ(1, reduceFirstMismatch(pos, rank == size - 1 ? 1 : -1));
+    ASSERT_EQ(0, reduceFirstMismatch(global_size, 0));
+    ASSERT_EQ(-1, reduceFirstMismatch(rank == 0 ? global_size - 1 : global_size, rank == 0 ? -1 : 0));
+}
+
+TEST(Parallel_Operations_MPI, getParallelOperations_speculative_prefix_gives_same_result) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    std::vector<char>::size_type size = 500;
+    std::vector<char> base = getRandomString(size);
+
+    for (std::vector<char>::size_type pos : { 0, 10, 64, 499 }) {
+        for (std::vector<char>::size_type prefix : { 0, 1, 64, 1000 }) {
+            std::vector<char> str1, str2;
+            if (rank == 0) {
+                str1 = base;
+                str2 = base;
+                str1[pos] = static_cast<char>(str1[pos] + 1);
+            }
+
+            int res = getParallelOperations(str1, str2, size, prefix);
+
+            ASSERT_EQ(1, res);
+        }
+    }
+    int res = getParallelOperations(base, base, size, 100);
+    ASSERT_EQ(0, res);
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     MPI_Init(&argc, &argv);
@@ -7,6 +7,11 @@
 #include <random>
 #include <string>
 #include <vector>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 char *getRandomString(const int size) {
     char *res = new char[size];
@@ -21,7 +26,28 @@ char *getRandomString(const int size) {
 
 int sym_on_str(const char *str, const int size, const char sym) {
     int res = 0;
-    for (int i = 0; i < size; i++) {
+    int i = 0;
+#if defined(__AVX2__)
+    // 32 bytes per step: compare, take the mask of equal bytes, count its bits
+    const __m256i needle = _mm256_set1_epi8(sym);
+    for (; i + 32 <= size; i += 32) {
+        __m256i block = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i *>(str + i));
+        unsigned mask = static_cast<unsigned>(
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, needle)));
+        res += __builtin_popcount(mask);
+    }
+#elif defined(__SSE2__)
+    const __m128i needle = _mm_set1_epi8(sym);
+    for (; i + 16 <= size; i += 16) {
+        __m128i block = _mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(str + i));
+        unsigned mask = static_cast<unsigned>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(block, needle)));
+        res += __builtin_popcount(mask);
+    }
+#endif
+    for (; i < size; i++) {
         if (str[i] == sym) {
             res++;
         }
@@ -46,25 +72,19 @@ int par_sym_on_str(const char *global_str, const int global_str_len,
         }
     }
 
-    char *local_str = new char[local_size];
-
+    // the null process counts its part in place, without a copy
+    int local_sum;
     if (rank == 0) {
-        for (int i = 0; i < local_size; i++) {
-            local_str[i] = global_str[i];
-        }
+        local_sum = sym_on_str(global_str, local_size, sym);
     } else {
+        char *local_str = new char[delta];
         MPI_Status status;
         MPI_Recv(local_str, delta, MPI_CHAR, 0, 0, MPI_COMM_WORLD, &status);
-    }
-
-    int global_sum = 0;
-    int local_sum;
-    if (rank == 0) {
-        local_sum = sym_on_str(local_str, local_size, sym);
-    } else {
         local_sum = sym_on_str(local_str, delta, sym);
+        delete[] local_str;
     }
 
+    int global_sum = 0;
     MPI_Op op_code = MPI_SUM;
     MPI_Reduce(&local_sum, &global_sum, 1, MPI_INT, op_code, 0, MPI_COMM_WORLD);
     return global_sum;
@@ -3,6 +3,7 @@
 
 #include <random>
 #include <string>
+#include <vector>
 #include <gtest-mpi-listener.hpp>
 
 #include "./chars_on_str.h"
@@ -97,6 +98,53 @@ TEST(Parallel_Operations_MPI, Test_find_size_10) {
         ASSERT_EQ(reference_sum, global_sum);
     }
 }
+TEST(Parallel_Operations_MPI, Test_all_bytes_and_tails) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    if (rank == 0) {
+        std::mt19937 gen(5);
+        std::vector<char> str(300);
+        for (size_t i = 0; i < str.size(); i++) {
+            str[i] = static_cast<char>(gen() % 4 == 0 ? 0xE9 : gen() % 256);
+        }
+        for (int sym : {0xE9, 0, 0x41, 0x80, 0xFF}) {
+            // every offset and length exercises the vector loop and the tail
+            for (int offset = 0; offset < 33; offset += 7) {
+                for (int len = 0; len + offset <= 300; len += 13) {
+                    int expected = 0;
+                    for (int i = offset; i < offset + len; i++) {
+                        expected += str[i] == static_cast<char>(sym);
+                    }
+                    ASSERT_EQ(expected, sym_on_str(str.data() + offset, len,
+                                                   static_cast<char>(sym)));
+                }
+            }
+        }
+    }
+}
+TEST(Parallel_Operations_MPI, Test_find_size_1000003) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    char *global_str = nullptr;
+    const int count_size_str = 1000003;
+    char sym = 'z';
+
+    if (rank == 0) {
+        global_str = getRandomString(count_size_str);
+    }
+
+    int global_sum = par_sym_on_str(global_str, count_size_str, sym);
+
+    if (rank == 0) {
+        int reference_sum = 0;
+        for (int i = 0; i < count_size_str; i++) {
+            reference_sum += global_str[i] == sym;
+        }
+        ASSERT_EQ(reference_sum, global_sum);
+        delete[] global_str;
+    }
+}
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     MPI_Init(&argc, &argv);
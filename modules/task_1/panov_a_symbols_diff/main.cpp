@@ -1,5 +1,6 @@
 // Copyright 2022 Panov Alexey
 #include <gtest/gtest.h>
+#include <random>
 #include <string>
 #include "./symbols_diff.h"
 #include <gtest-mpi-listener.hpp>
@@ -75,6 +76,45 @@ TEST(Parallel_Operations_MPI, Strings_With_Diff_Size_2) {
     }
 }
 
+TEST(Parallel_Operations_MPI, Long_Strings) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    std::mt19937 gen(11);
+    std::string first(100003, 'a');
+    std::string second(first.size() - 17, 'a');
+    int expected = 17;
+    for (size_t i = 0; i < second.size(); i++) {
+        first[i] = static_cast<char>(gen() % 4 + 'a');
+        second[i] = static_cast<char>(gen() % 4 + 'a');
+        expected += first[i] != second[i];
+    }
+
+    int diff = getDifferentSymbolsCountParallel(first, second);
+
+    if (rank == 0) {
+        ASSERT_EQ(expected, diff);
+    }
+}
+
+TEST(Parallel_Operations_MPI, Mismatch_Count_Tails) {
+    std::string first(200, 'x');
+    std::string second(200, 'x');
+    for (size_t i = 0; i < second.size(); i += 3) {
+        second[i] = static_cast<char>(0x80 + i % 100);
+    }
+
+    for (int from = 0; from < 40; from += 5) {
+        for (int to = from; to <= 200; to += 11) {
+            int expected = 0;
+            for (int i = from; i < to; i++) {
+                expected += first[i] != second[i];
+            }
+            ASSERT_EQ(expected, getDifferentSymbolsCountSequentially(first, second, from, to));
+        }
+    }
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     MPI_Init(&argc, &argv);
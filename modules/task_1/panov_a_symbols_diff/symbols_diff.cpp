@@ -4,22 +4,51 @@
 #include <iostream>
 #include <string>
 #include <algorithm>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 #include "../../../modules/task_1/panov_a_symbols_diff/symbols_diff.h"
 
 
+int getMismatchCount(const char* first, const char* second, int size) {
+    int diffCount = 0;
+    int i = 0;
+
+#if defined(__AVX2__)
+    // 32 bytes at a time: the equal bytes set mask bits, the rest differ
+    for (; i + 32 <= size; i += 32) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(second + i));
+        unsigned equal = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b)));
+        diffCount += 32 - __builtin_popcount(equal);
+    }
+#elif defined(__SSE2__)
+    for (; i + 16 <= size; i += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(second + i));
+        unsigned equal = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)));
+        diffCount += 16 - __builtin_popcount(equal);
+    }
+#endif
+
+    for (; i < size; i++) {
+        if (first[i] != second[i]) diffCount++;
+    }
+
+    return diffCount;
+}
+
 int getDifferentSymbolsCountSequentially(
     const std::string& first,
     const std::string& second,
     int from,
     int to
 ) {
-    int diffCount = 0;
+    if (to <= from) return 0;
 
-    for (int i = from; i < to; i++) {
-        if (first[i] != second[i]) diffCount++;
-    }
-
-    return diffCount;
+    return getMismatchCount(first.data() + from, second.data() + from, to - from);
 }
 
 int getDifferentSymbolsCountParallel(
@@ -4,6 +4,9 @@
 
 #include <string>
 
+// Number of positions among the first size bytes where first and second differ.
+int getMismatchCount(const char* first, const char* second, int size);
+
 int getDifferentSymbolsCountSequentially(
     const std::string& first,
     const std::string& second,
@@ -5,48 +5,160 @@
 #include <string>
 #include <random>
 #include <algorithm>
+#include <cstdint>
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 #include "../../../modules/task_1/shokurov_d_check_order/check_order.h"
 
-std::string scatter_string(std::string str1) {
+#ifdef _WIN32
+// no mmap here, the whole file is read into memory instead
+MappedFile::MappedFile(const std::string& path) : data_(nullptr), size_(0) {
+  std::ifstream in(path, std::ios::binary | std::ios::ate);
+  if (!in) throw "Can't open the file";
+  std::streamoff end = in.tellg();
+  if (end < 0) throw "Can't read the file";
+  if (end > 0) {
+    buffer_.resize(static_cast<size_t>(end));
+    in.seekg(0);
+    if (!in.read(buffer_.data(), end)) throw "Can't read the file";
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+  }
+}
+
+MappedFile::~MappedFile() {}
+#else
+MappedFile::MappedFile(const std::string& path) : data_(nullptr), size_(0) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) throw "Can't open the file";
+  off_t end = lseek(fd, 0, SEEK_END);
+  void* view = MAP_FAILED;
+  if (end > 0) {
+    view = mmap(nullptr, static_cast<size_t>(end), PROT_READ, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if (end < 0 || (end > 0 && view == MAP_FAILED)) throw "Can't map the file";
+  if (end > 0) {
+    data_ = static_cast<const char*>(view);
+    size_ = static_cast<size_t>(end);
+  }
+}
+
+MappedFile::~MappedFile() {
+  if (data_) munmap(const_cast<char*>(data_), size_);
+}
+#endif
+
+StringChunk MappedFile::chunk(size_t begin, size_t end) const {
+  begin = std::min(begin, size_);
+  end = std::min(end, size_);
+  StringChunk part = {data_ + begin, end - begin};
+  return part;
+}
+
+void rank_range(size_t first, size_t last, int rank, int procs, size_t* begin, size_t* end) {
+  uint64_t total = last - first;
+  *begin = first + static_cast<size_t>(total * rank / procs);
+  *end = first + static_cast<size_t>(total * (rank + 1) / procs);
+}
+
+std::string scatter_string(const std::string& str1, size_t first, size_t last) {
   int rank;
   int numProc = 0;
   MPI_Comm_size(MPI_COMM_WORLD, &numProc);
   MPI_Comm_rank(MPI_COMM_WORLD, &rank);
-  if (rank == 0) {
-    int count = str1.size();
-    count += (numProc - (((count - 1) % numProc) + 1));
-    str1.resize(count);
-    for (int i = str1.size(); i < count; ++i) {
-      str1[i] = 0;
-    }
-    int si = count / numProc;
-    const char* ptr1 = str1.c_str();
-    for (int i = 1; i < numProc; ++i) {
-      MPI_Send(ptr1 + i * si, si, MPI_CHAR, i, 123, MPI_COMM_WORLD);
-    }
-    str1.resize(si);
-  } else {
-    MPI_Status status;
-    char* buffer;
-    int count;
-    MPI_Probe(0, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
-    MPI_Get_count(&status, MPI_CHAR, &count);
-    buffer = new char[count];
-    MPI_Recv(buffer, count, MPI_CHAR, 0, 123, MPI_COMM_WORLD, &status);
-    str1 = std::string(buffer, count);
-    delete[] buffer;
+
+  int length = rank == 0 ? static_cast<int>(str1.size()) : 0;
+  MPI_Bcast(&length, 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+  std::vector<int> counts(numProc), displs(numProc);
+  for (int i = 0; i < numProc; ++i) {
+    size_t begin, end;
+    rank_range(first, last, i, numProc, &begin, &end);
+    begin = std::min(begin, static_cast<size_t>(length));
+    end = std::min(end, static_cast<size_t>(length));
+    displs[i] = static_cast<int>(begin);
+    counts[i] = static_cast<int>(end - begin);
   }
-  return str1;
+
+  std::string part(counts[rank], 0);
+  MPI_Scatterv(rank == 0 ? str1.data() : nullptr, counts.data(), displs.data(), MPI_CHAR,
+               &part[0], counts[rank], MPI_CHAR, 0, MPI_COMM_WORLD);
+  return part;
 }
 
-int check_order_single_process(size_t n, std::string a, std::string b) {
-  for (int i = 0; i < n; ++i) {
-    if (a[i] != b[i]) {
-      if (a[i] < b[i]) return -1;
-      if (a[i] > b[i]) return 1;
-    }
+// Compares a block of bytes at once and stops at the first block that differs
+size_t first_mismatch(const char* a, const char* b, size_t n) {
+  size_t i = 0;
+#if defined(__AVX2__)
+  for (; i + 32 <= n; i += 32) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+    __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+    unsigned diff = ~static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y)));
+    if (diff != 0) return i + __builtin_ctz(diff);
+  }
+#elif defined(__SSE2__)
+  for (; i + 16 <= n; i += 16) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+    unsigned diff = ~static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(x, y))) & 0xFFFFu;
+    if (diff != 0) return i + __builtin_ctz(diff);
+  }
+#endif
+  for (; i < n; ++i) {
+    if (a[i] != b[i]) return i;
   }
-  return 0;
+  return n;
+}
+
+size_t first_difference(StringChunk a, StringChunk b, size_t n, int* order) {
+  size_t common = std::min(n, std::min(a.size, b.size));
+  size_t pos = first_mismatch(a.data, b.data, common);
+  if (pos == common) {
+    // past the shorter chunk its bytes are zeros
+    const StringChunk& longer = a.size > b.size ? a : b;
+    size_t limit = std::min(n, longer.size);
+    while (pos < limit && longer.data[pos] == 0) ++pos;
+  }
+  if (pos >= n) {
+    *order = 0;
+    return n;
+  }
+  // bytes are ordered as unsigned, like std::string::compare does
+  unsigned char x = pos < a.size ? static_cast<unsigned char>(a.data[pos]) : 0;
+  unsigned char y = pos < b.size ? static_cast<unsigned char>(b.data[pos]) : 0;
+  *order = x < y ? -1 : 1;
+  return pos;
+}
+
+int compare_chunks(StringChunk a, StringChunk b, size_t n) {
+  int order;
+  first_difference(a, b, n, &order);
+  return order;
+}
+
+int first_answer(size_t pos, int order) {
+  // the order goes to the low bits, so the smallest key is the first position
+  // and still carries the order found there
+  int64_t key = static_cast<int64_t>(pos) * 4 + (order + 1);
+  MPI_Allreduce(MPI_IN_PLACE, &key, 1, MPI_INT64_T, MPI_MIN, MPI_COMM_WORLD);
+  return static_cast<int>(key % 4) - 1;
+}
+
+int check_order_single_process(size_t n, std::string a, std::string b) {
+  StringChunk x = {a.data(), a.size()};
+  StringChunk y = {b.data(), b.size()};
+  return compare_chunks(x, y, n);
 }
 
 std::string addNull(std::string str, int count) {
@@ -58,33 +170,64 @@ std::string addNull(std::string str, int count) {
   return str;
 }
 
-int getOrder(std::string str1, std::string str2) {
+int getOrder(const std::string& str1, const std::string& str2, size_t prefix) {
   int rank = 0;
   int numProc = 0;
-  MPI_Status status;
   MPI_Comm_size(MPI_COMM_WORLD, &numProc);
   MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  // the shorter string is compared as if padded with zeros up to n
+  int n = 0;
+  int prefix_order = 0;
   if (rank == 0) {
-    if (str1.size() < str2.size()) {
-      str1 = addNull(str1, str2.size() - str1.size());
-    } else {
-      str2 = addNull(str2, str1.size() - str2.size());
-    }
+    n = static_cast<int>(std::max(str1.size(), str2.size()));
+    prefix = std::min(prefix, static_cast<size_t>(n));
+    // keys that differ near the start are decided without sending anything
+    StringChunk a = {str1.data(), str1.size()};
+    StringChunk b = {str2.data(), str2.size()};
+    first_difference(a, b, prefix, &prefix_order);
   }
+  int header[3] = {n, static_cast<int>(prefix), prefix_order};
+  MPI_Bcast(header, 3, MPI_INT, 0, MPI_COMM_WORLD);
+  n = header[0];
+  prefix = header[1];
+  if (header[2] != 0) return header[2];
 
-  str1 = scatter_string(str1);
-  str2 = scatter_string(str2);
+  std::string part1 = scatter_string(str1, prefix, n);
+  std::string part2 = scatter_string(str2, prefix, n);
 
-  int ans = check_order_single_process(str1.size(), str1, str2);
+  size_t begin, end;
+  rank_range(prefix, n, rank, numProc, &begin, &end);
+  StringChunk a = {part1.data(), part1.size()};
+  StringChunk b = {part2.data(), part2.size()};
+  int order;
+  size_t pos = first_difference(a, b, end - begin, &order);
+  return first_answer(order != 0 ? begin + pos : n, order);
+}
 
-  if (rank == 0) {
-    for (int i = 1; i < numProc; ++i) {
-      int x;
-      MPI_Recv(&x, 1, MPI_INT, MPI_ANY_SOURCE, 456, MPI_COMM_WORLD, &status);
-      if (ans == 0) ans = x;
-    }
-  } else {
-    MPI_Send(&ans, 1, MPI_INT, 0, 456, MPI_COMM_WORLD);
+int getOrderFiles(const std::string& path1, const std::string& path2) {
+  int rank = 0;
+  int numProc = 0;
+  MPI_Comm_size(MPI_COMM_WORLD, &numProc);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  // a rank that can't map a file must not leave the others in the reduction
+  const char* error = nullptr;
+  size_t n = 0, begin = 0, pos = 0;
+  int order = 0;
+  try {
+    MappedFile file1(path1);
+    MappedFile file2(path2);
+    n = std::max(file1.size(), file2.size());
+    size_t end;
+    rank_range(0, n, rank, numProc, &begin, &end);
+    pos = first_difference(file1.chunk(begin, end), file2.chunk(begin, end), end - begin, &order);
+  } catch (const char* message) {
+    error = message;
   }
-  return ans;
+  int failed = error != nullptr;
+  MPI_Allreduce(MPI_IN_PLACE, &failed, 1, MPI_INT, MPI_LOR, MPI_COMM_WORLD);
+  if (failed) throw error ? error : "Can't map the file on another rank";
+
+  return first_answer(order != 0 ? begin + pos : n, order);
 }
@@ -2,11 +2,65 @@
 #ifndef MODULES_TASK_1_SHOKUROV_D_CHECK_ORDER_CHECK_ORDER_H_
 #define MODULES_TASK_1_SHOKUROV_D_CHECK_ORDER_CHECK_ORDER_H_
 
+#include <cstddef>
 #include <vector>
 #include <string>
 
-std::string scatter_string(std::string str1);
+// size bytes of a string or a file beginning at data, not owned.
+struct StringChunk {
+  const char* data;
+  size_t size;
+};
+
+// Read-only mmap of a file, every rank maps it and reads only its own range.
+// Windows builds read the whole file into memory instead.
+class MappedFile {
+ public:
+  explicit MappedFile(const std::string& path);
+  ~MappedFile();
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  StringChunk chunk(size_t begin, size_t end) const;
+  size_t size() const { return size_; }
+
+ private:
+  const char* data_;
+  size_t size_;
+#ifdef _WIN32
+  std::vector<char> buffer_;
+#endif
+};
+
+// Positions [begin, end) of rank among procs ranks over the positions [first, last).
+void rank_range(size_t first, size_t last, int rank, int procs, size_t* begin, size_t* end);
+
+// Part of str at the positions of this rank out of [first, last), sent from
+// rank 0 without padding. The part is shorter than the range where str ends.
+std::string scatter_string(const std::string& str1, size_t first, size_t last);
+
+// Position of the first byte where a and b differ among n bytes, or n if none.
+size_t first_mismatch(const char* a, const char* b, size_t n);
+
+// Position of the first difference of a and b over n positions, the missing
+// bytes taken as zeros, or n if there is none. The order there goes to *order.
+size_t first_difference(StringChunk a, StringChunk b, size_t n, int* order);
+
+// Order of a and b over n positions, the missing bytes taken as zeros.
+int compare_chunks(StringChunk a, StringChunk b, size_t n);
+
+// Order at the first difference over all ranks, given the one this rank found
+// at the global position pos; a rank that found none passes the compared length.
+// One reduction of 64-bit keys, the answer is returned on every rank.
+int first_answer(size_t pos, int order);
+
 int check_order_single_process(size_t n, std::string a, std::string b);
 std::string addNull(std::string str, int count);
-int getOrder(std::string str1, std::string str2);
+// Strings on rank 0 only. With prefix > 0 rank 0 first compares that many
+// leading bytes itself and the rest is sent out only if they are equal.
+int getOrder(const std::string& str1, const std::string& str2, size_t prefix = 0);
+
+// Every rank maps both files and compares its own range. If a file can't be
+// mapped on some rank, every rank throws.
+int getOrderFiles(const std::string& path1, const std::string& path2);
 #endif  // MODULES_TASK_1_SHOKUROV_D_CHECK_ORDER_CHECK_ORDER_H_
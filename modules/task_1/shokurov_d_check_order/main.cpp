@@ -1,6 +1,9 @@
 // Copyright 2022 Shokurov Daniil
 #include <gtest/gtest.h>
 #include <vector>
+#include <string>
+#include <fstream>
+#include <cstdio>
 #include "./check_order.h"
 #include <gtest-mpi-listener.hpp>
 
@@ -94,6 +97,160 @@ TEST(check_order_MPI, test_equal_string) {
   if (rank == 0) EXPECT_EQ(ans, 0);
 }
 
+namespace {
+
+int sign_of(int x) {
+  return (x > 0) - (x < 0);
+}
+
+std::string random_string(size_t n, unsigned seed) {
+  std::string str(n, 'a');
+  for (size_t i = 0; i < n; ++i) {
+    seed = seed * 1103515245u + 12345u;
+    str[i] = static_cast<char>(1 + (seed >> 16) % 255);
+  }
+  return str;
+}
+
+}  // namespace
+
+TEST(check_order_MPI, test_mismatch_anywhere) {
+  int rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  std::string base = random_string(1000, 3);
+  for (size_t pos : {0, 1, 137, 500, 998, 999}) {
+    std::string str1 = base;
+    std::string str2 = base;
+    str2[pos] = static_cast<char>(str2[pos] + 1);
+    if (rank != 0) str1 = str2 = "";
+
+    int ans = getOrder(str1, str2);
+    if (rank == 0) {
+      EXPECT_EQ(sign_of(str1.compare(str2)), ans);
+    }
+  }
+}
+
+TEST(check_order_MPI, test_prefix_and_high_bytes) {
+  int rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  std::string str1;
+  std::string str2;
+  if (rank == 0) {
+    str1 = random_string(50, 9);
+    str2 = str1 + "\xD0\x96";
+  }
+
+  int ans = getOrder(str1, str2);
+  if (rank == 0) EXPECT_EQ(-1, ans);
+
+  ans = getOrder(str2, str1);
+  if (rank == 0) EXPECT_EQ(1, ans);
+}
+
+TEST(check_order_MPI, test_mapped_files) {
+  int rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  const std::string path1 = "shokurov_d_check_order_1.txt";
+  const std::string path2 = "shokurov_d_check_order_2.txt";
+  std::string str1 = random_string(100000, 5);
+  std::string str2 = str1.substr(0, 77777) + "\x01";
+  if (rank == 0) {
+    std::ofstream(path1, std::ios::binary) << str1;
+    std::ofstream(path2, std::ios::binary) << str2;
+  }
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  int ans12 = getOrderFiles(path1, path2);
+  int ans21 = getOrderFiles(path2, path1);
+  int ans11 = getOrderFiles(path1, path1);
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  if (rank == 0) {
+    std::remove(path1.c_str());
+    std::remove(path2.c_str());
+    EXPECT_EQ(1, ans12);
+    EXPECT_EQ(-1, ans21);
+    EXPECT_EQ(0, ans11);
+  }
+}
+
+TEST(check_order_MPI, test_missing_file_on_one_rank) {
+  int rank, size;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+  const std::string path = "shokurov_d_check_order_3.txt";
+  if (rank == 0) {
+    std::ofstream(path, std::ios::binary) << random_string(1000, 7);
+  }
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  // only the last rank misses its file, but no rank may hang or return
+  std::string other = rank == size - 1 ? "shokurov_d_check_order_missing.txt" : path;
+  EXPECT_ANY_THROW(getOrderFiles(path, other));
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  if (rank == 0) std::remove(path.c_str());
+}
+
+TEST(check_order_MPI, test_first_answer_past_int_range) {
+  int rank, size;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+  // positions of a file bigger than 4 GiB, the first one is on the last rank
+  size_t n = static_cast<size_t>(6) << 30;
+  size_t pos = (static_cast<size_t>(5) << 30) - rank;
+  EXPECT_EQ(1, first_answer(pos, rank == size - 1 ? 1 : -1));
+  EXPECT_EQ(0, first_answer(n, 0));
+  EXPECT_EQ(-1, first_answer(rank == 0 ? n - 1 : n, rank == 0 ? -1 : 0));
+}
+
+TEST(check_order_MPI, test_speculative_prefix) {
+  int rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  std::string base = random_string(3000, 13);
+  for (size_t pos : {0, 5, 63, 64, 65, 2999}) {
+    for (size_t prefix : {0, 1, 64, 5000}) {
+      std::string str1 = base;
+      std::string str2 = base.substr(0, pos) + "\xFF";
+      if (rank != 0) str1 = str2 = "";
+
+      int ans = getOrder(str1, str2, prefix);
+      if (rank == 0) {
+        ASSERT_EQ(sign_of(str1.compare(str2)), ans) << pos << " " << prefix;
+      }
+    }
+  }
+}
+
+TEST(check_order_MPI, test_first_mismatch_kernel) {
+  std::string a = random_string(200, 17);
+  for (size_t n = 0; n <= 100; ++n) {
+    for (size_t pos = 0; pos < n; pos += 7) {
+      std::string b = a;
+      b[pos] = static_cast<char>(b[pos] ^ 0x80);
+      ASSERT_EQ(pos, first_mismatch(a.data(), b.data(), n));
+    }
+    ASSERT_EQ(n, first_mismatch(a.data(), a.data(), n));
+  }
+}
+
+TEST(check_order_MPI, test_zero_bytes_equal_padding) {
+  StringChunk a = {"ab\0\0c", 5};
+  StringChunk b = {"ab", 2};
+  int order;
+  EXPECT_EQ(4u, first_difference(a, b, 5, &order));
+  EXPECT_EQ(1, order);
+  EXPECT_EQ(0, compare_chunks(a, b, 4));
+  EXPECT_EQ(-1, compare_chunks(b, a, 5));
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   MPI_Init(&argc, &argv);
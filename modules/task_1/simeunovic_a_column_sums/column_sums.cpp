@@ -1,6 +1,7 @@
 // Copyright 2022 Aleksandar Simeunovic
 #include"../../../modules/task_1/simeunovic_a_column_sums/column_sums.h"
 #include<stdlib.h>
+#include<algorithm>
 #include<mpi.h>
 #include<iostream>
 #include<vector>
@@ -57,25 +58,32 @@ void DataDistribution(int ProcSize, int ProcRank, std::vector<int>* pSendInd, st
     (*pSendNum).resize(ProcSize);
     int RestColumns = column_num;
     int ColumnNum = column_num / ProcSize;
-    (*pSendNum)[0] = ColumnNum * row_num;
+    (*pSendNum)[0] = ColumnNum;
     (*pSendInd)[0] = 0;
     for (int i = 1; i < ProcSize; i++) {
         RestColumns -= ColumnNum;
         ColumnNum = RestColumns / (ProcSize - i);
-        (*pSendNum)[i] = ColumnNum * row_num;
+        (*pSendNum)[i] = ColumnNum;
         (*pSendInd)[i] = (*pSendInd)[i - 1] + (*pSendNum)[i - 1];
     }
-    std::vector<int>matrix_transport;
-    if (ProcRank == 0) {
-        for (int i = 0; i < column_num; i++) {
-            for (int j = 0; j < row_num; j++) {
-                 matrix_transport.push_back(matrix[i + j * column_num]);
-            }
-        }
-        // PrintVector(matrix_transport, row_num * column_num);
-    }
-    MPI_Scatterv(matrix_transport.data(), (*pSendNum).data(), (*pSendInd).data()
-    , MPI_INT, (*pProcColumns).data(), (*pSendNum)[ProcRank], MPI_INT, 0, MPI_COMM_WORLD);
+    ColumnNum = (*pSendNum)[ProcRank];
+    // A column of the row-major matrix with the extent of one int, so the
+    // blocks are scattered by column index without a transposed copy.
+    MPI_Datatype Column, SendColumn;
+    MPI_Type_vector(row_num, 1, column_num, MPI_INT, &Column);
+    MPI_Type_create_resized(Column, 0, sizeof(int), &SendColumn);
+    MPI_Type_commit(&SendColumn);
+    // The local block keeps the row-major layout.
+    MPI_Datatype ProcColumn, RecvColumn;
+    MPI_Type_vector(row_num, 1, ColumnNum > 0 ? ColumnNum : 1, MPI_INT, &ProcColumn);
+    MPI_Type_create_resized(ProcColumn, 0, sizeof(int), &RecvColumn);
+    MPI_Type_commit(&RecvColumn);
+    MPI_Scatterv(matrix.data(), (*pSendNum).data(), (*pSendInd).data()
+    , SendColumn, (*pProcColumns).data(), ColumnNum, RecvColumn, 0, MPI_COMM_WORLD);
+    MPI_Type_free(&Column);
+    MPI_Type_free(&SendColumn);
+    MPI_Type_free(&ProcColumn);
+    MPI_Type_free(&RecvColumn);
 }
 void CreateRandomMatrix(std::vector<int>* matrix, int row_num, int column_num) {
     std::random_device dev;
@@ -88,12 +96,14 @@ void CreateRandomMatrix(std::vector<int>* matrix, int row_num, int column_num) {
 }
 void ColumnSumsSequenceally(int ProcRank, int ProcSize, const std::vector<int>* pProcColumns
 , std::vector<int>* pProcResults, int row_num, int ColumnNum) {
-    for (int i = 0; i < ColumnNum; i++) {
-        int sum = 0;
-        for (int j = 0; j < row_num; j++) {
-            sum += (*pProcColumns)[i * row_num + j];
+    // The block is row-major: each row is added to the sums in one contiguous pass.
+    std::fill((*pProcResults).begin(), (*pProcResults).begin() + ColumnNum, 0);
+    int* sums = (*pProcResults).data();
+    for (int j = 0; j < row_num; j++) {
+        const int* row = (*pProcColumns).data() + j * ColumnNum;
+        for (int i = 0; i < ColumnNum; i++) {
+            sums[i] += row[i];
         }
-        (*pProcResults)[i] = sum;
     }
 }
 void ColumnSumsParallel(int ProcRank, int ProcSize, std::vector<int>* pSendInd, std::vector<int>* pSendNum
@@ -114,13 +124,11 @@ void ColumnSumsParallel(int ProcRank, int ProcSize, std::vector<int>* pSendInd,
     , (*pSendInd).data(), MPI_INT, 0, MPI_COMM_WORLD);
 }
 std::vector<int>SequencallSum(std::vector<int>* matrix, int row_num, int column_num) {
-    std::vector<int>result;
-    for (int i = 0; i < column_num; i++) {
-        int sum = 0;
-        for (int j = 0; j < row_num; j++) {
-             sum +=  (*matrix)[j * column_num + i];
+    std::vector<int>result(column_num, 0);
+    for (int j = 0; j < row_num; j++) {
+        for (int i = 0; i < column_num; i++) {
+             result[i] += (*matrix)[j * column_num + i];
         }
-        result.push_back(sum);
     }
     return result;
 }
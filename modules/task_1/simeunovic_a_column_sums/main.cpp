@@ -29,6 +29,34 @@ TEST(Column_Sums, Test_example5) {
     DoWork(&a, &b);
     ASSERT_EQ(a, b);
 }
+TEST(Column_Sums, Test_row_major_distribution) {
+    int ProcRank, ProcSize;
+    MPI_Comm_size(MPI_COMM_WORLD, &ProcSize);
+    MPI_Comm_rank(MPI_COMM_WORLD, &ProcRank);
+    const int row_num = 1000, column_num = 5;
+    std::vector<int>matrix, result(column_num), pSendInd, pSendNum;
+    if (ProcRank == 0) {
+        for (int i = 0; i < row_num * column_num; i++) {
+            matrix.push_back(i % column_num + 1);
+        }
+    }
+    int RestColumns = column_num;
+    for (int i = 0; i < ProcRank; i++) {
+        RestColumns = RestColumns - RestColumns / (ProcSize - i);
+    }
+    int ColumnNum = RestColumns / (ProcSize - ProcRank);
+    std::vector<int>pProcColumns(ColumnNum * row_num), pProcResults(ColumnNum);
+    DataDistribution(ProcSize, ProcRank, &pSendInd, &pSendNum, matrix, &pProcColumns, row_num, column_num);
+    for (int i = 0; i < ColumnNum * row_num; i++) {
+        ASSERT_EQ(pSendInd[ProcRank] + i % ColumnNum + 1, pProcColumns[i]);
+    }
+    ColumnSumsParallel(ProcRank, ProcSize, &pSendInd
+    , &pSendNum, &result, pProcColumns, &pProcResults, row_num, column_num, ColumnNum);
+    if (ProcRank == 0) {
+        ASSERT_EQ(SequencallSum(&matrix, row_num, column_num), result);
+        ASSERT_EQ(row_num * column_num, result[column_num - 1]);
+    }
+}
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     MPI_Init(&argc, &argv);
@@ -60,6 +60,28 @@ TEST(Parallel_Operations_MPI, int_with_neg_border) {
     }
 }
 
+TEST(Parallel_Operations_MPI, adapt_int_narrow_peak) {
+    int rank, n = 0;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    auto peak = [](double x) { return 1 / (1e-4 + (x - 1.3) * (x - 1.3)); };
+    const double exact = (atan(170.0) + atan(130.0)) / 0.01;
+
+    double p_res = paralAdaptInt(0, 3, peak, 1e-8, &n);
+    ASSERT_NEAR(p_res, exact, 1e-7);
+    ASSERT_LT(n, 5000);
+    if (rank == 0) {
+        double ord_res = ordinaryInt(0, 3, [](double x) {
+            return 1 / (1e-4 + (x - 1.3) * (x - 1.3)); }, n);
+        ASSERT_GT(std::fabs(ord_res - exact), 1e-6);
+        ASSERT_NEAR(adaptInt(0, 3, peak, 1e-8), exact, 1e-7);
+    }
+}
+
+TEST(Parallel_Operations_MPI, adapt_int_sin) {
+    double p_res = paralAdaptInt(0, 500, sinus, 1e-10);
+    ASSERT_NEAR(p_res, 1 - cos(500.0), 1e-9);
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     MPI_Init(&argc, &argv);
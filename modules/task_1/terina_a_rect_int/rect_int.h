@@ -1,8 +1,145 @@
 // Copyright 2022 Terina Alina
 #pragma once
+#include <mpi.h>
+#include <cmath>
+#include <queue>
+#include <vector>
+
 double twox(double x);
 double triplex(double x);
 double cosinus(double x);
 double sinus(double x);
 double ordinaryInt(double a, double b, double (*fotx)(double), int n);
 double paralInt(double a, double b, double (*fotx)(double), int n);
+
+// Piece of [a, b] with its 15-point Kronrod value and error estimate, the
+// difference from the 7-point Gauss value on the same nodes
+struct Piece {
+    double a;
+    double b;
+    double val;
+    double err;
+    bool operator<(const Piece& p) const { return err < p.err; }
+};
+
+const int maxPieces = 65536;
+
+template <typename Func>
+Piece kronrod15(Func fotx, double a, double b) {
+    static const double x[8] = {
+        0.991455371120812639206854697526329, 0.949107912342758524526189684047851,
+        0.864864423359769072789712788640926, 0.741531185599394439863864773280788,
+        0.586087235467691130294144845693013, 0.405845151377397166906606412076961,
+        0.207784955007898467600689403773245, 0.0};
+    static const double wk[8] = {
+        0.022935322010529224963732008058970, 0.063092092629978553290700663189204,
+        0.104790010322250183839876322541518, 0.140653259715525918745189590510238,
+        0.169004726639267902826583426598550, 0.190350578064785409913256402421014,
+        0.204432940075298892414161999234649, 0.209482141084727828012999174891714};
+    static const double wg[4] = {
+        0.129484966168869693270611432679082, 0.279705391489276667901467771423780,
+        0.381830050505118944950369775488975, 0.417959183673469387755102040816327};
+
+    const double c = (a + b) / 2, h = (b - a) / 2;
+    const double fc = fotx(c);
+    double k = fc * wk[7], g = fc * wg[3];
+    for (int i = 0; i < 7; i++) {
+        const double z = fotx(c - h * x[i]) + fotx(c + h * x[i]);
+        k += z * wk[i];
+        if (i % 2 == 1) g += z * wg[i / 2];
+    }
+    return Piece{a, b, k * h, std::fabs((k - g) * h)};
+}
+
+// Adaptive G7K15: the piece with the largest error is halved until the
+// total error is at most eps. n gets the number of fotx calls.
+template <typename Func>
+double adaptInt(double a, double b, Func fotx, double eps, int* n = nullptr) {
+    std::priority_queue<Piece> q;
+    q.push(kronrod15(fotx, a, b));
+    double err = q.top().err;
+    while (err > eps && static_cast<int>(q.size()) < maxPieces) {
+        const Piece p = q.top();
+        q.pop();
+        const double m = (p.a + p.b) / 2;
+        const Piece l = kronrod15(fotx, p.a, m), r = kronrod15(fotx, m, p.b);
+        err += l.err + r.err - p.err;
+        q.push(l);
+        q.push(r);
+    }
+
+    if (n != nullptr) *n = 15 * (2 * static_cast<int>(q.size()) - 1);
+    double z = 0;
+    for (; !q.empty(); q.pop()) z += q.top().val;
+    return z;
+}
+
+// Parallel adaptInt. Rank 0 keeps the pieces and hands the worst one to
+// every rank that becomes free, the other ranks halve them. The result
+// is returned on every rank.
+template <typename Func>
+double paralAdaptInt(double a, double b, Func fotx, double eps,
+    int* n = nullptr) {
+    const int work = 0, stop = 1;
+    int shag, rank;
+    MPI_Comm_size(MPI_COMM_WORLD, &shag);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    if (shag == 1) return adaptInt(a, b, fotx, eps, n);
+
+    double final_res[2] = {0, 0};
+    if (rank != 0) {
+        double ab[2];
+        MPI_Status st;
+        while (true) {
+            MPI_Recv(ab, 2, MPI_DOUBLE, 0, MPI_ANY_TAG, MPI_COMM_WORLD, &st);
+            if (st.MPI_TAG == stop) break;
+            const double m = (ab[0] + ab[1]) / 2;
+            const Piece l = kronrod15(fotx, ab[0], m);
+            const Piece r = kronrod15(fotx, m, ab[1]);
+            double res[4] = {l.val, l.err, r.val, r.err};
+            MPI_Send(res, 4, MPI_DOUBLE, 0, work, MPI_COMM_WORLD);
+        }
+    } else {
+        std::priority_queue<Piece> q;
+        q.push(kronrod15(fotx, a, b));
+        double err = q.top().err;
+        int cnt = 1;
+        std::vector<Piece> sent(shag);
+        std::vector<int> freeRanks;
+        for (int i = shag - 1; i > 0; i--) freeRanks.push_back(i);
+
+        while (true) {
+            while (!freeRanks.empty() && !q.empty() && err > eps &&
+                cnt < maxPieces) {
+                const int to = freeRanks.back();
+                freeRanks.pop_back();
+                sent[to] = q.top();
+                q.pop();
+                double ab[2] = {sent[to].a, sent[to].b};
+                MPI_Send(ab, 2, MPI_DOUBLE, to, work, MPI_COMM_WORLD);
+                cnt++;
+            }
+            if (static_cast<int>(freeRanks.size()) == shag - 1) break;
+
+            double res[4];
+            MPI_Status st;
+            MPI_Recv(res, 4, MPI_DOUBLE, MPI_ANY_SOURCE, work, MPI_COMM_WORLD,
+                &st);
+            const Piece& p = sent[st.MPI_SOURCE];
+            const double m = (p.a + p.b) / 2;
+            q.push(Piece{p.a, m, res[0], res[1]});
+            q.push(Piece{m, p.b, res[2], res[3]});
+            err += res[1] + res[3] - p.err;
+            freeRanks.push_back(st.MPI_SOURCE);
+        }
+
+        for (int i = 1; i < shag; i++)
+            MPI_Send(nullptr, 0, MPI_DOUBLE, i, stop, MPI_COMM_WORLD);
+        for (; !q.empty(); q.pop()) final_res[0] += q.top().val;
+        final_res[1] = 15 * (2 * cnt - 1);
+    }
+
+    MPI_Bcast(final_res, 2, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    if (n != nullptr) *n = static_cast<int>(final_res[1]);
+    return final_res[0];
+}
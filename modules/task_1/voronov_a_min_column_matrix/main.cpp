@@ -1,6 +1,8 @@
 // Copyright 2022 Voronov Alexander
 
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <vector>
 #include "./min_column_matrix.h"
 #include <gtest-mpi-listener.hpp>
 
@@ -202,7 +204,48 @@ TEST(Min_Columns_MPI, Test_On_Size_51) {
     }
 }
 
+TEST(Min_Columns_MPI, Test_On_Rectangular_Matrix) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    std::vector<int> Matrix;
+
+    if (rank == 0) {
+        Matrix = GetRandomMatrix(300, 7);
+    }
+
+    std::vector<int> result_parall = GetParallelMinValueColumn(Matrix, 300, 7);
+
+    if (rank == 0) {
+        for (int j = 0; j < 7; j++) {
+            int min = Matrix[j];
+            for (int i = 1; i < 300; i++)
+                min = std::min(min, Matrix[i * 7 + j]);
+            ASSERT_EQ(min, result_parall[j]);
+        }
+    }
+}
+
+TEST(Min_Columns_MPI, Test_Scatter_Column_Blocks) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    const int rows = 3, columns = 5;
+    std::vector<int> Matrix;
 
+    if (rank == 0) {
+        for (int i = 0; i < rows * columns; i++)
+            Matrix.push_back(i);
+    }
+
+    std::vector<int> counts, displs;
+    std::vector<int> block = ScatterColumnBlocks(Matrix, rows, columns, &counts, &displs);
+
+    ASSERT_EQ(rows * counts[rank], static_cast<int>(block.size()));
+    for (int i = 0; i < rows; i++)
+        for (int j = 0; j < counts[rank]; j++)
+            ASSERT_EQ(i * columns + displs[rank] + j, block[i * counts[rank] + j]);
+}
 
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
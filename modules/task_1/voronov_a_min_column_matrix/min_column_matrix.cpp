@@ -49,17 +49,64 @@ std::vector <int> GetSequentialMinValueColumn(std::vector <int> Matrix, int rows
     if (rows*columns != static_cast<int>(Matrix.size()))
         throw - 1;
 
-    std::vector <int> result(columns);
+    return GetMinValueRows(Matrix.data(), rows, columns);
+}
 
-    std::vector <int> tr_matrix = GetTransposeMatrix(Matrix, rows, columns);
+std::vector <int> GetMinValueRows(const int* Block, int rows, int columns) {
+    if (columns == 0)
+        return std::vector <int>();
 
-    for (int i = 0; i < columns; i++)
-        result[i] = *min_element(tr_matrix.begin() + i * rows, tr_matrix.begin() + (i + 1) * rows);
+    // one pass over the rows, the compiler vectorizes the inner loop
+    std::vector <int> result(Block, Block + columns);
+    for (int i = 1; i < rows; i++) {
+        const int* row = Block + i * columns;
+        for (int j = 0; j < columns; j++)
+            result[j] = std::min(result[j], row[j]);
+    }
 
     return result;
 }
 
-std::vector <int> GetParallelMinValueColumn(std::vector <int> Matrix, int rows, int columns) {
+std::vector <int> ScatterColumnBlocks(const std::vector <int>& Matrix, int rows, int columns,
+                                      std::vector <int>* counts, std::vector <int>* displs) {
+    int size, rank;
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    counts->resize(size);
+    displs->resize(size);
+    for (int i = 0; i < size; i++) {
+        (*displs)[i] = columns / size * i + std::min(i, columns % size);
+        (*counts)[i] = columns / size + (i < columns % size ? 1 : 0);
+    }
+    const int local_columns = (*counts)[rank];
+
+    // one column of the row-major matrix, its extent is one element so that
+    // column j starts at displacement j
+    MPI_Datatype column, send_column;
+    MPI_Type_vector(rows, 1, columns, MPI_INT, &column);
+    MPI_Type_create_resized(column, 0, sizeof(int), &send_column);
+    MPI_Type_commit(&send_column);
+
+    // the received columns are placed into a row-major block of local_columns
+    MPI_Datatype local_column, recv_column;
+    MPI_Type_vector(rows, 1, std::max(local_columns, 1), MPI_INT, &local_column);
+    MPI_Type_create_resized(local_column, 0, sizeof(int), &recv_column);
+    MPI_Type_commit(&recv_column);
+
+    std::vector <int> block(rows * local_columns);
+    MPI_Scatterv(rank == 0 ? Matrix.data() : nullptr, counts->data(), displs->data(), send_column,
+                 block.data(), local_columns, recv_column, 0, MPI_COMM_WORLD);
+
+    MPI_Type_free(&column);
+    MPI_Type_free(&send_column);
+    MPI_Type_free(&local_column);
+    MPI_Type_free(&recv_column);
+
+    return block;
+}
+
+std::vector <int> GetParallelMinValueColumn(const std::vector <int>& Matrix, int rows, int columns) {
     int size, rank;
     MPI_Comm_size(MPI_COMM_WORLD, &size);
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
@@ -79,55 +126,16 @@ std::vector <int> GetParallelMinValueColumn(std::vector <int> Matrix, int rows,
     if (Error == 1)
         throw - 1;
 
-    const int delta = columns / size;
-    const int delta_rem = columns % size;
+    // the column blocks go straight out of the row-major matrix, no transpose
+    std::vector <int> counts, displs;
+    std::vector <int> block = ScatterColumnBlocks(Matrix, rows, columns, &counts, &displs);
+    std::vector <int> local_result = GetMinValueRows(block.data(), rows, counts[rank]);
 
     std::vector <int> result;
-
-    std::vector <int> local_columns(delta*rows);
-    std::vector <int> local_columns0;
-
-    if (rank == 0) {
-        std::vector<int> tr_matrix;
-        tr_matrix = GetTransposeMatrix(Matrix, rows, columns);
-
-        if (delta > 0) {
-            for (int i = 0; i < size - 1; i++)
-                MPI_Send(&tr_matrix[(delta+delta_rem)*rows] + delta * rows * i,
-                                    delta*rows, MPI_INT, i + 1, 2, MPI_COMM_WORLD);
-        }
-        local_columns0 = std::vector<int>(tr_matrix.begin(), tr_matrix.begin() + (delta + delta_rem)*rows);
-    } else {
-        MPI_Status status;
-        if (delta > 0)
-            MPI_Recv(&local_columns[0], delta*rows, MPI_INT, 0, 2, MPI_COMM_WORLD, &status);
-    }
-
-    if (rank == 0) {
-        for (int i = 0; i < delta_rem + delta; i++)
-            result.push_back(*min_element(local_columns0.begin() + i * rows,
-                                        local_columns0.begin() + (i + 1) * rows));
-
-        if (delta > 0) {
-            std::vector <int> local_result(delta);
-            for (int i = 1; i < size; i++) {
-                MPI_Status status;
-                MPI_Recv(&local_result[0], delta, MPI_INT, i, 3, MPI_COMM_WORLD, &status);
-                result.insert(result.end(), local_result.begin(), local_result.end());
-            }
-        }
-    } else {
-        if (delta > 0) {
-            std::vector <int> local_result(delta);
-            for (int i = 0; i < delta; i++) {
-                local_result[i] = *min_element(local_columns.begin() + i * rows,
-                    local_columns.begin() + (i + 1) * rows);
-            }
-            MPI_Send(&local_result[0], delta, MPI_INT, 0, 3, MPI_COMM_WORLD);
-        }
-    }
+    if (rank == 0)
+        result.resize(columns);
+    MPI_Gatherv(local_result.data(), counts[rank], MPI_INT, result.data(), counts.data(), displs.data(),
+                MPI_INT, 0, MPI_COMM_WORLD);
 
     return result;
 }
-
-
@@ -10,7 +10,15 @@ std::vector <int> GetTransposeMatrix(std::vector <int> Matrix, int rows, int col
 
 std::vector <int> GetSequentialMinValueColumn(std::vector <int> Matrix, int rows, int columns);
 
-std::vector <int> GetParallelMinValueColumn(std::vector <int> Matrix, int rows, int columns);
+// Minimum of every column of a row-major block, read row by row.
+std::vector <int> GetMinValueRows(const int* Block, int rows, int columns);
+
+// Scatters contiguous column blocks of the row-major matrix on rank 0,
+// every process receives its block row-major.
+std::vector <int> ScatterColumnBlocks(const std::vector <int>& Matrix, int rows, int columns,
+                                      std::vector <int>* counts, std::vector <int>* displs);
+
+std::vector <int> GetParallelMinValueColumn(const std::vector <int>& Matrix, int rows, int columns);
 
 #endif  // MODULES_TASK_1_VORONOV_A_MIN_COLUMN_MATRIX_MIN_COLUMN_MATRIX_H_
 
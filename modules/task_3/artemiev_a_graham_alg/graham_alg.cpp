@@ -30,17 +30,40 @@ void printPoints(const std::vector<double>& points) {
     std::cout << "]";
 }
 
+Points::Points(const std::vector<double>& interleaved)
+    : x(interleaved.size() / 2), y(interleaved.size() / 2) {
+    for (size_t i = 0; i < x.size(); i++) {
+        x[i] = interleaved[2 * i];
+        y[i] = interleaved[2 * i + 1];
+    }
+}
+
+std::vector<double> Points::interleaved() const {
+    std::vector<double> res(2 * x.size());
+    for (size_t i = 0; i < x.size(); i++) {
+        res[2 * i] = x[i];
+        res[2 * i + 1] = y[i];
+    }
+    return res;
+}
+
 void sortPoints(std::vector<double>* points,
                 std::function<bool(double, double, double, double)> less) {
     int n = static_cast<int>(points->size()) / 2;
-    int i, j;
-    for (i = 0; i < n - 1; i++)
-        for (j = 0; j < n - i - 1; j++)
-            if (!less((*points)[2 * j], (*points)[2 * j + 1],
-                      (*points)[2 * j + 2], (*points)[2 * j + 3])) {
-                std::swap((*points)[2 * j], (*points)[2 * j + 2]);
-                std::swap((*points)[2 * j + 1], (*points)[2 * j + 3]);
-            }
+    std::vector<int> order(n);
+    for (int i = 0; i < n; i++) order[i] = i;
+
+    const std::vector<double>& p = *points;
+    std::stable_sort(order.begin(), order.end(), [&p, &less](int i, int j) {
+        return less(p[2 * i], p[2 * i + 1], p[2 * j], p[2 * j + 1]);
+    });
+
+    std::vector<double> sorted(2 * n);
+    for (int i = 0; i < n; i++) {
+        sorted[2 * i] = p[2 * order[i]];
+        sorted[2 * i + 1] = p[2 * order[i] + 1];
+    }
+    points->swap(sorted);
 }
 
 double rotate(double x1, double y1, double x2, double y2, double x3,
@@ -48,160 +71,312 @@ double rotate(double x1, double y1, double x2, double y2, double x3,
     return (x2 - x1) * (y3 - y2) - (y2 - y1) * (x3 - x2);
 }
 
-std::vector<double> grahamSequential(std::vector<double> points) {
-    std::vector<double> result;
-    int count = static_cast<int>(points.size()) / 2;
+namespace {
 
-    if (count < 2) throw "Count was < 2";
+// a + b = s + e exactly
+inline void twoSum(double a, double b, double* s, double* e) {
+    *s = a + b;
+    double bv = *s - a;
+    *e = (a - (*s - bv)) + (b - bv);
+}
+
+// a * b = p + e exactly
+inline void twoProduct(double a, double b, double* p, double* e) {
+    *p = a * b;
+    *e = std::fma(a, b, -*p);
+}
 
-    double xMin = points[0];
-    double yMin = points[1];
-    int minId = 0;
+// Adds b to the expansion h of non-overlapping components ordered by
+// magnitude (Shewchuk's Grow-Expansion)
+void growExpansion(std::vector<double>* h, double b) {
+    double q = b;
+    for (size_t i = 0; i < h->size(); i++) {
+        double s, e;
+        twoSum(q, (*h)[i], &s, &e);
+        (*h)[i] = e;
+        q = s;
+    }
+    h->push_back(q);
+}
 
-    // At first, we search (xMin, yMin) - point with minimum x and minimum y
-    for (int i = 2; i < 2 * count; i += 2)
-        if (points[i] < xMin || (points[i] == xMin && points[i + 1] < yMin)) {
-            xMin = points[i], yMin = points[i + 1];
-            minId = i;
+// Sign of (ax - cx) * (by - cy) - (ay - cy) * (bx - cx) computed exactly:
+// every difference is split into two doubles, every product into two
+// more, and the terms are summed into an expansion
+int orientationExact(double ax, double ay, double bx, double by, double cx,
+                     double cy) {
+    double d[4][2];
+    twoSum(ax, -cx, &d[0][0], &d[0][1]);
+    twoSum(by, -cy, &d[1][0], &d[1][1]);
+    twoSum(ay, -cy, &d[2][0], &d[2][1]);
+    twoSum(bx, -cx, &d[3][0], &d[3][1]);
+
+    std::vector<double> h;
+    for (int i = 0; i < 2; i++)
+        for (int j = 0; j < 2; j++) {
+            double p, e;
+            twoProduct(d[0][i], d[1][j], &p, &e);
+            growExpansion(&h, p);
+            growExpansion(&h, e);
+            twoProduct(d[2][i], d[3][j], &p, &e);
+            growExpansion(&h, -p);
+            growExpansion(&h, -e);
         }
 
-    // std::cout << "\nxMin = " << xMin << ", yMin = " << yMin << '\n';
-
-    // Exclude (xMin, yMin) from our points
-    std::swap(points[minId], points[2 * count - 2]);
-    std::swap(points[minId + 1], points[2 * count - 1]);
-    points.pop_back(), points.pop_back();
-
-    auto lessFunc = [xMin, yMin](double x1, double y1, double x2, double y2) {
-        // Vector v1 coordinates
-        double v1x = x1 - xMin;
-        double v1y = y1 - yMin;
-        // Vector v2 coordinates
-        double v2x = x2 - xMin;
-        double v2y = y2 - yMin;
-
-        // Performing comparison by det
-        double det = v1x * v2y - v1y * v2x;
-
-        if (det > 0) {
-            // v1 < v2 by det
-            return true;
-        } else if (det == 0) {
-            // v1 == v2 by det. Let's compare by length of vectors
-            double len_v1 = sqrt(pow(v1x, 2) + pow(v1y, 2));
-            double len_v2 = sqrt(pow(v2x, 2) + pow(v2y, 2));
-
-            return len_v1 < len_v2;
-        } else {
-            // v1 > v2 by det
-            return false;
+    for (int i = static_cast<int>(h.size()) - 1; i >= 0; i--)
+        if (h[i] != 0) return h[i] > 0 ? 1 : -1;
+    return 0;
+}
+
+}  // namespace
+
+int orientation(double ax, double ay, double bx, double by, double cx,
+                double cy) {
+    // Shewchuk's error bound of the floating-point determinant
+    const double epsilon = std::ldexp(1.0, -53);
+    const double errBound = (3.0 + 16.0 * epsilon) * epsilon;
+
+    double detLeft = (ax - cx) * (by - cy);
+    double detRight = (ay - cy) * (bx - cx);
+    double det = detLeft - detRight;
+    if (std::abs(det) > errBound * (std::abs(detLeft) + std::abs(detRight)))
+        return det > 0 ? 1 : -1;
+    return orientationExact(ax, ay, bx, by, cx, cy);
+}
+
+namespace {
+
+bool lexLess(const Points& p, int i, int j) {
+    return p.x[i] < p.x[j] || (p.x[i] == p.x[j] && p.y[i] < p.y[j]);
+}
+
+Points gather(const Points& points, const std::vector<int>& order) {
+    Points res;
+    res.x.resize(order.size());
+    res.y.resize(order.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        res.x[i] = points.x[order[i]];
+        res.y[i] = points.y[order[i]];
+    }
+    return res;
+}
+
+// Hull of points already sorted by (x, y): lower chain from left to
+// right, then upper chain back
+Points monotoneChain(const Points& sorted) {
+    const int n = sorted.size();
+    const std::vector<double>& x = sorted.x;
+    const std::vector<double>& y = sorted.y;
+
+    std::vector<int> chain(2 * n + 1);
+    int k = 0;
+    for (int i = 0; i < n; i++) {
+        while (k >= 2 && orientation(x[chain[k - 2]], y[chain[k - 2]],
+                                     x[chain[k - 1]], y[chain[k - 1]],
+                                     x[i], y[i]) <= 0)
+            k--;
+        chain[k++] = i;
+    }
+    for (int i = n - 2, lower = k + 1; i >= 0; i--) {
+        while (k >= lower && orientation(x[chain[k - 2]], y[chain[k - 2]],
+                                         x[chain[k - 1]], y[chain[k - 1]],
+                                         x[i], y[i]) <= 0)
+            k--;
+        chain[k++] = i;
+    }
+
+    chain.resize(n > 1 ? k - 1 : n);
+    return gather(sorted, chain);
+}
+
+// Appends the indices [offset, offset + count) of a hull from
+// monotoneChain() to order, sorted by (x, y). The lower chain is already
+// sorted and the upper chain is sorted backwards, so they are merged.
+void appendSorted(const Points& all, int offset, int count,
+                  std::vector<int>* order) {
+    if (count == 0) return;
+    auto less = [&all](int i, int j) { return lexLess(all, i, j); };
+    int right = 0;
+    while (right + 1 < count && less(offset + right, offset + right + 1))
+        right++;
+
+    std::vector<int> lower, upper;
+    for (int i = 0; i <= right; i++) lower.push_back(offset + i);
+    for (int i = count - 1; i > right; i--) upper.push_back(offset + i);
+
+    std::vector<int> sorted(lower.size() + upper.size());
+    std::merge(lower.begin(), lower.end(), upper.begin(), upper.end(),
+               sorted.begin(), less);
+    order->insert(order->end(), sorted.begin(), sorted.end());
+}
+
+// Extreme points in the directions -y, x - y, x, x + y, y, y - x, -x and
+// -x - y, so they go counter-clockwise. The last value tells whether the
+// points exist, processes without points send 0 there.
+const int extremeCount = 8;
+const int extremeSize = 2 * extremeCount + 1;
+
+double directionKey(int dir, double x, double y) {
+    switch (dir) {
+        case 0: return -y;
+        case 1: return x - y;
+        case 2: return x;
+        case 3: return x + y;
+        case 4: return y;
+        case 5: return y - x;
+        case 6: return -x;
+        default: return -x - y;
+    }
+}
+
+// Ties are broken by (x, y), so the reduction does not depend on the
+// order of its operands
+bool further(int dir, double x1, double y1, double x2, double y2) {
+    double k1 = directionKey(dir, x1, y1);
+    double k2 = directionKey(dir, x2, y2);
+    if (k1 != k2) return k1 > k2;
+    return x1 < x2 || (x1 == x2 && y1 < y2);
+}
+
+void mergeExtremes(const double* in, double* inout) {
+    if (in[extremeSize - 1] == 0) return;
+    if (inout[extremeSize - 1] == 0) {
+        std::copy(in, in + extremeSize, inout);
+        return;
+    }
+    for (int dir = 0; dir < extremeCount; dir++)
+        if (further(dir, in[2 * dir], in[2 * dir + 1], inout[2 * dir],
+                    inout[2 * dir + 1])) {
+            inout[2 * dir] = in[2 * dir];
+            inout[2 * dir + 1] = in[2 * dir + 1];
         }
-    };
-
-    // And sort other points in counter-clockwise order
-    sortPoints(&points, lessFunc);
-
-    // Then we perform Graham scan
-    // (xMin, yMin) and (points[0], points[1])
-    // are the first points of our convex hull
-    result.push_back(xMin), result.push_back(yMin);
-    result.push_back(points[0]), result.push_back(points[1]);
-
-    for (int i = 2; i < 2 * count - 2; i += 2) {
-        int sz = static_cast<int>(result.size());
-
-        // p1
-        double x1 = result[sz - 4];
-        double y1 = result[sz - 3];
-        // p2
-        double x2 = result[sz - 2];
-        double y2 = result[sz - 1];
-        // p3
-        double x3 = points[i];
-        double y3 = points[i + 1];
-
-        double rot = rotate(x1, y1, x2, y2, x3, y3);
-        // p1, p2, p3 on one line -> replacing p2 with p3
-        if (rot == 0) {
-            result[sz - 2] = x3;
-            result[sz - 1] = y3;
-        } else if (rot < 0) {
-            // While p1, p2, p3 form right turn -> excluding p2
-            while (rotate(result[static_cast<int>(result.size()) - 4],
-                          result[static_cast<int>(result.size()) - 3],
-                          result[static_cast<int>(result.size()) - 2],
-                          result[static_cast<int>(result.size()) - 1], x3,
-                          y3) < 0)
-                result.pop_back(), result.pop_back();
-            result.push_back(x3);
-            result.push_back(y3);
-        } else {
-            // left turns are ok - just adding p3 to our result
-            result.push_back(x3);
-            result.push_back(y3);
+}
+
+void extremesOp(void* in, void* inout, int* len, MPI_Datatype*) {
+    for (int i = 0; i < *len; i++)
+        mergeExtremes(static_cast<double*>(in) + i * extremeSize,
+                      static_cast<double*>(inout) + i * extremeSize);
+}
+
+std::vector<double> localExtremes(const Points& points) {
+    std::vector<double> res(extremeSize, 0);
+    std::vector<double> single(extremeSize, 1);
+    for (int i = 0; i < points.size(); i++) {
+        for (int dir = 0; dir < extremeCount; dir++) {
+            single[2 * dir] = points.x[i];
+            single[2 * dir + 1] = points.y[i];
         }
+        mergeExtremes(single.data(), res.data());
     }
-
-    return result;
+    return res;
 }
 
-std::vector<double> grahamParallel(std::vector<double> points, int count) {
-    int comm_size, rank;
-    MPI_Comm_size(MPI_COMM_WORLD, &comm_size);
-    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+}  // namespace
 
-    // Every acting process processes at least 4 points
-    const int actingProcessesCount = std::min(comm_size, count / 4);
-    if (rank >= actingProcessesCount) return std::vector<double>(0);
+Points convexHull(const Points& points) {
+    std::vector<int> order(points.size());
+    for (int i = 0; i < points.size(); i++) order[i] = i;
+    std::sort(order.begin(), order.end(), [&points](int i, int j) {
+        return lexLess(points, i, j);
+    });
+    return monotoneChain(gather(points, order));
+}
 
-    const int q = count / actingProcessesCount;
-    const int rem = count % actingProcessesCount;
+Points mergeHulls(const Points& a, const Points& b) {
+    Points all = a;
+    all.x.insert(all.x.end(), b.x.begin(), b.x.end());
+    all.y.insert(all.y.end(), b.y.begin(), b.y.end());
 
-    std::vector<double> localPoints(2 * q);
-    std::vector<double> localResult;
+    std::vector<int> first, second;
+    appendSorted(all, 0, a.size(), &first);
+    appendSorted(all, a.size(), b.size(), &second);
 
-    if (rank == 0) {
-        localPoints =
-            std::vector<double>(points.begin(), points.begin() + 2 * (q + rem));
+    std::vector<int> order(all.size());
+    std::merge(first.begin(), first.end(), second.begin(), second.end(),
+               order.begin(),
+               [&all](int i, int j) { return lexLess(all, i, j); });
+    return monotoneChain(gather(all, order));
+}
 
-        // Distributing data to other active processes
-        for (int i = 1; i < actingProcessesCount; i++) {
-            MPI_Send(points.data() + 2 * (q + rem) + 2 * q * (i - 1), 2 * q, MPI_DOUBLE,
-                     i, 0, MPI_COMM_WORLD);
+Points filterInterior(const Points& points, const Points& polygon) {
+    const int m = polygon.size();
+    if (m < 3) return points;
+
+    Points res;
+    for (int i = 0; i < points.size(); i++) {
+        bool inside = true;
+        for (int j = 0; j < m && inside; j++) {
+            int next = j + 1 < m ? j + 1 : 0;
+            inside = orientation(polygon.x[j], polygon.y[j], polygon.x[next],
+                                 polygon.y[next], points.x[i],
+                                 points.y[i]) > 0;
+        }
+        if (!inside) {
+            res.x.push_back(points.x[i]);
+            res.y.push_back(points.y[i]);
         }
-    } else {
-        MPI_Status stat;
-        MPI_Recv(localPoints.data(), 2 * q, MPI_DOUBLE, 0, 0, MPI_COMM_WORLD,
-                 &stat);
     }
+    return res;
+}
 
-    localResult = grahamSequential(localPoints);
+std::vector<double> grahamSequential(std::vector<double> points) {
+    if (points.size() < 4) throw "Count was < 2";
+    return convexHull(Points(points)).interleaved();
+}
 
-    // Gathering all points on the root process
-    if (rank != 0) {
-        MPI_Send(localResult.data(), static_cast<int>(localResult.size()),
-                 MPI_DOUBLE, 0, 0, MPI_COMM_WORLD);
-    } else {
-        std::vector<double> processedPoints(2 * count);
-        int receivedCount = 0;
+std::vector<double> grahamParallel(std::vector<double> points, int count) {
+    int comm_size, rank;
+    MPI_Comm_size(MPI_COMM_WORLD, &comm_size);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
 
-        for (size_t i = 0; i < localResult.size(); i++)
-            processedPoints[i] = localResult[i];
-        receivedCount += localResult.size();
+    std::vector<int> counts(comm_size), displs(comm_size, 0);
+    for (int i = 0; i < comm_size; i++) {
+        counts[i] = 2 * (count / comm_size + (i < count % comm_size));
+        if (i > 0) displs[i] = displs[i - 1] + counts[i - 1];
+    }
 
-        for (int i = 1; i < actingProcessesCount; i++) {
+    std::vector<double> localPoints(counts[rank]);
+    MPI_Scatterv(points.data(), counts.data(), displs.data(), MPI_DOUBLE,
+                 localPoints.data(), counts[rank], MPI_DOUBLE, 0,
+                 MPI_COMM_WORLD);
+    Points local(localPoints);
+
+    // Akl-Toussaint heuristic: the points strictly inside the polygon of
+    // the extreme points are not on the hull
+    MPI_Datatype extremesType;
+    MPI_Type_contiguous(extremeSize, MPI_DOUBLE, &extremesType);
+    MPI_Type_commit(&extremesType);
+    MPI_Op op;
+    MPI_Op_create(extremesOp, 1, &op);
+
+    std::vector<double> extremes = localExtremes(local);
+    MPI_Allreduce(MPI_IN_PLACE, extremes.data(), 1, extremesType, op,
+                  MPI_COMM_WORLD);
+    MPI_Op_free(&op);
+    MPI_Type_free(&extremesType);
+
+    extremes.pop_back();
+    Points hull = convexHull(
+        filterInterior(local, convexHull(Points(extremes))));
+
+    // Binomial tree: at step s the process r + s sends its hull to r
+    for (int step = 1; step < comm_size; step *= 2) {
+        if (rank % (2 * step) == step) {
+            std::vector<double> buf = hull.interleaved();
+            MPI_Send(buf.data(), static_cast<int>(buf.size()), MPI_DOUBLE,
+                     rank - step, 0, MPI_COMM_WORLD);
+            return std::vector<double>(0);
+        }
+        if (rank + step < comm_size) {
             MPI_Status stat;
-            MPI_Recv(processedPoints.data() + receivedCount, 2 * q, MPI_DOUBLE, i,
-                     0, MPI_COMM_WORLD, &stat);
             int cnt = 0;
+            MPI_Probe(rank + step, 0, MPI_COMM_WORLD, &stat);
             MPI_Get_count(&stat, MPI_DOUBLE, &cnt);
-            receivedCount += cnt;
+            std::vector<double> buf(cnt);
+            MPI_Recv(buf.data(), cnt, MPI_DOUBLE, rank + step, 0,
+                     MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            hull = mergeHulls(hull, Points(buf));
         }
-
-        processedPoints.resize(receivedCount);
-
-        return grahamSequential(processedPoints);
     }
 
-    return std::vector<double>(0);
+    return hull.interleaved();
 }
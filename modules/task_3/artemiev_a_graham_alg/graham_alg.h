@@ -5,6 +5,18 @@
 #include <vector>
 #include <functional>
 
+// Points stored coordinate by coordinate. The interleaved form
+// [x1, y1, x2, y2, ...] is used by the public functions.
+struct Points {
+    std::vector<double> x;
+    std::vector<double> y;
+
+    Points() = default;
+    explicit Points(const std::vector<double>& interleaved);
+    std::vector<double> interleaved() const;
+    int size() const { return static_cast<int>(x.size()); }
+};
+
 std::vector<double> getRandomPoints(int count, double min = 0.0,
                                     double max = 100.0);
 
@@ -16,6 +28,22 @@ void sortPoints(std::vector<double>* points,
 double rotate(double x1, double y1, double x2, double y2, double x3,
               double y3);
 
+// Exact sign of rotate(): 1 for a left turn a -> b -> c, -1 for a right
+// turn and 0 if the points are collinear
+int orientation(double ax, double ay, double bx, double by, double cx,
+                double cy);
+
+// Andrew's monotone chain: the hull goes counter-clockwise from the
+// lowest of the leftmost points, collinear points are dropped
+Points convexHull(const Points& points);
+
+// Hull of the union of two hulls from convexHull() in linear time
+Points mergeHulls(const Points& a, const Points& b);
+
+// Points that are not strictly inside the convex polygon, which goes
+// counter-clockwise
+Points filterInterior(const Points& points, const Points& polygon);
+
 std::vector<double> grahamSequential(std::vector<double> points);
 std::vector<double> grahamParallel(std::vector<double> points, int count);
 
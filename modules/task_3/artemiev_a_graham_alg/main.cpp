@@ -46,6 +46,57 @@ TEST(GrahamAlg, GrahamAlg_5) { test(100); }
 
 TEST(GrahamAlg, GrahamAlg_6) { test(1000); }
 
+TEST(GrahamAlg, GrahamAlg_7) { test(100000); }
+
+TEST(GrahamAlg, Merge_Hulls) {
+    std::vector<double> a = getRandomPoints(300, 0, 60);
+    std::vector<double> b = getRandomPoints(300, 40, 100);
+    std::vector<double> all = a;
+    all.insert(all.end(), b.begin(), b.end());
+
+    Points merged = mergeHulls(convexHull(Points(a)), convexHull(Points(b)));
+    EXPECT_EQ(grahamSequential(all), merged.interleaved());
+}
+
+TEST(GrahamAlg, Filter_Keeps_Hull) {
+    std::vector<double> points = getRandomPoints(1000);
+    Points polygon(std::vector<double>{10, 10, 90, 10, 90, 90, 10, 90});
+    Points rest = filterInterior(Points(points), polygon);
+    EXPECT_LT(rest.size(), 1000);
+    EXPECT_EQ(grahamSequential(points),
+              grahamSequential(rest.interleaved()));
+}
+
+TEST(GrahamAlg, Orientation_Near_Collinear) {
+    // p = (0.5 + k * 2^-53, 0.5) lies below the diagonal for k > 0
+    for (int k = -64; k <= 64; k++) {
+        double px = 0.5 + k * std::ldexp(1.0, -53);
+        int expected = k > 0 ? -1 : (k < 0 ? 1 : 0);
+        EXPECT_EQ(expected, orientation(px, 0.5, 12, 12, 24, 24));
+    }
+}
+
+TEST(GrahamAlg, Collinear_Points_Dropped) {
+    std::vector<double> points;
+    for (int i = 0; i <= 4; i++) {
+        double sides[] = {0.0 + i, 0, 4, 0.0 + i, 4.0 - i, 4, 0, 4.0 - i};
+        points.insert(points.end(), sides, sides + 8);
+    }
+    points.push_back(2);
+    points.push_back(2);
+    int count = static_cast<int>(points.size()) / 2;
+
+    std::vector<double> parrResult = grahamParallel(points, count);
+
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    if (rank == 0) {
+        std::vector<double> square = {0, 0, 4, 0, 4, 4, 0, 4};
+        EXPECT_EQ(square, grahamSequential(points));
+        EXPECT_EQ(square, parrResult);
+    }
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     MPI_Init(&argc, &argv);
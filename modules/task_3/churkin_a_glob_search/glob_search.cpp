@@ -4,158 +4,172 @@
 #include <mpi.h>
 
 #include <algorithm>
+#include <cmath>
+#include <iterator>
 #include <limits>
+#include <unordered_map>
 #include <vector>
 
-auto idxCompareRule = [](const std::pair<double, int>& p1,
-                         const std::pair<double, int>& p2) {
-    return p1.first > p2.first;
-};
-
-double compute_M(const std::vector<double>& y,
-                 std::function<double(double)> f) {
-    double M = DOUBLE_MIN;
-    for (size_t i = 1; i < y.size(); i++) {
-        double z = f(y[i]), zPrev = f(y[i - 1]);
-        double curM = std::abs((z - zPrev) / (y[i] - y[i - 1]));
-        M = std::max(curM, M);
+TrialStore::TrialStore(double a, double za, double b, double zb, int dim,
+                       double reliability)
+    : M(0), power(1.0 / dim), rel(reliability) {
+    trials[a] = za;
+    trials[b] = zb;
+    M = std::abs(zb - za) / dist(a, b);
+    rebuild();
+}
+
+void TrialStore::insert(double x, double z) {
+    // the trial of a taken interval is back, so its parts may be taken again
+    auto owner = trials.upper_bound(x);
+    if (owner != trials.begin()) taken.erase(std::prev(owner)->first);
+
+    auto res = trials.insert(std::make_pair(x, z));
+    Iter it = res.first;
+    Iter next = std::next(it);
+    Iter prev = it == trials.begin() ? trials.end() : std::prev(it);
+
+    // for dim = 1 the slope of the split interval lies between the slopes
+    // of its parts, so the maximum over the adjacent pairs never decreases,
+    // otherwise M is the largest slope seen so far
+    double oldM = M;
+    if (res.second && prev != trials.end())
+        M = std::max(M, std::abs(z - prev->second) / dist(prev->first, x));
+    if (res.second && next != trials.end())
+        M = std::max(M, std::abs(next->second - z) / dist(x, next->first));
+
+    if (M != oldM) {
+        rebuild();
+    } else {
+        if (prev != trials.end()) push(prev);
+        push(it);
     }
-    return M;
 }
 
-std::vector<std::pair<double, int>> compute_R(const std::vector<double>& y,
-                                              std::function<double(double)> f,
-                                              double m) {
-    std::vector<std::pair<double, int>> R;
-    for (size_t i = 1; i < y.size(); i++) {
-        double z = f(y[i]);
-        double zPrev = f(y[i - 1]);
-        double dist = (y[i] - y[i - 1]);
-        double curR =
-            m * dist + (z - zPrev) * (z - zPrev) / (m * dist) - 2 * (z + zPrev);
-        R.push_back(std::make_pair(curR, i));
+bool TrialStore::pop(double* x0, double* z0, double* x1, double* z1) {
+    while (!queue.empty()) {
+        std::pop_heap(queue.begin(), queue.end());
+        Interval top = queue.back();
+        queue.pop_back();
+
+        // intervals split after they were pushed are skipped
+        Iter left = trials.find(top.x0);
+        if (left == trials.end()) continue;
+        Iter right = std::next(left);
+        if (right == trials.end() || right->first != top.x1) continue;
+        if (!taken.insert(left->first).second) continue;
+
+        *x0 = left->first;
+        *z0 = left->second;
+        *x1 = right->first;
+        *z1 = right->second;
+        return true;
     }
-    return R;
+    return false;
 }
 
-double compute_x(double y0, double y1, std::function<double(double)> f,
-                 double m) {
-    double z = f(y0);
-    double zPrev = f(y1);
-    return y0 + (y1 - y0) / 2.0 + (z - zPrev) / (2.0 * m);
+bool TrialStore::is_best(double x) const {
+    Iter right = trials.upper_bound(x);
+    if (right == trials.begin() || right == trials.end()) return false;
+    double R = characteristic(std::prev(right));
+    for (double x0 : taken)
+        if (characteristic(trials.find(x0)) > R) return false;
+    return queue.empty() || queue.front().R <= R;
 }
 
-double globalSearchOneDimSequential(std::function<double(double)> f, double a,
-                                    double b, double epsilon) {
-    std::vector<double> x;
-    x.push_back(a);
-    x.push_back(b);
+double TrialStore::characteristic(Iter left) const {
+    Iter right = std::next(left);
+    double m = get_m();
+    double z = right->second, zPrev = left->second;
+    double d = dist(left->first, right->first);
+    return m * d + (z - zPrev) * (z - zPrev) / (m * d) - 2 * (z + zPrev);
+}
 
-    while (x.size() < 65000) {
-        double M = compute_M(x, f);
-        double m = (M == 0) ? 1 : r * M;
-        std::vector<std::pair<double, int>> R = compute_R(x, f, m);
+void TrialStore::push(Iter left) {
+    Iter right = std::next(left);
+    if (right == trials.end() || taken.count(left->first)) return;
 
-        std::sort(R.begin(), R.end(), idxCompareRule);
+    queue.push_back({characteristic(left), left->first, right->first});
+    std::push_heap(queue.begin(), queue.end());
+}
 
-        size_t idxOfMaxR = R.front().second;
+// m has changed, so all characteristics are computed again
+void TrialStore::rebuild() {
+    queue.clear();
+    for (Iter it = trials.begin(); it != trials.end(); ++it) push(it);
+}
 
-        double newX = compute_x(x[idxOfMaxR - 1], x[idxOfMaxR], f, m);
+double compute_x(double y0, double z0, double y1, double z1, double m,
+                 int dim) {
+    if (dim == 1) return y0 + (y1 - y0) / 2.0 + (z0 - z1) / (2.0 * m);
+    double shift = std::pow(std::abs(z1 - z0) / m, dim) / 2.0;
+    return y0 + (y1 - y0) / 2.0 - (z1 > z0 ? shift : -shift);
+}
 
-        if (std::abs(newX - x[idxOfMaxR - 1]) < epsilon) return f(newX);
+Evolvent::Evolvent(const std::vector<double>& a, const std::vector<double>& b)
+    : a(a), b(b), bits(std::min(20, 52 / static_cast<int>(a.size()))) {}
 
-        x.insert(std::upper_bound(x.begin(), x.end(), newX), newX);
-    }
-    return DOUBLE_MAX;
+uint64_t Evolvent::index(double t) const {
+    const uint64_t cells = uint64_t(1) << (dim() * bits);
+    double h = std::floor(t * static_cast<double>(cells));
+    if (h < 0) return 0;
+    if (h >= static_cast<double>(cells)) return cells - 1;
+    return static_cast<uint64_t>(h);
 }
 
-double globalSearchOneDimParallel(std::function<double(double)> f, double a,
-                                  double b, double epsilon) {
-    int rank, proc_count;
-    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
-    MPI_Comm_size(MPI_COMM_WORLD, &proc_count);
-
-    std::vector<double> x;
-    x.push_back(a);
-    x.push_back(b);
-
-    int iterCounter = 0;
-    while (iterCounter < 65000) {
-        int activeProcsCount = proc_count;
-        std::vector<double> receivedData(3);
-
-        iterCounter += 1;
-
-        if (rank == 0) {
-            double M = compute_M(x, f);
-            double m = (M == 0) ? 1 : r * M;
-            std::vector<std::pair<double, int>> R = compute_R(x, f, m);
-
-            auto criteria = [](const std::pair<double, int>& p1,
-                               const std::pair<double, int>& p2) {
-                return p1.first > p2.first;
-            };
-            std::sort(R.begin(), R.end(), criteria);
-
-            int idxOfMaxR = R.front().second;
-            receivedData = {x[idxOfMaxR - 1], x[idxOfMaxR], m};
-
-            activeProcsCount =
-                std::min(static_cast<size_t>(proc_count), R.size());
-            for (int i = 1; i < activeProcsCount; i++) {
-                std::pair<double, int> RR = R[i];
-                std::vector<double> sendData = {x[RR.second - 1], x[RR.second],
-                                                m};
-                MPI_Send(sendData.data(), 3, MPI_DOUBLE, i, 0, MPI_COMM_WORLD);
+// Skilling's transform: the bits of h are spread over the coordinates in
+// turn from the top level, then the Gray code and the rotations of the
+// subcubes are undone.
+std::vector<double> Evolvent::point(uint64_t h) const {
+    const int n = dim();
+    std::vector<uint64_t> X(n, 0);
+    for (int level = bits - 1, pos = n * bits - 1; level >= 0; level--)
+        for (int i = 0; i < n; i++, pos--)
+            X[i] |= ((h >> pos) & 1) << level;
+
+    uint64_t t = X[n - 1] >> 1;
+    for (int i = n - 1; i > 0; i--) X[i] ^= X[i - 1];
+    X[0] ^= t;
+    for (uint64_t Q = 2; Q != (uint64_t(1) << bits); Q <<= 1) {
+        uint64_t P = Q - 1;
+        for (int i = n - 1; i >= 0; i--) {
+            if (X[i] & Q) {
+                X[0] ^= P;
+            } else {
+                t = (X[0] ^ X[i]) & P;
+                X[0] ^= t;
+                X[i] ^= t;
             }
         }
+    }
 
-        MPI_Bcast(&activeProcsCount, 1, MPI_INT, 0, MPI_COMM_WORLD);
-
-        if (rank != 0 && rank < activeProcsCount) {
-            MPI_Status status;
-            MPI_Recv(receivedData.data(), 3, MPI_DOUBLE, 0, 0, MPI_COMM_WORLD,
-                     &status);
-        }
-
-        bool hasResultFound = false;
-        double result = 0.0;
-        if (rank < activeProcsCount) {
-            double newX =
-                compute_x(receivedData[0], receivedData[1], f, receivedData[2]);
-
-            int state = NOT_FOUND;
-            if (std::abs(newX - receivedData[0]) < epsilon) state = FOUND;
+    std::vector<double> y(n);
+    const double side = static_cast<double>(uint64_t(1) << bits);
+    for (int i = 0; i < n; i++)
+        y[i] = a[i] + (b[i] - a[i]) * (static_cast<double>(X[i]) + 0.5) / side;
+    return y;
+}
 
-            if (rank != 0) {
-                MPI_Send(&newX, 1, MPI_DOUBLE, 0, state, MPI_COMM_WORLD);
-            } else {
-                for (int i = 1; i < activeProcsCount; i++) {
-                    double receivedNewX;
-                    MPI_Status status;
-                    MPI_Recv(&receivedNewX, 1, MPI_DOUBLE, i, MPI_ANY_TAG,
-                             MPI_COMM_WORLD, &status);
-
-                    if (status.MPI_TAG == FOUND) {
-                        result = receivedNewX;
-                        hasResultFound = true;
-                    }
-
-                    x.insert(std::upper_bound(x.begin(), x.end(), receivedNewX),
-                             receivedNewX);
-                }
-
-                if (state == FOUND) {
-                    result = newX;
-                    hasResultFound = true;
-                }
-
-                x.insert(std::upper_bound(x.begin(), x.end(), newX), newX);
-            }
+double globalSearchMultiDimParallel(
+    std::function<double(const std::vector<double>&)> f,
+    const std::vector<double>& a, const std::vector<double>& b,
+    double epsilon, std::vector<double>* argmin) {
+    Evolvent y(a, b);
+
+    // near the minimum many trials fall into the same cell of the curve
+    std::unordered_map<uint64_t, double> cache;
+    auto phi = [&f, &y, &cache](const double* ts, double* zs, int n) {
+        for (int i = 0; i < n; i++) {
+            uint64_t h = y.index(ts[i]);
+            auto it = cache.find(h);
+            if (it == cache.end())
+                it = cache.insert(std::make_pair(h, f(y.point(h)))).first;
+            zs[i] = it->second;
         }
+    };
 
-        MPI_Bcast(&hasResultFound, 1, MPI_BYTE, 0, MPI_COMM_WORLD);
-        if (hasResultFound) return f(result);
-    }
-    return DOUBLE_MAX;
+    double t = 0;
+    double result = parallelSearch(phi, 0, 1, epsilon, 1, y.dim(), &t);
+    if (argmin) *argmin = y(t);
+    return result;
 }
@@ -2,28 +2,366 @@
 #ifndef MODULES_TASK_3_CHURKIN_A_GLOB_SEARCH_GLOB_SEARCH_H_
 #define MODULES_TASK_3_CHURKIN_A_GLOB_SEARCH_GLOB_SEARCH_H_
 
+#include <mpi.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <limits>
+#include <map>
+#include <set>
 #include <utility>
 #include <vector>
 
-#define DOUBLE_MIN (std::numeric_limits<double>::min())
 #define DOUBLE_MAX (std::numeric_limits<double>::max())
 const double r = 2.0;
+// The async search takes new intervals while the trials of others are still
+// out, so its estimate of M lags behind more and needs a larger factor
+const double rAsync = 2.5;
 const int FOUND = 1;
 const int NOT_FOUND = 0;
+const int STOP = 2;
+
+// Trial points (x, f(x)) of the search ordered by x. The estimate M of
+// the Lipschitz constant and the characteristics R of the intervals are
+// updated only around the inserted point, so f is called once per point.
+// With dim > 1 the distances are |x1 - x0|^(1 / dim), as f is a function
+// of dim variables composed with a space-filling curve. An interval taken
+// by pop is not queued again, not even by a rebuild, until a point inside
+// it is inserted.
+class TrialStore {
+ public:
+    TrialStore(double a, double za, double b, double zb, int dim = 1,
+               double reliability = r);
+
+    void insert(double x, double z);
+    // Takes the interval with the largest R out of the queue, returns
+    // false if there are no intervals that are not taken already
+    bool pop(double* x0, double* z0, double* x1, double* z1);
+    // Whether the taken interval around x has the largest R of all the
+    // intervals, taken or queued
+    bool is_best(double x) const;
+    // m = reliability * M, or 1 while all trials have the same value
+    double get_m() const { return M == 0 ? 1 : rel * M; }
+    size_t size() const { return trials.size(); }
+
+ private:
+    struct Interval {
+        double R;
+        double x0;
+        double x1;
+        bool operator<(const Interval& other) const { return R < other.R; }
+    };
+    using Iter = std::map<double, double>::const_iterator;
+
+    double dist(double x0, double x1) const {
+        return std::pow(x1 - x0, power);
+    }
+    double characteristic(Iter left) const;
+    void push(Iter left);
+    void rebuild();
+
+    std::map<double, double> trials;
+    std::vector<Interval> queue;
+    // left ends of the intervals taken by pop whose trial is not inserted yet
+    std::set<double> taken;
+    double M;
+    double power;
+    double rel;
+};
+
+// Hilbert curve evolvent of the box [a, b]: maps t from [0, 1] to the
+// centre of the cell with number index(t) among 2^(dim * bits) cells.
+class Evolvent {
+ public:
+    Evolvent(const std::vector<double>& a, const std::vector<double>& b);
+
+    uint64_t index(double t) const;
+    std::vector<double> point(uint64_t h) const;
+    std::vector<double> operator()(double t) const { return point(index(t)); }
+    int dim() const { return static_cast<int>(a.size()); }
+
+ private:
+    std::vector<double> a, b;
+    int bits;
+};
+
+double compute_x(double y0, double z0, double y1, double z1, double m,
+                 int dim = 1);
+
+// Batch version of a function of one variable, the calls of f are
+// inlined into the loop
+template <class F>
+struct PointwiseBatch {
+    F f;
+    void operator()(const double* xs, double* ys, int n) const {
+        for (int i = 0; i < n; i++) ys[i] = f(xs[i]);
+    }
+};
+
+template <class F>
+double globalSearchOneDimSequential(F f, double a, double b, double epsilon) {
+    TrialStore trials(a, f(a), b, f(b));
+
+    double x0, z0, x1, z1;
+    while (trials.size() < 65000 && trials.pop(&x0, &z0, &x1, &z1)) {
+        double newX = compute_x(x0, z0, x1, z1, trials.get_m());
+
+        if (std::abs(newX - x0) < epsilon) return f(newX);
+
+        trials.insert(newX, f(newX));
+    }
+    return DOUBLE_MAX;
+}
+
+// Rank 0 takes up to batch best intervals for every rank, every rank
+// computes the new points of its intervals (x0, z0, x1, z1, m) and
+// evaluates them with one call of f. The results are (x, z, found).
+template <class Batch>
+double parallelSearch(const Batch& f, double a, double b, double epsilon,
+                      int batch, int dim, double* point) {
+    int rank, proc_count;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &proc_count);
+
+    double ends[2] = {a, b}, endValues[2] = {0.0, 0.0};
+    if (rank == 0) f(ends, endValues, 2);
+    TrialStore trials(a, endValues[0], b, endValues[1], dim);
+
+    std::vector<double> sendData(5 * batch), receivedData(5 * batch);
+    std::vector<double> xs(batch), zs(batch), results(3 * batch);
+
+    int iterCounter = 0;
+    while (iterCounter < 65000) {
+        int activeProcsCount = 0;
+        int count = 0;
+
+        iterCounter += 1;
+
+        if (rank == 0) {
+            double m = trials.get_m();
+            for (int proc = 0; proc < proc_count; proc++) {
+                int k = 0;
+                while (k < batch &&
+                       trials.pop(&sendData[5 * k], &sendData[5 * k + 1],
+                                  &sendData[5 * k + 2], &sendData[5 * k + 3]))
+                    sendData[5 * k++ + 4] = m;
+                if (k == 0) break;
+
+                if (proc == 0) {
+                    receivedData = sendData;
+                    count = k;
+                } else {
+                    MPI_Send(sendData.data(), 5 * k, MPI_DOUBLE, proc, 0,
+                             MPI_COMM_WORLD);
+                }
+                activeProcsCount++;
+            }
+        }
+
+        MPI_Bcast(&activeProcsCount, 1, MPI_INT, 0, MPI_COMM_WORLD);
+        if (activeProcsCount == 0) break;
+
+        if (rank != 0 && rank < activeProcsCount) {
+            MPI_Status status;
+            MPI_Recv(receivedData.data(), 5 * batch, MPI_DOUBLE, 0, 0,
+                     MPI_COMM_WORLD, &status);
+            MPI_Get_count(&status, MPI_DOUBLE, &count);
+            count /= 5;
+        }
+
+        bool hasResultFound = false;
+        double result[2] = {0.0, 0.0};
+        if (rank < activeProcsCount) {
+            for (int k = 0; k < count; k++)
+                xs[k] = compute_x(receivedData[5 * k], receivedData[5 * k + 1],
+                                  receivedData[5 * k + 2],
+                                  receivedData[5 * k + 3],
+                                  receivedData[5 * k + 4], dim);
+            f(xs.data(), zs.data(), count);
+            for (int k = 0; k < count; k++) {
+                results[3 * k] = xs[k];
+                results[3 * k + 1] = zs[k];
+                results[3 * k + 2] =
+                    std::pow(std::abs(xs[k] - receivedData[5 * k]),
+                             1.0 / dim) < epsilon ? FOUND : NOT_FOUND;
+            }
+
+            if (rank != 0) {
+                MPI_Send(results.data(), 3 * count, MPI_DOUBLE, 0, 0,
+                         MPI_COMM_WORLD);
+            } else {
+                std::vector<double> received(3 * batch);
+                for (int i = 0; i < activeProcsCount; i++) {
+                    int receivedCount = 3 * count;
+                    if (i == 0) {
+                        received = results;
+                    } else {
+                        MPI_Status status;
+                        MPI_Recv(received.data(), 3 * batch, MPI_DOUBLE, i, 0,
+                                 MPI_COMM_WORLD, &status);
+                        MPI_Get_count(&status, MPI_DOUBLE, &receivedCount);
+                    }
+
+                    for (int k = 0; k < receivedCount; k += 3) {
+                        if (received[k + 2] == FOUND && !hasResultFound) {
+                            result[0] = received[k];
+                            result[1] = received[k + 1];
+                            hasResultFound = true;
+                        }
+                        trials.insert(received[k], received[k + 1]);
+                    }
+                }
+            }
+        }
+
+        MPI_Bcast(&hasResultFound, 1, MPI_BYTE, 0, MPI_COMM_WORLD);
+        if (hasResultFound) {
+            MPI_Bcast(result, 2, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+            if (point) *point = result[0];
+            return result[1];
+        }
+    }
+    return DOUBLE_MAX;
+}
+
+// f(xs, ys, n) computes ys[i] = f(xs[i]) for i < n, so every iteration
+// each rank evaluates the new points of up to batch best intervals with
+// one call of f. The type of f is a template parameter, so f is called
+// directly and can be inlined.
+template <class Batch>
+double globalSearchOneDimParallelBatch(const Batch& f, double a, double b,
+                                       double epsilon, int batch = 1) {
+    return parallelSearch(f, a, b, epsilon, batch, 1, nullptr);
+}
+
+template <class F>
+double globalSearchOneDimParallel(F f, double a, double b, double epsilon,
+                                  int batch = 1) {
+    return globalSearchOneDimParallelBatch(PointwiseBatch<F>{f}, a, b,
+                                           epsilon, batch);
+}
+
+// Master-worker search: rank 0 keeps the trials and gives the best
+// intervals to a worker as soon as it returns its previous points.
+template <class Batch>
+double globalSearchOneDimAsyncBatch(const Batch& f, double a, double b,
+                                    double epsilon, int batch = 1) {
+    int rank, proc_count;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &proc_count);
+
+    if (proc_count == 1)
+        return parallelSearch(f, a, b, epsilon, batch, 1, nullptr);
+
+    double result = DOUBLE_MAX;
+    if (rank == 0) {
+        double ends[2] = {a, b}, endValues[2];
+        f(ends, endValues, 2);
+        TrialStore trials(a, endValues[0], b, endValues[1], 1, rAsync);
+        std::vector<double> sendData(5 * batch), received(3 * batch);
+        std::vector<char> busy(proc_count, 0);
+        int busyCount = 0;
+        bool stop = false;
+
+        auto dispatch = [&](int worker) {
+            int k = 0;
+            while (!stop && k < batch && trials.size() < 65000 &&
+                   trials.pop(&sendData[5 * k], &sendData[5 * k + 1],
+                              &sendData[5 * k + 2], &sendData[5 * k + 3]))
+                sendData[5 * k++ + 4] = trials.get_m();
+            if (k == 0) return;
+            MPI_Send(sendData.data(), 5 * k, MPI_DOUBLE, worker, 0,
+                     MPI_COMM_WORLD);
+            busy[worker] = 1;
+            busyCount++;
+        };
+
+        for (int i = 1; i < proc_count; i++) dispatch(i);
+
+        // the workers whose intervals were split by other points are
+        // given new intervals after every received batch
+        while (busyCount > 0) {
+            MPI_Status status;
+            int receivedCount;
+            MPI_Recv(received.data(), 3 * batch, MPI_DOUBLE, MPI_ANY_SOURCE,
+                     0, MPI_COMM_WORLD, &status);
+            MPI_Get_count(&status, MPI_DOUBLE, &receivedCount);
+            busy[status.MPI_SOURCE] = 0;
+            busyCount--;
+            if (stop) continue;
+
+            // a small interval only ends the search if it is still the
+            // best one, the better ones may be out at other workers
+            for (int k = 0; k < receivedCount; k += 3) {
+                if (received[k + 2] == FOUND && !stop &&
+                    trials.is_best(received[k])) {
+                    result = received[k + 1];
+                    stop = true;
+                }
+                trials.insert(received[k], received[k + 1]);
+            }
+            if (stop) continue;
+
+            dispatch(status.MPI_SOURCE);
+            for (int i = 1; i < proc_count; i++)
+                if (!busy[i]) dispatch(i);
+        }
 
-double compute_M(const std::vector<double>& y, std::function<double(double)> f);
+        std::vector<MPI_Request> requests(proc_count - 1);
+        for (int i = 1; i < proc_count; i++)
+            MPI_Isend(nullptr, 0, MPI_DOUBLE, i, STOP, MPI_COMM_WORLD,
+                      &requests[i - 1]);
+        MPI_Waitall(proc_count - 1, requests.data(), MPI_STATUSES_IGNORE);
+    } else {
+        std::vector<double> receivedData(5 * batch);
+        std::vector<double> xs(batch), zs(batch), results(3 * batch);
+        while (true) {
+            MPI_Status status;
+            int count;
+            MPI_Recv(receivedData.data(), 5 * batch, MPI_DOUBLE, 0,
+                     MPI_ANY_TAG, MPI_COMM_WORLD, &status);
+            if (status.MPI_TAG == STOP) break;
+            MPI_Get_count(&status, MPI_DOUBLE, &count);
+            count /= 5;
 
-std::vector<std::pair<double, int>> compute_R(const std::vector<double>& y,
-                                std::function<double(double)> f, double m);
+            for (int k = 0; k < count; k++)
+                xs[k] = compute_x(receivedData[5 * k], receivedData[5 * k + 1],
+                                  receivedData[5 * k + 2],
+                                  receivedData[5 * k + 3],
+                                  receivedData[5 * k + 4]);
+            f(xs.data(), zs.data(), count);
+            for (int k = 0; k < count; k++) {
+                results[3 * k] = xs[k];
+                results[3 * k + 1] = zs[k];
+                results[3 * k + 2] =
+                    std::abs(xs[k] - receivedData[5 * k]) < epsilon ? FOUND
+                                                                    : NOT_FOUND;
+            }
+            MPI_Send(results.data(), 3 * count, MPI_DOUBLE, 0, 0,
+                     MPI_COMM_WORLD);
+        }
+    }
 
-double compute_x(double y0, double y1, std::function<double(double)> f,
-                 double m);
+    MPI_Bcast(&result, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    return result;
+}
 
-double globalSearchOneDimSequential(std::function<double(double)> f, double a,
-                                    double b, double epsilon);
+template <class F>
+double globalSearchOneDimAsync(F f, double a, double b, double epsilon,
+                               int batch = 1) {
+    return globalSearchOneDimAsyncBatch(PointwiseBatch<F>{f}, a, b, epsilon,
+                                        batch);
+}
 
-double globalSearchOneDimParallel(std::function<double(double)> f, double a,
-                                  double b, double epsilon);
+// Minimum of f over the box [a, b] of a.size() dimensions. The parallel
+// search runs over the parameter of the Hilbert curve filling the box,
+// the values are cached per curve cell. The found point goes to argmin.
+double globalSearchMultiDimParallel(
+    std::function<double(const std::vector<double>&)> f,
+    const std::vector<double>& a, const std::vector<double>& b,
+    double epsilon, std::vector<double>* argmin = nullptr);
 
 #endif  // MODULES_TASK_3_CHURKIN_A_GLOB_SEARCH_GLOB_SEARCH_H_
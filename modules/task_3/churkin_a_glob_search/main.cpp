@@ -1,8 +1,12 @@
 // Copyright 2022 Churkin Alexander
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <iostream>
 #include <cmath>
+#include <random>
+#include <set>
+#include <vector>
 
 #include "./glob_search.h"
 
@@ -58,6 +62,158 @@ TEST(GlobalSearchOneDim, Test_5_sineX) {
     runTest(f, a, b, correctResult);
 }
 
+TEST(GlobalSearchOneDim, Test_6_Trial_Store_M) {
+    TrialStore trials(0, 0, 1, 3);
+    ASSERT_DOUBLE_EQ(r * 3, trials.get_m());
+    trials.insert(0.5, 1.5);
+    ASSERT_DOUBLE_EQ(r * 3, trials.get_m());
+    trials.insert(0.75, 0);
+    ASSERT_DOUBLE_EQ(r * 12, trials.get_m());
+    ASSERT_EQ(4u, trials.size());
+
+    // pop gives the interval with the largest R = m d + (z1 - z0)^2 / (m d)
+    // - 2 (z1 + z0) over the stored trials
+    std::vector<double> y = {0, 0.5, 0.75, 1}, z = {0, 1.5, 0, 3};
+    double m = trials.get_m();
+    int best = 1;
+    double bestR = -DOUBLE_MAX;
+    for (int i = 1; i < 4; i++) {
+        double d = y[i] - y[i - 1];
+        double R = m * d + (z[i] - z[i - 1]) * (z[i] - z[i - 1]) / (m * d) -
+                   2 * (z[i] + z[i - 1]);
+        if (R > bestR) {
+            bestR = R;
+            best = i;
+        }
+    }
+    double x0, z0, x1, z1;
+    ASSERT_TRUE(trials.pop(&x0, &z0, &x1, &z1));
+    ASSERT_DOUBLE_EQ(y[best - 1], x0);
+    ASSERT_DOUBLE_EQ(y[best], x1);
+    ASSERT_DOUBLE_EQ(z[best], z1);
+}
+
+TEST(GlobalSearchOneDim, Test_7_Each_Point_Evaluated_Once) {
+    int calls = 0;
+    std::set<double> points;
+    auto f = [&calls, &points](double x) {
+        calls++;
+        points.insert(x);
+        return x * sin(x);
+    };
+    double result = globalSearchOneDimSequential(f, 0, 5 * MATH_PI, 0.001);
+    ASSERT_NEAR(-11.041, result, 0.01);
+    ASSERT_EQ(static_cast<int>(points.size()), calls);
+}
+
+TEST(GlobalSearchOneDim, Test_8_Async_XsinX) {
+    auto f = [](double x) { return x * sin(x); };
+    double result = globalSearchOneDimAsync(f, 0, 5 * MATH_PI, 0.001);
+    ASSERT_NEAR(-11.041, result, 0.01);
+}
+
+TEST(GlobalSearchOneDim, Test_9_Async_Variable_Cost) {
+    // the cost of a call grows with x
+    auto f = [](double x) {
+        double s = 0;
+        for (int i = 0; i < static_cast<int>(1000 * x); i++) s += sin(i);
+        return cos(x / 2) + 1e-12 * s;
+    };
+    double result = globalSearchOneDimAsync(f, MATH_PI, 4 * MATH_PI, 0.001);
+    ASSERT_NEAR(-1, result, 0.01);
+}
+
+TEST(GlobalSearchOneDim, Test_10_Hilbert_Neighbour_Cells) {
+    Evolvent y({0, 0, 0}, {1, 1, 1});
+    const double side = 1.0 / (1 << 17);
+    for (uint64_t h = 0; h < 5000; h += 7) {
+        std::vector<double> p0 = y.point(h), p1 = y.point(h + 1);
+        double shift = 0;
+        for (int i = 0; i < 3; i++) shift += std::abs(p1[i] - p0[i]);
+        ASSERT_NEAR(side, shift, 1e-12);
+    }
+}
+
+TEST(GlobalSearchOneDim, Test_11_MultiDim_Quadratic) {
+    auto f = [](const std::vector<double>& x) {
+        return (x[0] - 0.3) * (x[0] - 0.3) + (x[1] + 0.2) * (x[1] + 0.2);
+    };
+    std::vector<double> argmin;
+    double result =
+        globalSearchMultiDimParallel(f, {-1, -1}, {1, 1}, 0.01, &argmin);
+    ASSERT_NEAR(0, result, 0.01);
+    ASSERT_NEAR(0.3, argmin[0], 0.1);
+    ASSERT_NEAR(-0.2, argmin[1], 0.1);
+}
+
+TEST(GlobalSearchOneDim, Test_12_MultiDim_SinCos) {
+    auto f = [](const std::vector<double>& x) {
+        return sin(x[0]) + cos(x[1]);
+    };
+    double result = globalSearchMultiDimParallel(f, {0, 0},
+                                                 {2 * MATH_PI, 2 * MATH_PI},
+                                                 0.01);
+    ASSERT_NEAR(-2, result, 0.01);
+}
+
+TEST(GlobalSearchOneDim, Test_13_Batch_Function) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    int largestBatch = 0;
+    auto f = [&largestBatch](const double* xs, double* ys, int n) {
+        largestBatch = std::max(largestBatch, n);
+        for (int i = 0; i < n; i++) ys[i] = xs[i] * sin(xs[i]);
+    };
+    double result =
+        globalSearchOneDimParallelBatch(f, 0, 5 * MATH_PI, 0.001, 4);
+    ASSERT_NEAR(-11.041, result, 0.01);
+    if (rank == 0) {
+        ASSERT_EQ(4, largestBatch);
+    }
+}
+
+TEST(GlobalSearchOneDim, Test_14_Batched_Async) {
+    auto f = [](double x) { return cos(x / 2); };
+    double result =
+        globalSearchOneDimAsync(f, -4 * MATH_PI, -MATH_PI, 0.001, 3);
+    ASSERT_NEAR(-1, result, 0.01);
+}
+
+TEST(GlobalSearchOneDim, Test_15_Interval_Taken_Once) {
+    // rank 0 of the async search: four intervals are out at a time and
+    // come back in a random order, while M grows and the queue is rebuilt
+    auto f = [](double x) { return sin(20 * x) * x * x; };
+    TrialStore trials(-3, f(-3), 3, f(3));
+    struct Taken { double x0, x1, x; };
+    std::vector<Taken> out;
+    std::mt19937 gen(7);
+
+    double x0, z0, x1, z1;
+    for (int step = 0; step < 2000; step++) {
+        while (out.size() < 4 && trials.pop(&x0, &z0, &x1, &z1)) {
+            for (const Taken& t : out) {
+                ASSERT_TRUE(x1 <= t.x0 || t.x1 <= x0) << step;
+            }
+            out.push_back({x0, x1, compute_x(x0, z0, x1, z1, trials.get_m())});
+        }
+        ASSERT_FALSE(out.empty());
+        size_t k = gen() % out.size();
+        trials.insert(out[k].x, f(out[k].x));
+        out.erase(out.begin() + k);
+    }
+    ASSERT_EQ(2002u, trials.size());
+
+    // only the taken interval with the largest R may end the search
+    TrialStore two(0, 0, 4, 0);
+    ASSERT_TRUE(two.pop(&x0, &z0, &x1, &z1));
+    two.insert(1, -1);
+    ASSERT_TRUE(two.pop(&x0, &z0, &x1, &z1));
+    ASSERT_DOUBLE_EQ(1, x0);
+    ASSERT_TRUE(two.pop(&x0, &z0, &x1, &z1));
+    ASSERT_FALSE(two.is_best(0.5));
+    ASSERT_TRUE(two.is_best(2));
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     MPI_Init(&argc, &argv);
@@ -1,7 +1,11 @@
 // Copyright 2022 Eremin Aleksandr
 #include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+#include <string>
 #include <vector>
 #include "./ops_mpi.h"
+#include "./quickhull.h"
 #include <gtest-mpi-listener.hpp>
 
 TEST(Parallel_Operations_MPI, Graham_Method) {
@@ -109,6 +113,238 @@ TEST(Parallel_Operations_MPI, GrahamParallel_Method_4) {
     }
 }
 
+TEST(Parallel_Operations_MPI, Merge_Hulls) {
+    vector<Point> first = random(40), second = random(90);
+    for (size_t i = 0; i < second.size(); ++i) second[i].x += 5;
+    vector<Point> all = first;
+    all.insert(all.end(), second.begin(), second.end());
+
+    vector<Point> merged = MergeHulls(GrahamMethod(first), GrahamMethod(second));
+    vector<Point> expected = GrahamMethod(all);
+    ASSERT_EQ(expected.size(), merged.size());
+    for (vector<int>::size_type i = 0; i < expected.size(); ++i) {
+        ASSERT_EQ(expected[i].x, merged[i].x);
+        ASSERT_EQ(expected[i].y, merged[i].y);
+    }
+}
+
+TEST(Parallel_Operations_MPI, GrahamParallel_Method_Wide) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    std::vector<Point> global_vec;
+    const vector<int>::size_type size = 20000;
+
+    if (rank == 0) {
+        std::mt19937 gen(3);
+        for (vector<int>::size_type i = 0; i < size; i++)
+            global_vec.push_back(Point(gen() % 100000, gen() % 100000));
+    }
+
+    vector<Point> parallel = parallelGrahamMethod(global_vec, size);
+
+    if (rank == 0) {
+        vector<Point> not_parallel = GrahamMethod(global_vec);
+        ASSERT_EQ(parallel.size(), not_parallel.size());
+        for (vector<int>::size_type i = 0; i < parallel.size(); ++i) {
+            ASSERT_EQ(parallel[i].x, not_parallel[i].x);
+            ASSERT_EQ(parallel[i].y, not_parallel[i].y);
+        }
+    }
+}
+
+typedef PointN<double, 2> Point2;
+typedef PointN<double, 3> Point3;
+
+std::vector<Point2> cloud2(const std::string& kind, int n, int seed) {
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<double> uniform(-1, 1);
+    std::normal_distribution<double> normal(0, 1);
+    std::vector<Point2> res(n);
+    for (int i = 0; i < n; i++) {
+        if (kind == "uniform") {
+            res[i] = Point2{{uniform(gen), uniform(gen)}};
+        } else if (kind == "circle") {
+            // evenly spaced, random angles would give nearly collinear triples
+            double phi = 2 * 3.14159265358979 * i / n;
+            res[i] = Point2{{std::cos(phi), std::sin(phi)}};
+        } else {
+            res[i] = Point2{{normal(gen), normal(gen)}};
+        }
+    }
+    return res;
+}
+
+std::vector<Point3> cloud3(const std::string& kind, int n, int seed) {
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<double> uniform(-1, 1);
+    std::normal_distribution<double> normal(0, 1);
+    std::vector<Point3> res(n);
+    for (int i = 0; i < n; i++) {
+        Point3 q{{normal(gen), normal(gen), normal(gen)}};
+        if (kind == "uniform") {
+            q = Point3{{uniform(gen), uniform(gen), uniform(gen)}};
+        } else if (kind == "circle") {
+            double len = std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2]);
+            for (int k = 0; k < 3; k++) q[k] /= len;
+        }
+        res[i] = q;
+    }
+    return res;
+}
+
+TEST(QuickHull, Matches_Graham_2D) {
+    vector<Point> points = random(500);
+    std::vector<PointN<int, 2>> converted;
+    for (size_t i = 0; i < points.size(); ++i)
+        converted.push_back(PointN<int, 2>{{points[i].x, points[i].y}});
+
+    vector<Point> graham = GrahamMethod(points);
+    HullN<int, 2> hull = QuickHull(converted);
+    ASSERT_EQ(graham.size(), hull.vertices.size());
+    // Graham goes clockwise, QuickHull counter-clockwise
+    for (size_t i = 0; i < graham.size(); ++i) {
+        const PointN<int, 2>& v = hull.vertices[(graham.size() - i) % graham.size()];
+        ASSERT_EQ(graham[i].x, v[0]);
+        ASSERT_EQ(graham[i].y, v[1]);
+    }
+}
+
+TEST(QuickHull, Cube_3D) {
+    std::vector<PointN<int, 3>> points;
+    for (int i = 0; i < 8; i++)
+        points.push_back(PointN<int, 3>{{i & 1 ? 10 : 0, i & 2 ? 10 : 0, i & 4 ? 10 : 0}});
+    std::mt19937 gen(5);
+    for (int i = 0; i < 1000; i++)
+        points.push_back(PointN<int, 3>{{1 + static_cast<int>(gen() % 9),
+            1 + static_cast<int>(gen() % 9), 1 + static_cast<int>(gen() % 9)}});
+
+    HullN<int, 3> hull = QuickHull(points);
+    ASSERT_EQ(8u, hull.vertices.size());
+    ASSERT_EQ(12u, hull.facets.size());
+    ASSERT_ANY_THROW(QuickHull(std::vector<PointN<int, 3>>(4, points[0])));
+}
+
+TEST(QuickHull, Integer_Coordinates_At_The_Limit) {
+    const int64_t r3 = quickhull_detail::maxCoordinate3;
+    std::vector<PointN<int64_t, 3>> cube;
+    for (int i = 0; i < 8; i++)
+        cube.push_back(PointN<int64_t, 3>{{i & 1 ? r3 : -r3, i & 2 ? r3 : -r3, i & 4 ? r3 : -r3}});
+    std::mt19937 gen(19);
+    for (int i = 0; i < 1000; i++)
+        cube.push_back(PointN<int64_t, 3>{{static_cast<int64_t>(gen() % r3), static_cast<int64_t>(gen() % r3),
+            -static_cast<int64_t>(gen() % r3)}});
+    HullN<int64_t, 3> hull3 = QuickHull(cube);
+    ASSERT_EQ(8u, hull3.vertices.size());
+    ASSERT_EQ(12u, hull3.facets.size());
+    cube[0][0] = -r3 - 1;
+    ASSERT_ANY_THROW(QuickHull(cube));
+
+    const int r2 = static_cast<int>(quickhull_detail::maxCoordinate2);
+    std::vector<PointN<int, 2>> square = {{{-r2, -r2}}, {{r2, -r2}}, {{r2, r2}}, {{-r2, r2}}, {{r2 - 1, 0}}};
+    ASSERT_EQ(4u, QuickHull(square).vertices.size());
+    square[4][0] = r2 + 1;
+    ASSERT_ANY_THROW(QuickHull(square));
+}
+
+TEST(QuickHull, Same_Result_On_Threads) {
+    std::vector<Point3> points = cloud3("uniform", 100000, 11);
+    HullN<double, 3> single = QuickHull(points, 1);
+    HullN<double, 3> threaded = QuickHull(points, 4);
+    ASSERT_TRUE(single.vertices == threaded.vertices);
+    ASSERT_TRUE(single.facets == threaded.facets);
+    ASSERT_EQ(2 * single.vertices.size() - 4, single.facets.size());
+
+    std::vector<Point2> flat = cloud2("gaussian", 100000, 12);
+    ASSERT_TRUE(QuickHull(flat, 1).vertices == QuickHull(flat, 4).vertices);
+}
+
+TEST(QuickHull, Parallel_3D) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    const int size = 20000;
+    std::vector<Point3> points;
+    if (rank == 0) points = cloud3("gaussian", size, 13);
+
+    HullN<double, 3> parallel = ParallelQuickHull(points, size, 2);
+    if (rank == 0) {
+        HullN<double, 3> expected = QuickHull(points);
+        ASSERT_TRUE(expected.vertices == parallel.vertices);
+        ASSERT_TRUE(expected.facets == parallel.facets);
+    }
+}
+
+TEST(QuickHull, Parallel_All_Kinds) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    const char* kinds[] = {"uniform", "circle", "gaussian"};
+
+    for (int k = 0; k < 3; k++) {
+        const int size2 = 5000, size3 = 2000;
+        std::vector<Point2> points2;
+        std::vector<Point3> points3;
+        if (rank == 0) {
+            points2 = cloud2(kinds[k], size2, k);
+            points3 = cloud3(kinds[k], size3, k);
+        }
+
+        HullN<double, 2> parallel2 = ParallelQuickHull(points2, size2, 2);
+        HullN<double, 3> parallel3 = ParallelQuickHull(points3, size3, 2);
+        if (rank == 0) {
+            ASSERT_TRUE(QuickHull(points2).vertices == parallel2.vertices);
+            ASSERT_TRUE(QuickHull(points3).vertices == parallel3.vertices);
+        }
+    }
+}
+
+TEST(QuickHull, No_Threads_Means_One) {
+    std::vector<Point3> points = cloud3("uniform", 1000, 17);
+    HullN<double, 3> single = QuickHull(points, 1);
+    ASSERT_TRUE(single.vertices == QuickHull(points, 0).vertices);
+    ASSERT_TRUE(single.facets == QuickHull(points, -3).facets);
+
+    std::vector<Point2> flat = cloud2("uniform", 1000, 18);
+    ASSERT_TRUE(QuickHull(flat, 1).vertices == QuickHull(flat, 0).vertices);
+}
+
+// Timings on large clouds, run with --gtest_also_run_disabled_tests
+TEST(QuickHull, DISABLED_Benchmark) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    const char* kinds[] = {"uniform", "circle", "gaussian"};
+    const int threads = 2;
+
+    for (int k = 0; k < 3; k++) {
+        // on a circle every point is a vertex
+        const int size2 = k == 1 ? 100000 : 400000;
+        const int size3 = k == 1 ? 20000 : 100000;
+        std::vector<Point2> points2;
+        std::vector<Point3> points3;
+        if (rank == 0) {
+            points2 = cloud2(kinds[k], size2, k);
+            points3 = cloud3(kinds[k], size3, k);
+        }
+
+        double t0 = MPI_Wtime();
+        HullN<double, 2> parallel2 = ParallelQuickHull(points2, size2, threads);
+        double t1 = MPI_Wtime();
+        HullN<double, 3> parallel3 = ParallelQuickHull(points3, size3, threads);
+        double t2 = MPI_Wtime();
+
+        if (rank == 0) {
+            HullN<double, 2> seq2 = QuickHull(points2);
+            double t3 = MPI_Wtime();
+            HullN<double, 3> seq3 = QuickHull(points3);
+            double t4 = MPI_Wtime();
+            std::cout << kinds[k] << ": 2D " << parallel2.vertices.size()
+                      << " vertices, parallel " << t1 - t0 << " s, sequential " << t3 - t2
+                      << " s; 3D " << parallel3.vertices.size() << " vertices, parallel "
+                      << t2 - t1 << " s, sequential " << t4 - t3 << " s\n";
+            ASSERT_TRUE(seq2.vertices == parallel2.vertices);
+            ASSERT_TRUE(seq3.vertices == parallel3.vertices);
+        }
+    }
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     MPI_Init(&argc, &argv);
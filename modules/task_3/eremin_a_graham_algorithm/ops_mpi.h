@@ -15,6 +15,13 @@ struct Point {
 };
 
 vector<Point> GrahamMethod(vector<Point> vectorOfVertex);
+vector<Point> GrahamSorted(const vector<Point>& vectorOfVertex);
+// Hull of the union of two hulls from GrahamMethod in linear time
+vector<Point> MergeHulls(const vector<Point>& first,
+    const vector<Point>& second);
+// Points that are not strictly inside the clockwise convex polygon
+vector<Point> FilterInterior(const vector<Point>& vectorOfVertex,
+    const vector<Point>& polygon);
 vector<Point> parallelGrahamMethod(vector<Point> vectorOfVertex,
     vector<int>::size_type vectorSize);
 vector<Point> random(const vector<int>::size_type Size);
@@ -0,0 +1,547 @@
+// Copyright 2022 Eremin Aleksandr
+#ifndef MODULES_TASK_3_EREMIN_A_GRAHAM_ALGORITHM_QUICKHULL_H_
+#define MODULES_TASK_3_EREMIN_A_GRAHAM_ALGORITHM_QUICKHULL_H_
+
+#include <mpi.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <thread>  // NOLINT [build/c++11]
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+// Point with D coordinates of type T
+template <typename T, int D>
+struct PointN {
+    T c[D];
+
+    T& operator[](int i) { return c[i]; }
+    const T& operator[](int i) const { return c[i]; }
+};
+
+template <typename T, int D>
+bool operator<(const PointN<T, D>& a, const PointN<T, D>& b) {
+    return std::lexicographical_compare(a.c, a.c + D, b.c, b.c + D);
+}
+
+template <typename T, int D>
+bool operator==(const PointN<T, D>& a, const PointN<T, D>& b) {
+    return std::equal(a.c, a.c + D, b.c);
+}
+
+// In 2D the vertices go counter-clockwise from the smallest one. In 3D
+// they are sorted and facets are triangles of indices into them, counter-
+// clockwise when seen from outside.
+template <typename T, int D>
+struct HullN {
+    std::vector<PointN<T, D>> vertices;
+    std::vector<std::array<int, 3>> facets;
+};
+
+template <typename T> MPI_Datatype MpiType();
+template <> inline MPI_Datatype MpiType<int>() { return MPI_INT; }
+template <> inline MPI_Datatype MpiType<int64_t>() { return MPI_INT64_T; }
+template <> inline MPI_Datatype MpiType<float>() { return MPI_FLOAT; }
+template <> inline MPI_Datatype MpiType<double>() { return MPI_DOUBLE; }
+
+// StructPoint for PointN
+template <typename T, int D>
+void StructPointN(MPI_Datatype* structPoint) {
+    typedef PointN<T, D> PointType;
+    int block[D];
+    MPI_Aint displacements[D];
+    MPI_Datatype Datatype[D];
+    for (int i = 0; i < D; i++) {
+        block[i] = 1;
+        displacements[i] = offsetof(PointType, c) + i * sizeof(T);
+        Datatype[i] = MpiType<T>();
+    }
+    MPI_Datatype type;
+    MPI_Aint lb, extent;
+
+    MPI_Type_create_struct(D, block, displacements, Datatype, &type);
+    MPI_Type_get_extent(type, &lb, &extent);
+    MPI_Type_create_resized(type, lb, sizeof(PointType), structPoint);
+    MPI_Type_commit(structPoint);
+    MPI_Type_free(&type);
+}
+
+namespace quickhull_detail {
+
+// Products of coordinates are computed in 64-bit integers for integral
+// types and at least in double otherwise
+template <typename T>
+struct Wide {
+    typedef typename std::conditional<std::is_integral<T>::value, int64_t,
+        typename std::conditional<(sizeof(T) > sizeof(double)), T,
+            double>::type>::type type;
+};
+
+// Points closer than this to a line (2D) or a plane (3D) are treated as
+// lying on it. Integral types get no tolerance, their predicates are exact
+// as long as the coordinates pass CheckRange.
+template <typename W>
+W Tolerance(W extent, int power) {
+    if (std::is_integral<W>::value) return 0;
+    return static_cast<W>(std::numeric_limits<W>::epsilon() * 16 *
+        std::pow(static_cast<double>(extent), power));
+}
+
+// Largest integral coordinates with exact predicates in int64_t: a 2D cross
+// product is up to 8 * x^2, a 3D plane distance up to 48 * x^3
+const int64_t maxCoordinate2 = (int64_t(1) << 30) - 1;
+const int64_t maxCoordinate3 = int64_t(1) << 19;
+
+// Throws if an integral coordinate is out of [-limit, limit]
+template <typename T, int D>
+void CheckRange(const std::vector<PointN<T, D>>& points, int64_t limit) {
+    if (!std::is_integral<T>::value) return;
+    for (size_t i = 0; i < points.size(); ++i) {
+        for (int k = 0; k < D; k++) {
+            int64_t x = static_cast<int64_t>(points[i][k]);
+            if (x > limit || x < -limit) throw "Coordinates are too large";
+        }
+    }
+}
+
+template <typename T, int D>
+typename Wide<T>::type Extent(const std::vector<PointN<T, D>>& points) {
+    typedef typename Wide<T>::type W;
+    W extent = 0;
+    for (int k = 0; k < D && !points.empty(); k++) {
+        W lo = points[0][k], hi = points[0][k];
+        for (size_t i = 1; i < points.size(); ++i) {
+            lo = std::min<W>(lo, points[i][k]);
+            hi = std::max<W>(hi, points[i][k]);
+        }
+        extent = std::max(extent, hi - lo);
+    }
+    return extent;
+}
+
+// Chunks smaller than this are not worth a thread
+const int minChunk = 1 << 14;
+
+inline int ChunkCount(int n, int threads) {
+    return std::max(1, std::min(threads, n / minChunk));
+}
+
+// Calls f(begin, end, chunk) for consecutive parts of [0, n), each part
+// on its own thread, returns the number of parts
+template <typename F>
+int ForChunks(int n, int threads, const F& f) {
+    int chunks = ChunkCount(n, threads);
+    auto bound = [n, chunks](int t) {
+        return static_cast<int>(static_cast<int64_t>(n) * t / chunks);
+    };
+    std::vector<std::thread> pool;
+    for (int t = 1; t < chunks; t++)
+        pool.emplace_back([&f, &bound, t]() { f(bound(t), bound(t + 1), t); });
+    f(0, bound(1), 0);
+    for (size_t t = 0; t < pool.size(); ++t) pool[t].join();
+    return chunks;
+}
+
+template <typename T>
+class QuickHull2 {
+ public:
+    typedef PointN<T, 2> PointType;
+    typedef typename Wide<T>::type W;
+
+    QuickHull2(const std::vector<PointType>& points, int threads)
+        : p(points), threads(std::max(1, threads)),
+          tol(Tolerance<W>(Extent(points), 2)) {
+        CheckRange(points, maxCoordinate2);
+    }
+
+    HullN<T, 2> Run() {
+        HullN<T, 2> hull;
+        if (p.empty()) return hull;
+        int first = 0, last = 0;
+        for (size_t i = 1; i < p.size(); ++i) {
+            if (p[i] < p[first]) first = i;
+            if (p[last] < p[i]) last = i;
+        }
+
+        std::vector<int> all(p.size()), order;
+        for (size_t i = 0; i < p.size(); ++i) all[i] = i;
+        order.push_back(first);
+        if (!(p[first] == p[last])) {
+            Chain(first, last, all, &order);
+            order.push_back(last);
+            Chain(last, first, all, &order);
+        }
+        for (size_t i = 0; i < order.size(); ++i)
+            hull.vertices.push_back(p[order[i]]);
+        return hull;
+    }
+
+ private:
+    // Twice the signed area of a, b, c: negative if c is right of a -> b
+    W Cross(int a, int b, int c) const {
+        W bx = static_cast<W>(p[b][0]) - p[a][0];
+        W by = static_cast<W>(p[b][1]) - p[a][1];
+        return bx * (static_cast<W>(p[c][1]) - p[a][1]) -
+            by * (static_cast<W>(p[c][0]) - p[a][0]);
+    }
+
+    // Appends the hull vertices strictly right of a -> b, taken from idx,
+    // in the order from a to b
+    void Chain(int a, int b, const std::vector<int>& idx,
+        std::vector<int>* order) const {
+        const int n = idx.size();
+        std::vector<std::vector<int>> right(threads);
+        std::vector<int> far(threads, -1);
+        std::vector<W> farCross(threads, 0);
+        int chunks = ForChunks(n, threads, [&](int begin, int end, int t) {
+            for (int i = begin; i < end; ++i) {
+                W c = Cross(a, b, idx[i]);
+                if (c >= -tol) continue;
+                right[t].push_back(idx[i]);
+                if (far[t] < 0 || c < farCross[t]) {
+                    far[t] = idx[i];
+                    farCross[t] = c;
+                }
+            }
+        });
+
+        int c = -1;
+        W best = 0;
+        std::vector<int> outside;
+        for (int t = 0; t < chunks; t++) {
+            outside.insert(outside.end(), right[t].begin(), right[t].end());
+            if (far[t] >= 0 && (c < 0 || farCross[t] < best)) {
+                c = far[t];
+                best = farCross[t];
+            }
+        }
+        if (c < 0) return;
+
+        Chain(a, c, outside, order);
+        order->push_back(c);
+        Chain(c, b, outside, order);
+    }
+
+    const std::vector<PointType>& p;
+    const int threads;
+    const W tol;
+};
+
+template <typename T>
+class QuickHull3 {
+ public:
+    typedef PointN<T, 3> PointType;
+    typedef typename Wide<T>::type W;
+
+    QuickHull3(const std::vector<PointType>& points, int threads)
+        : p(points), threads(std::max(1, threads)),
+          tol(Tolerance<W>(Extent(points), 3)) {
+        CheckRange(points, maxCoordinate3);
+    }
+
+    HullN<T, 3> Run() {
+        InitialSimplex();
+
+        std::vector<int> pending;
+        for (size_t f = 0; f < facets.size(); ++f) pending.push_back(f);
+        std::vector<int> visible, orphans, created;
+        std::vector<std::array<int, 2>> horizon;
+        while (!pending.empty()) {
+            int f = pending.back();
+            pending.pop_back();
+            if (!facets[f].alive || facets[f].outside.empty()) continue;
+            int eye = facets[f].far;
+
+            FindVisible(f, eye, &visible, &horizon);
+
+            orphans.clear();
+            for (size_t i = 0; i < visible.size(); ++i) {
+                Facet& g = facets[visible[i]];
+                for (size_t j = 0; j < g.outside.size(); ++j)
+                    if (g.outside[j] != eye) orphans.push_back(g.outside[j]);
+                std::vector<int>().swap(g.outside);
+                g.alive = false;
+                for (int k = 0; k < 3; k++)
+                    edges.erase(Key(g.v[k], g.v[(k + 1) % 3]));
+            }
+
+            created.clear();
+            for (size_t i = 0; i < horizon.size(); ++i)
+                created.push_back(AddFacet(horizon[i][0], horizon[i][1], eye));
+            Assign(orphans, created);
+            for (size_t i = 0; i < created.size(); ++i)
+                if (!facets[created[i]].outside.empty())
+                    pending.push_back(created[i]);
+        }
+        return Result();
+    }
+
+ private:
+    struct Facet {
+        int v[3];
+        W n[3];
+        W offset;
+        std::vector<int> outside;
+        int far;
+        bool alive;
+        int mark;
+    };
+
+    int64_t Key(int a, int b) const {
+        return static_cast<int64_t>(a) * p.size() + b;
+    }
+
+    W Diff(int a, int b, int k) const {
+        return static_cast<W>(p[b][k]) - p[a][k];
+    }
+
+    W Distance(const Facet& f, int i) const {
+        return f.n[0] * p[i][0] + f.n[1] * p[i][1] + f.n[2] * p[i][2] -
+            f.offset;
+    }
+
+    void Normal(int a, int b, int c, W* n) const {
+        n[0] = Diff(a, b, 1) * Diff(a, c, 2) - Diff(a, b, 2) * Diff(a, c, 1);
+        n[1] = Diff(a, b, 2) * Diff(a, c, 0) - Diff(a, b, 0) * Diff(a, c, 2);
+        n[2] = Diff(a, b, 0) * Diff(a, c, 1) - Diff(a, b, 1) * Diff(a, c, 0);
+    }
+
+    int AddFacet(int a, int b, int c) {
+        Facet f;
+        f.v[0] = a;
+        f.v[1] = b;
+        f.v[2] = c;
+        Normal(a, b, c, f.n);
+        f.offset = f.n[0] * p[a][0] + f.n[1] * p[a][1] + f.n[2] * p[a][2];
+        f.far = -1;
+        f.alive = true;
+        f.mark = -1;
+        int id = facets.size();
+        facets.push_back(f);
+        for (int k = 0; k < 3; k++) edges[Key(f.v[k], f.v[(k + 1) % 3])] = id;
+        return id;
+    }
+
+    void InitialSimplex() {
+        if (p.empty()) throw "Degenerate point set";
+        int i0 = 0, i1 = 0;
+        for (size_t i = 1; i < p.size(); ++i) {
+            if (p[i] < p[i0]) i0 = i;
+            if (p[i1] < p[i]) i1 = i;
+        }
+
+        // the largest component of the normal stands for its length, the
+        // squared length would not fit in int64_t
+        int i2 = -1;
+        W best = Tolerance<W>(Extent(p), 2);
+        for (size_t i = 0; i < p.size(); ++i) {
+            W n[3];
+            Normal(i0, i1, i, n);
+            W len = 0;
+            for (int k = 0; k < 3; k++)
+                len = std::max(len, n[k] < 0 ? -n[k] : n[k]);
+            if (len > best) {
+                best = len;
+                i2 = i;
+            }
+        }
+        if (i2 < 0) throw "Degenerate point set";
+
+        Facet base = facets[AddFacet(i0, i1, i2)];
+        facets.clear();
+        edges.clear();
+        int i3 = -1;
+        best = tol;
+        for (size_t i = 0; i < p.size(); ++i) {
+            W d = Distance(base, i);
+            if (d < 0) d = -d;
+            if (d > best) {
+                best = d;
+                i3 = i;
+            }
+        }
+        if (i3 < 0) throw "Degenerate point set";
+
+        // the base is turned away from the fourth vertex
+        if (Distance(base, i3) > 0) std::swap(i1, i2);
+        AddFacet(i0, i1, i2);
+        AddFacet(i0, i3, i1);
+        AddFacet(i1, i3, i2);
+        AddFacet(i2, i3, i0);
+
+        std::vector<int> rest;
+        for (int i = 0; i < static_cast<int>(p.size()); ++i)
+            if (i != i0 && i != i1 && i != i2 && i != i3) rest.push_back(i);
+        Assign(rest, std::vector<int>{0, 1, 2, 3});
+    }
+
+    // Every point goes to the outside set of the first facet that sees
+    // it, the parts are joined in order so the result does not depend on
+    // the number of threads
+    void Assign(const std::vector<int>& points, const std::vector<int>& to) {
+        const int m = to.size();
+        auto visit = [&](int begin, int end, std::vector<std::vector<int>>* out) {
+            for (int i = begin; i < end; ++i)
+                for (int j = 0; j < m; j++)
+                    if (Distance(facets[to[j]], points[i]) > tol) {
+                        (*out)[j].push_back(points[i]);
+                        break;
+                    }
+        };
+
+        std::vector<std::vector<int>> outside(m);
+        if (ChunkCount(points.size(), threads) == 1) {
+            visit(0, points.size(), &outside);
+        } else {
+            std::vector<std::vector<std::vector<int>>> parts(
+                threads, std::vector<std::vector<int>>(m));
+            int chunks = ForChunks(points.size(), threads,
+                [&](int begin, int end, int t) { visit(begin, end, &parts[t]); });
+            for (int j = 0; j < m; j++)
+                for (int t = 0; t < chunks; t++)
+                    outside[j].insert(outside[j].end(), parts[t][j].begin(),
+                        parts[t][j].end());
+        }
+
+        for (int j = 0; j < m; j++) {
+            Facet& f = facets[to[j]];
+            f.outside.swap(outside[j]);
+            W best = 0;
+            for (size_t i = 0; i < f.outside.size(); ++i) {
+                W d = Distance(f, f.outside[i]);
+                if (f.far < 0 || d > best) {
+                    best = d;
+                    f.far = f.outside[i];
+                }
+            }
+        }
+    }
+
+    // Facets seen from eye, starting from f, and the edges between them
+    // and the rest of the hull
+    void FindVisible(int f, int eye, std::vector<int>* visible,
+        std::vector<std::array<int, 2>>* horizon) {
+        visible->clear();
+        horizon->clear();
+        std::vector<int> stack(1, f);
+        facets[f].mark = eye;
+        while (!stack.empty()) {
+            int g = stack.back();
+            stack.pop_back();
+            visible->push_back(g);
+            for (int k = 0; k < 3; k++) {
+                int a = facets[g].v[k], b = facets[g].v[(k + 1) % 3];
+                int h = edges[Key(b, a)];
+                if (facets[h].mark == eye) continue;
+                if (Distance(facets[h], eye) > tol) {
+                    facets[h].mark = eye;
+                    stack.push_back(h);
+                } else {
+                    horizon->push_back(std::array<int, 2>{{a, b}});
+                }
+            }
+        }
+    }
+
+    HullN<T, 3> Result() const {
+        std::vector<int> used;
+        for (size_t f = 0; f < facets.size(); ++f)
+            if (facets[f].alive) used.insert(used.end(), facets[f].v,
+                facets[f].v + 3);
+        std::sort(used.begin(), used.end(), [this](int a, int b) {
+            return p[a] < p[b] || (p[a] == p[b] && a < b);
+        });
+        used.erase(std::unique(used.begin(), used.end()), used.end());
+
+        HullN<T, 3> hull;
+        std::unordered_map<int, int> index;
+        for (size_t i = 0; i < used.size(); ++i) {
+            index[used[i]] = i;
+            hull.vertices.push_back(p[used[i]]);
+        }
+        for (size_t f = 0; f < facets.size(); ++f) {
+            if (!facets[f].alive) continue;
+            std::array<int, 3> t;
+            for (int k = 0; k < 3; k++) t[k] = index[facets[f].v[k]];
+            std::rotate(t.begin(), std::min_element(t.begin(), t.end()),
+                t.end());
+            hull.facets.push_back(t);
+        }
+        std::sort(hull.facets.begin(), hull.facets.end());
+        return hull;
+    }
+
+    const std::vector<PointType>& p;
+    const int threads;
+    const W tol;
+    std::vector<Facet> facets;
+    std::unordered_map<int64_t, int> edges;
+};
+
+}  // namespace quickhull_detail
+
+// QuickHull of the points, the partitions of large point sets are split
+// between threads. Integral coordinates must be within maxCoordinate2 in
+// 2D and maxCoordinate3 in 3D, otherwise it throws.
+template <typename T>
+HullN<T, 2> QuickHull(const std::vector<PointN<T, 2>>& points,
+    int threads = 1) {
+    return quickhull_detail::QuickHull2<T>(points, threads).Run();
+}
+
+// Throws if all points lie in one plane
+template <typename T>
+HullN<T, 3> QuickHull(const std::vector<PointN<T, 3>>& points,
+    int threads = 1) {
+    return quickhull_detail::QuickHull3<T>(points, threads).Run();
+}
+
+// The points of rank 0 are scattered, every rank sends the vertices of
+// its local hull back and rank 0 builds the hull of them
+template <typename T, int D>
+HullN<T, D> ParallelQuickHull(const std::vector<PointN<T, D>>& points,
+    int count, int threads = 1) {
+    int size, rank;
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    MPI_Datatype structPoint;
+    StructPointN<T, D>(&structPoint);
+
+    std::vector<int> counts(size), displs(size, 0);
+    for (int i = 0; i < size; i++) {
+        counts[i] = count / size + (i < count % size);
+        if (i > 0) displs[i] = displs[i - 1] + counts[i - 1];
+    }
+
+    std::vector<PointN<T, D>> local(counts[rank]);
+    MPI_Scatterv(points.data(), counts.data(), displs.data(), structPoint,
+        local.data(), counts[rank], structPoint, 0, MPI_COMM_WORLD);
+
+    // a few local points may lie in one plane, they are all kept then
+    std::vector<PointN<T, D>> vertices = local;
+    if (local.size() > D + 1) {
+        try {
+            vertices = QuickHull(local, threads).vertices;
+        } catch (const char*) {}
+    }
+
+    int localCount = vertices.size();
+    MPI_Gather(&localCount, 1, MPI_INT, counts.data(), 1, MPI_INT, 0,
+        MPI_COMM_WORLD);
+    for (int i = 1; i < size; i++) displs[i] = displs[i - 1] + counts[i - 1];
+    std::vector<PointN<T, D>> candidates;
+    if (rank == 0) candidates.resize(displs[size - 1] + counts[size - 1]);
+    MPI_Gatherv(vertices.data(), localCount, structPoint, candidates.data(),
+        counts.data(), displs.data(), structPoint, 0, MPI_COMM_WORLD);
+    MPI_Type_free(&structPoint);
+
+    if (rank != 0) return HullN<T, D>();
+    return QuickHull(candidates, threads);
+}
+
+#endif  // MODULES_TASK_3_EREMIN_A_GRAHAM_ALGORITHM_QUICKHULL_H_
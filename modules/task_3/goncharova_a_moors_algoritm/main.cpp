@@ -1,5 +1,6 @@
 // Copyright Anna Goncharova
 #include <gtest/gtest.h>
+#include <vector>
 #include "../../../modules/task_3/goncharova_a_moors_algoritm/moors_algoritm.h"
 #include <gtest-mpi-listener.hpp>
 
@@ -84,6 +85,165 @@ TEST(Moors_Algorithm_MPI, Test_On_Size_15) {
     }
 }
 
+TEST(Moors_Algorithm_MPI, Test_Sparse_Path_Graph) {
+    int rank;
+    int n = 1000;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    Graph g;
+    if (rank == 0) {
+        g.n = n;
+        for (int v = 0; v < n; ++v) {
+            g.in_ptr.push_back(static_cast<int>(g.in_src.size()));
+            if (v > 0) {
+                g.in_src.push_back(v - 1);
+                g.in_w.push_back(2);
+            }
+        }
+        g.in_ptr.push_back(static_cast<int>(g.in_src.size()));
+    }
+    int flag = -1;
+    std::vector<int> ans = ParallelMoor(g, 0, &flag);
+    for (int i = 0; i < n; ++i) {
+        ASSERT_EQ(2 * i, ans[i]);
+    }
+    if (rank == 0) {
+        ASSERT_EQ(0, flag);
+    }
+}
+
+TEST(Moors_Algorithm_MPI, Test_Negative_Cycle) {
+    int rank;
+    int n = 4;
+    const int inf = 2000000000;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    std::vector<int> g(n * n, inf);
+    for (int i = 0; i < n; ++i)
+        g[i * n + i] = 0;
+    g[0 * n + 1] = 1;
+    g[1 * n + 2] = -3;
+    g[2 * n + 1] = 1;
+    int flag = 0;
+    std::vector<int> ans = ParallelMoor(g, 0, &flag);
+    if (rank == 0) {
+        ASSERT_EQ(1, flag);
+        ASSERT_EQ(inf, ans[3]);
+    }
+}
+
+TEST(Moors_Algorithm_MPI, Test_Negative_Cycle_Reachable_Part) {
+    int rank;
+    int n = 7;
+    const int inf = 2000000000;
+    const int minus_inf = -1000000000;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    std::vector<int> g(n * n, inf);
+    for (int i = 0; i < n; ++i)
+        g[i * n + i] = 0;
+    g[0 * n + 1] = 5;
+    g[0 * n + 5] = 2;
+    g[1 * n + 2] = -4;
+    g[2 * n + 3] = 1;
+    g[3 * n + 1] = 1;
+    g[3 * n + 4] = 10;
+    g[5 * n + 6] = -1;
+    std::vector<int> expected = {0, minus_inf, minus_inf, minus_inf,
+                                 minus_inf, 2, 1};
+    int flag = 0;
+    std::vector<int> ans = ParallelMoor(g, 0, &flag);
+    if (rank == 0) {
+        ASSERT_EQ(1, flag);
+        for (int i = 0; i < n; ++i) {
+            ASSERT_EQ(expected[i], ans[i]);
+        }
+        flag = 0;
+        ans = Moors_algorithm(g, 0, &flag);
+        ASSERT_EQ(1, flag);
+        for (int i = 0; i < n; ++i) {
+            ASSERT_EQ(expected[i], ans[i]);
+        }
+    }
+}
+
+TEST(Moors_Algorithm_MPI, Test_Multiple_Sources) {
+    int rank;
+    int n = 20;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    std::vector<int> g(n * n);
+    if (rank == 0)
+        g = getRandomGraph(n);
+    std::vector<int> sources = {0, 7, 19};
+    int flag = -1;
+    std::vector<std::vector<int>> ans = ParallelMoor(g, sources, &flag);
+    if (rank == 0) {
+        ASSERT_EQ(0, flag);
+        for (size_t s = 0; s < sources.size(); ++s) {
+            std::vector<int> expected = Moors_algorithm(g, sources[s]);
+            for (int i = 0; i < n; ++i) {
+                ASSERT_EQ(expected[i], ans[s][i]);
+            }
+        }
+    }
+}
+
+TEST(Moors_Algorithm_MPI, Test_Floyd_Random_Graph) {
+    int rank;
+    int n = 70;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    std::vector<int> g(n * n);
+    if (rank == 0)
+        g = getRandomGraph(n);
+    int flag = -1;
+    std::vector<int> ans = ParallelFloyd(g, &flag);
+    if (rank == 0) {
+        ASSERT_EQ(0, flag);
+        for (int s = 0; s < n; s += 9) {
+            std::vector<int> expected = Moors_algorithm(g, s);
+            for (int i = 0; i < n; ++i) {
+                ASSERT_EQ(expected[i], ans[s * n + i]);
+            }
+        }
+    }
+}
+
+TEST(Moors_Algorithm_MPI, Test_Floyd_Path_Graph) {
+    int rank;
+    int n = 150;
+    const int inf = 2000000000;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    std::vector<int> g(n * n, inf);
+    for (int i = 0; i < n; ++i) {
+        g[i * n + i] = 0;
+        if (i + 1 < n)
+            g[i * n + i + 1] = -1;
+    }
+    std::vector<int> ans = ParallelFloyd(g);
+    if (rank == 0) {
+        for (int i = 0; i < n; ++i)
+            for (int j = 0; j < n; ++j) {
+                ASSERT_EQ(j >= i ? i - j : inf, ans[i * n + j]);
+            }
+    }
+}
+
+TEST(Moors_Algorithm_MPI, Test_Floyd_Negative_Cycle) {
+    int rank;
+    int n = 4;
+    const int inf = 2000000000;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    std::vector<int> g(n * n, inf);
+    for (int i = 0; i < n; ++i)
+        g[i * n + i] = 0;
+    g[0 * n + 1] = 1;
+    g[1 * n + 2] = -3;
+    g[2 * n + 1] = 1;
+    int flag = 0;
+    std::vector<int> ans = ParallelFloyd(g, &flag);
+    if (rank == 0) {
+        ASSERT_EQ(1, flag);
+        ASSERT_EQ(inf, ans[0 * n + 3]);
+    }
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     MPI_Init(&argc, &argv);
@@ -8,7 +8,11 @@
 #include <vector>
 #include <stdexcept>
 #include <algorithm>
+#include <deque>
 #include <limits>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 #include "../../../modules/task_3/goncharova_a_moors_algoritm/moors_algoritm.h"
 
 static int offset = 0;
@@ -36,84 +40,408 @@ std::vector<int> Transpose(const std::vector<int>& g, int n) {
     return res;
 }
 
+Graph GraphFromMatrix(const std::vector<int>& g) {
+    Graph res;
+    res.n = static_cast<int>(sqrt(static_cast<int>(g.size())));
+    const int n = res.n;
+
+    res.in_ptr.assign(n + 1, 0);
+    for (int j = 0; j < n; ++j)
+        for (int k = 0; k < n; ++k)
+            if (j != k && g[k + j * n] < INF)
+                res.in_ptr[k + 1]++;
+    for (int k = 0; k < n; ++k)
+        res.in_ptr[k + 1] += res.in_ptr[k];
+
+    res.in_src.resize(res.in_ptr[n]);
+    res.in_w.resize(res.in_ptr[n]);
+    std::vector<int> pos(res.in_ptr.begin(), res.in_ptr.end() - 1);
+    for (int j = 0; j < n; ++j)
+        for (int k = 0; k < n; ++k)
+            if (j != k && g[k + j * n] < INF) {
+                res.in_src[pos[k]] = j;
+                res.in_w[pos[k]] = g[k + j * n];
+                pos[k]++;
+            }
+    return res;
+}
+
 std::vector<int> ParallelMoor(const std::vector<int>& g, int source,
                                                         int* flag) {
-    const int minus_inf = -1000000000;
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    if (rank == 0)
+        return ParallelMoor(GraphFromMatrix(g), source, flag);
+    return ParallelMoor(Graph(), source, flag);
+}
+
+// Exchanges the (vertex, distance, path length) triples changed by every
+// process, updates d and len and puts the changed vertices to frontier.
+// Returns the total number of changes, zero means that nobody changed
+// anything.
+static int ExchangeChanges(const std::vector<int>& loc_changed,
+                           std::vector<int>* d, std::vector<int>* len,
+                           std::vector<int>* frontier) {
+    int size;
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    int cnt = static_cast<int>(loc_changed.size());
+    std::vector<int> counts(size), displs(size, 0);
+    MPI_Allgather(&cnt, 1, MPI_INT, counts.data(), 1, MPI_INT,
+        MPI_COMM_WORLD);
+    for (int i = 1; i < size; ++i)
+        displs[i] = displs[i - 1] + counts[i - 1];
+    int total = displs[size - 1] + counts[size - 1];
 
+    frontier->clear();
+    if (total == 0)
+        return 0;
+
+    std::vector<int> all(total);
+    MPI_Allgatherv(loc_changed.data(), cnt, MPI_INT, all.data(),
+        counts.data(), displs.data(), MPI_INT, MPI_COMM_WORLD);
+
+    for (int i = 0; i < total; i += 3) {
+        (*d)[all[i]] = all[i + 1];
+        (*len)[all[i]] = all[i + 2];
+        frontier->push_back(all[i]);
+    }
+    return total / 3;
+}
+
+// Edges of the current process: the ones coming into its block of
+// vertices, grouped by the source, so the edges leaving u are
+// out_dst[i] with weight out_w[i] for out_ptr[u] <= i < out_ptr[u + 1].
+struct LocalGraph {
+    int n = 0;
+    int first = 0;
+    int count = 0;
+    std::vector<int> out_ptr;
+    std::vector<int> out_dst;
+    std::vector<int> out_w;
+};
+
+static int BlockBegin(int n, int parts, int i) {
+    return i * (n / parts) + std::min(i, n % parts);
+}
+
+// Scatters the graph stored on the process 0 by blocks of vertices
+static LocalGraph ScatterGraph(const Graph& g) {
     int size, rank;
-    int n = static_cast<int>(sqrt(static_cast<int>(g.size())));
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    LocalGraph lg;
+    lg.n = g.n;
+    MPI_Bcast(&lg.n, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    const int n = lg.n;
+
+    std::vector<int> sendcounts_v(size), displs_v(size, 0);
+    std::vector<int> sendcounts_e(size, 0), displs_e(size, 0);
+    for (int i = 0; i < size; ++i) {
+        displs_v[i] = BlockBegin(n, size, i);
+        sendcounts_v[i] = BlockBegin(n, size, i + 1) - displs_v[i];
+        if (rank == 0) {
+            displs_e[i] = g.in_ptr[displs_v[i]];
+            sendcounts_e[i] = g.in_ptr[displs_v[i] + sendcounts_v[i]]
+                - displs_e[i];
+        }
+    }
+    MPI_Bcast(sendcounts_e.data(), size, MPI_INT, 0, MPI_COMM_WORLD);
+
+    lg.first = displs_v[rank];
+    lg.count = sendcounts_v[rank];
+    const int tmp = lg.count;
+    const int edges = sendcounts_e[rank];
+    std::vector<int> loc_ptr(tmp + 1);
+    std::vector<int> loc_src(edges);
+    std::vector<int> loc_w(edges);
+    MPI_Scatterv(g.in_ptr.data(), sendcounts_v.data(), displs_v.data(),
+        MPI_INT, loc_ptr.data(), tmp, MPI_INT, 0, MPI_COMM_WORLD);
+    MPI_Scatterv(g.in_src.data(), sendcounts_e.data(), displs_e.data(),
+        MPI_INT, loc_src.data(), edges, MPI_INT, 0, MPI_COMM_WORLD);
+    MPI_Scatterv(g.in_w.data(), sendcounts_e.data(), displs_e.data(),
+        MPI_INT, loc_w.data(), edges, MPI_INT, 0, MPI_COMM_WORLD);
+    const int base = tmp > 0 ? loc_ptr[0] : 0;
+    for (int k = 0; k < tmp; ++k)
+        loc_ptr[k] -= base;
+    loc_ptr[tmp] = edges;
+
+    // regrouping the local edges by the source
+    lg.out_ptr.assign(n + 1, 0);
+    for (int e = 0; e < edges; ++e)
+        lg.out_ptr[loc_src[e] + 1]++;
+    for (int j = 0; j < n; ++j)
+        lg.out_ptr[j + 1] += lg.out_ptr[j];
+    lg.out_dst.resize(edges);
+    lg.out_w.resize(edges);
+    std::vector<int> pos(lg.out_ptr.begin(), lg.out_ptr.end() - 1);
+    for (int k = 0; k < tmp; ++k)
+        for (int e = loc_ptr[k]; e < loc_ptr[k + 1]; ++e) {
+            lg.out_dst[pos[loc_src[e]]] = lg.first + k;
+            lg.out_w[pos[loc_src[e]]] = loc_w[e];
+            pos[loc_src[e]]++;
+        }
+    return lg;
+}
+
+// Frontier Bellman-Ford: in every round only the edges leaving the
+// vertices changed in the previous round are relaxed. len[v] is the
+// number of edges of the path giving d[v], a path of n edges has a
+// cycle, so such vertices get minus_inf. minus_inf spreads through the
+// same rounds to everything reachable from them.
+static std::vector<int> LocalMoor(const LocalGraph& lg, int source,
+                                  int* flag) {
+    const int minus_inf = -1000000000;
+
+    const int n = lg.n;
     std::vector<int> d(n, INF);
+    std::vector<int> len(n, 0);
+    std::vector<int> frontier(1, source);
     d[source] = 0;
 
+    // triples (vertex, distance, path length) changed by this process
+    std::vector<int> loc_changed;
+    std::vector<int> touched(n, -1);
+
+    int cycle = 0;
+    for (int round = 0; !frontier.empty(); ++round) {
+        loc_changed.clear();
+        for (size_t f = 0; f < frontier.size(); ++f) {
+            const int j = frontier[f];
+            for (int e = lg.out_ptr[j]; e < lg.out_ptr[j + 1]; ++e) {
+                const int k = lg.out_dst[e];
+                if (d[k] == minus_inf)
+                    continue;
+                if (d[j] == minus_inf) {
+                    d[k] = minus_inf;
+                } else if (d[k] > d[j] + lg.out_w[e]) {
+                    d[k] = std::max(d[j] + lg.out_w[e], minus_inf);
+                    len[k] = len[j] + 1;
+                    if (len[k] >= n) {
+                        d[k] = minus_inf;
+                        cycle = 1;
+                    }
+                } else {
+                    continue;
+                }
+                if (touched[k] != round) {
+                    touched[k] = round;
+                    loc_changed.push_back(k);
+                }
+            }
+        }
+
+        // vertices are stored once, the values are the final ones
+        const int cnt = static_cast<int>(loc_changed.size());
+        loc_changed.resize(3 * cnt);
+        for (int i = cnt - 1; i >= 0; --i) {
+            const int k = loc_changed[i];
+            loc_changed[3 * i] = k;
+            loc_changed[3 * i + 1] = d[k];
+            loc_changed[3 * i + 2] = len[k];
+        }
+        ExchangeChanges(loc_changed, &d, &len, &frontier);
+    }
+
+    if (flag) {
+        *flag = 0;
+        MPI_Reduce(&cycle, flag, 1, MPI_INT, MPI_LOR, 0, MPI_COMM_WORLD);
+    }
+    return d;
+}
+
+std::vector<int> ParallelMoor(const Graph& g, int source, int* flag) {
+    return LocalMoor(ScatterGraph(g), source, flag);
+}
+
+std::vector<std::vector<int>> ParallelMoor(const Graph& g,
+                                           const std::vector<int>& sources,
+                                           int* flag) {
+    LocalGraph lg = ScatterGraph(g);
+    std::vector<std::vector<int>> res(sources.size());
+    if (flag)
+        *flag = 0;
+    for (size_t s = 0; s < sources.size(); ++s) {
+        int flag2 = 0;
+        res[s] = LocalMoor(lg, sources[s], flag ? &flag2 : nullptr);
+        if (flag)
+            *flag |= flag2;
+    }
+    return res;
+}
+
+std::vector<std::vector<int>> ParallelMoor(const std::vector<int>& g,
+                                           const std::vector<int>& sources,
+                                           int* flag) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    if (rank == 0)
+        return ParallelMoor(GraphFromMatrix(g), sources, flag);
+    return ParallelMoor(Graph(), sources, flag);
+}
+
+// c[j] = min(c[j], a + b[j]) for j < len, INF entries of b are skipped
+static void MinPlusRow(int a, const int* b, int* c, int len) {
+    const int minus_inf = -1000000000;
+    int j = 0;
+#ifdef __AVX2__
+    const __m256i va = _mm256_set1_epi32(a);
+    const __m256i vinf = _mm256_set1_epi32(INF);
+    const __m256i vminus = _mm256_set1_epi32(minus_inf);
+    for (; j + 8 <= len; j += 8) {
+        __m256i vb =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + j));
+        __m256i vc = _mm256_loadu_si256(reinterpret_cast<__m256i*>(c + j));
+        __m256i sum = _mm256_max_epi32(_mm256_add_epi32(va, vb), vminus);
+        sum = _mm256_blendv_epi8(vinf, sum, _mm256_cmpgt_epi32(vinf, vb));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(c + j),
+                            _mm256_min_epi32(vc, sum));
+    }
+#endif
+    for (; j < len; ++j) {
+        int sum = b[j] < INF ? std::max(a + b[j], minus_inf) : INF;
+        c[j] = std::min(c[j], sum);
+    }
+}
+
+// c = min(c, a * b) in the (min, +) semiring, a is rows x inner,
+// b is inner x cols, c is rows x cols. Columns are processed in strips
+// so that the used rows of b stay in cache.
+static void MinPlus(const int* a, const int* b, int* c,
+                    int rows, int inner, int cols) {
+    const int strip = 512;
+    for (int j0 = 0; j0 < cols; j0 += strip) {
+        int len = std::min(strip, cols - j0);
+        for (int i = 0; i < rows; ++i)
+            for (int k = 0; k < inner; ++k)
+                if (a[i * inner + k] < INF)
+                    MinPlusRow(a[i * inner + k], b + k * cols + j0,
+                               c + i * cols + j0, len);
+    }
+}
+
+std::vector<int> ParallelFloyd(const std::vector<int>& g, int* flag) {
+    const int tile = 64;
+
+    int size, rank;
     MPI_Comm_size(MPI_COMM_WORLD, &size);
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
-    const int delta = n / size;
-    const int rem = n % size;
-    int tmp = delta + (rank < rem ? 1 : 0);
-    std::vector<int> loc(tmp * n);
-    std::vector<int> loc_d(tmp, INF);
 
-    if (loc.size() == 0)
-        loc.resize(1);
+    int n = static_cast<int>(sqrt(static_cast<int>(g.size())));
+    MPI_Bcast(&n, 1, MPI_INT, 0, MPI_COMM_WORLD);
 
-    std::vector<int> sendcounts(size);
-    std::vector<int> displs(size);
-    std::vector<int> sendcounts_d(size);
-    std::vector<int> displs_d(size);
+    // the matrix is split into pr x pc blocks of rows and columns
+    int dims[2] = {0, 0};
+    MPI_Dims_create(size, 2, dims);
+    const int pr = dims[0], pc = dims[1];
+    const int pi = rank / pc, pj = rank % pc;
+    MPI_Comm row_comm, col_comm;
+    MPI_Comm_split(MPI_COMM_WORLD, pi, pj, &row_comm);
+    MPI_Comm_split(MPI_COMM_WORLD, pj, pi, &col_comm);
 
-    displs[0] = displs_d[0] = 0;
-    for (int i = 0; i < size; ++i) {
-        sendcounts[i] = (delta + (i < rem ? 1 : 0)) * n;
-        sendcounts_d[i] = delta + (i < rem ? 1 : 0);
-        if (i > 0) {
-            displs[i] = (displs[i - 1] + sendcounts[i - 1]);
-            displs_d[i] = displs_d[i - 1] + sendcounts_d[i - 1];
+    const int r0 = BlockBegin(n, pr, pi);
+    const int lr = BlockBegin(n, pr, pi + 1) - r0;
+    const int c0 = BlockBegin(n, pc, pj);
+    const int lc = BlockBegin(n, pc, pj + 1) - c0;
+
+    std::vector<int> counts(size), displs(size, 0);
+    for (int p = 0; p < size; ++p) {
+        counts[p] = (BlockBegin(n, pr, p / pc + 1) - BlockBegin(n, pr, p / pc))
+            * (BlockBegin(n, pc, p % pc + 1) - BlockBegin(n, pc, p % pc));
+        if (p > 0)
+            displs[p] = displs[p - 1] + counts[p - 1];
+    }
+
+    std::vector<int> all;
+    if (rank == 0) {
+        all.resize(n * n);
+        for (int p = 0; p < size; ++p) {
+            int pos = displs[p];
+            for (int i = BlockBegin(n, pr, p / pc);
+                 i < BlockBegin(n, pr, p / pc + 1); ++i)
+                for (int j = BlockBegin(n, pc, p % pc);
+                     j < BlockBegin(n, pc, p % pc + 1); ++j)
+                    all[pos++] = i == j ? std::min(g[i * n + j], 0)
+                                        : g[i * n + j];
         }
     }
+    std::vector<int> d(lr * lc);
+    MPI_Scatterv(all.data(), counts.data(), displs.data(), MPI_INT,
+        d.data(), lr * lc, MPI_INT, 0, MPI_COMM_WORLD);
 
-    int root = -1;
-    for (int i = 0; i < size - 1; ++i)
-        if (source >= displs[i] / n)
-            root++;
-    if (rank == root)
-        loc_d[source - displs[rank] / n] = 0;
+    std::vector<int> piv, row, col, tmp;
+    for (int kb = 0; kb < n; kb += tile) {
+        const int w = std::min(tile, n - kb);
 
-    std::vector<int> send;
-    if (rank == 0)
-        send = Transpose(g, n);
+        // every process gets the pivot tile and closes it by itself
+        piv.assign(w * w, INF);
+        for (int i = std::max(kb, r0); i < std::min(kb + w, r0 + lr); ++i)
+            for (int j = std::max(kb, c0); j < std::min(kb + w, c0 + lc); ++j)
+                piv[(i - kb) * w + j - kb] = d[(i - r0) * lc + j - c0];
+        MPI_Allreduce(MPI_IN_PLACE, piv.data(), w * w, MPI_INT, MPI_MIN,
+            MPI_COMM_WORLD);
+        for (int k = 0; k < w; ++k)
+            for (int i = 0; i < w; ++i)
+                if (piv[i * w + k] < INF)
+                    MinPlusRow(piv[i * w + k], &piv[k * w], &piv[i * w], w);
 
-    MPI_Scatterv(send.data(), sendcounts.data(), displs.data(),
-        MPI_INT, &loc[0], tmp * n, MPI_INT, 0, MPI_COMM_WORLD);
+        // pivot rows of the own columns and pivot columns of the own rows
+        row.assign(w * lc, INF);
+        for (int i = std::max(kb, r0); i < std::min(kb + w, r0 + lr); ++i)
+            std::copy(d.begin() + (i - r0) * lc, d.begin() + (i - r0 + 1) * lc,
+                      row.begin() + (i - kb) * lc);
+        MPI_Allreduce(MPI_IN_PLACE, row.data(), w * lc, MPI_INT, MPI_MIN,
+            col_comm);
+        col.assign(lr * w, INF);
+        for (int i = 0; i < lr; ++i)
+            for (int j = std::max(kb, c0); j < std::min(kb + w, c0 + lc); ++j)
+                col[i * w + j - kb] = d[i * lc + j - c0];
+        MPI_Allreduce(MPI_IN_PLACE, col.data(), lr * w, MPI_INT, MPI_MIN,
+            row_comm);
 
-    for (int i = 0; i < n - 1; ++i) {
-        for (int k = 0; k < sendcounts_d[rank]; ++k) {
-            for (int j = 0; j < n; ++j)
-                if ((d[j] < INF) && (loc[k * n + j] < INF))
-                    if (loc_d[k] > d[j] + loc[k * n + j])
-                        loc_d[k] = std::max(d[j] + loc[k * n + j], minus_inf);
-        }
-        MPI_Allgatherv(loc_d.data(), tmp, MPI_INT, d.data(),
-            sendcounts_d.data(), displs_d.data(), MPI_INT, MPI_COMM_WORLD);
+        // paths through the pivot tile
+        tmp = row;
+        MinPlus(piv.data(), row.data(), tmp.data(), w, w, lc);
+        row.swap(tmp);
+        tmp = col;
+        MinPlus(col.data(), piv.data(), tmp.data(), lr, w, w);
+        col.swap(tmp);
+        MinPlus(col.data(), row.data(), d.data(), lr, w, lc);
     }
 
     if (flag) {
         int flag2 = 0;
+        for (int i = std::max(r0, c0); i < std::min(r0 + lr, c0 + lc); ++i)
+            if (d[(i - r0) * lc + i - c0] < 0)
+                flag2 = 1;
         *flag = 0;
-        for (int k = 0; k < sendcounts_d[rank]; ++k)
-            for (int j = 0; j < n; ++j)
-                if ((d[j] < INF) && (loc[k * n + j] < INF)) {
-                    if (loc_d[k] > d[j] + loc[k * n + j]) {
-                        loc_d[k] = minus_inf;
-                        flag2 = 1;
-                    }
-                }
         MPI_Reduce(&flag2, flag, 1, MPI_INT, MPI_LOR, 0, MPI_COMM_WORLD);
-        MPI_Allgatherv(loc_d.data(), tmp, MPI_INT, d.data(),
-            sendcounts_d.data(), displs_d.data(), MPI_INT, MPI_COMM_WORLD);
     }
-    return d;
+
+    MPI_Gatherv(d.data(), lr * lc, MPI_INT, all.data(), counts.data(),
+        displs.data(), MPI_INT, 0, MPI_COMM_WORLD);
+    MPI_Comm_free(&row_comm);
+    MPI_Comm_free(&col_comm);
+
+    std::vector<int> res;
+    if (rank == 0) {
+        res.resize(n * n);
+        for (int p = 0; p < size; ++p) {
+            int pos = displs[p];
+            for (int i = BlockBegin(n, pr, p / pc);
+                 i < BlockBegin(n, pr, p / pc + 1); ++i)
+                for (int j = BlockBegin(n, pc, p % pc);
+                     j < BlockBegin(n, pc, p % pc + 1); ++j)
+                    res[i * n + j] = all[pos++];
+        }
+    }
+    return res;
 }
 
+// SPFA: a vertex is put in the queue only when its distance drops.
+// len[k] counts the edges of the path giving d[k], a path of n edges
+// has a negative cycle, then minus_inf is spread from such vertex.
 std::vector<int> Moors_algorithm(const std::vector<int>& g, int source,
                                                             int* flag) {
     const int minus_inf = -1000000000;
@@ -122,25 +450,40 @@ std::vector<int> Moors_algorithm(const std::vector<int>& g, int source,
     if (source < 0 || source >= n)
         throw - 1;
     std::vector<int> d(n, INF);
+    std::vector<int> len(n, 0);
+    std::vector<char> queued(n, 0);
+    std::deque<int> q;
     d[source] = 0;
+    q.push_back(source);
+    queued[source] = 1;
 
-    for (int i = 0; i < n - 1; ++i)
-        for (int j = 0; j < n; ++j)
-            for (int k = 0; k < n; ++k)
-                if ((d[j] < INF) && (g[k + j * n] < INF))
-                    if (d[k] > d[j] + g[k + j * n])
-                        d[k] = std::max(d[j] + g[k + j * n], minus_inf);
-
-    if (flag) {
+    if (flag)
         *flag = 0;
-        for (int j = 0; j < n; ++j)
-            for (int k = 0; k < n; ++k)
-                if ((d[j] < INF) && (g[k + j * n] < INF)) {
-                    if (d[k] > d[j] + g[k + j * n]) {
-                        d[k] = minus_inf;
+    while (!q.empty()) {
+        int j = q.front();
+        q.pop_front();
+        queued[j] = 0;
+        for (int k = 0; k < n; ++k) {
+            if (k == j || g[k + j * n] >= INF || d[k] == minus_inf)
+                continue;
+            if (d[j] == minus_inf) {
+                d[k] = minus_inf;
+            } else if (d[k] > d[j] + g[k + j * n]) {
+                d[k] = std::max(d[j] + g[k + j * n], minus_inf);
+                len[k] = len[j] + 1;
+                if (len[k] >= n) {
+                    d[k] = minus_inf;
+                    if (flag)
                         *flag = 1;
-                    }
                 }
+            } else {
+                continue;
+            }
+            if (!queued[k]) {
+                q.push_back(k);
+                queued[k] = 1;
+            }
+        }
     }
     return d;
 }
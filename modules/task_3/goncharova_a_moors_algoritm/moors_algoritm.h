@@ -4,10 +4,35 @@
 
 #include <vector>
 
+// Weighted graph stored by incoming edges: the edges into vertex v are
+// in_src[i] -> v with weight in_w[i] for in_ptr[v] <= i < in_ptr[v + 1].
+struct Graph {
+    int n = 0;
+    std::vector<int> in_ptr;
+    std::vector<int> in_src;
+    std::vector<int> in_w;
+};
+
 std::vector<int> getRandomGraph(int size);
+Graph GraphFromMatrix(const std::vector<int>& g);
 std::vector<int> Transpose(const std::vector<int>& g, int n);
 std::vector<int> ParallelMoor(const std::vector<int>& g, int source,
                                 int* flag = nullptr);
+std::vector<int> ParallelMoor(const Graph& g, int source,
+                                int* flag = nullptr);
+// Distances from every source, the graph is distributed only once.
+// flag is set if a negative cycle is reachable from any of the sources.
+std::vector<std::vector<int>> ParallelMoor(const std::vector<int>& g,
+                                const std::vector<int>& sources,
+                                int* flag = nullptr);
+std::vector<std::vector<int>> ParallelMoor(const Graph& g,
+                                const std::vector<int>& sources,
+                                int* flag = nullptr);
+// All-pairs distances of the dense graph g by the blocked Floyd-Warshall
+// on a 2D grid of processes. The n x n result is returned on the process
+// 0 only, flag is set there if the graph has a negative cycle.
+std::vector<int> ParallelFloyd(const std::vector<int>& g,
+                                int* flag = nullptr);
 std::vector<int> Moors_algorithm(const std::vector<int>& g, int source,
                                 int* flag = nullptr);
 
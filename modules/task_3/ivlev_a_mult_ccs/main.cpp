@@ -1,7 +1,11 @@
 // Copyright 2022 Ivlev A
 #include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <string>
 #include <vector>
+#include <utility>
 #include "./mult_ccs.h"
 #include <gtest-mpi-listener.hpp>
 
@@ -136,6 +140,261 @@ TEST(Test_mult_ccs_MPI, Test_4) {
     }
 }
 
+TEST(Test_mult_ccs_MPI, Test_known_product) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    // a = {{1, 0, 2}, {0, 3, 0}, {4, 0, 5}}
+    matrix_ccs a(3, 3, 5);
+    double a_val[] = {1, 4, 3, 2, 5};
+    int a_row[] = {0, 2, 1, 0, 2};
+    int a_ind[] = {0, 2, 3};
+    for (int i = 0; i < a.val_n; i++) {
+        a.values[i] = a_val[i];
+        a.rows[i] = a_row[i];
+    }
+    for (int i = 0; i < a.n; i++) {
+        a.index[i] = a_ind[i];
+    }
+
+    // a * a = {{9, 0, 12}, {0, 9, 0}, {24, 0, 33}}
+    matrix_ccs c(3, 3, 5);
+    double c_val[] = {9, 24, 9, 12, 33};
+    int c_row[] = {0, 2, 1, 0, 2};
+    int c_ind[] = {0, 2, 3};
+    for (int i = 0; i < c.val_n; i++) {
+        c.values[i] = c_val[i];
+        c.rows[i] = c_row[i];
+    }
+    for (int i = 0; i < c.n; i++) {
+        c.index[i] = c_ind[i];
+    }
+
+    matrix_ccs d = a.mpi_mult(a);
+
+    if (rank == 0) {
+        EXPECT_EQ(c, a.mult(a));
+        EXPECT_EQ(c, d);
+    }
+}
+
+TEST(Test_mult_ccs_MPI, Test_column_views) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    if (rank == 0) {
+        matrix_ccs a(12, 9, 8);
+        a.create_rand();
+
+        matrix_ccs b(a.m, 0, 0);
+        b.add_column_matrix(a.get_column(0, 4));
+        b.add_column_matrix(a.get_column(4, 0));
+        b.add_column_matrix(a.get_column(4, 5));
+        EXPECT_EQ(a, b);
+
+        matrix_ccs c(std::move(b));
+        EXPECT_EQ(a, c);
+    }
+}
+
+TEST(Test_mult_ccs_MPI, Test_matrix_market) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    const std::string path = "ivlev_a_mult_ccs_test.mtx";
+    matrix_ccs a(40, 30, 25);
+    if (rank == 0) {
+        a.create_rand();
+        a.write_mtx(path);
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    matrix_ccs b = matrix_ccs::read_mtx_dist(path).gather_columns(0);
+
+    if (rank == 0) {
+        EXPECT_EQ(a, matrix_ccs::read_mtx(path));
+        EXPECT_EQ(a, b);
+        std::remove(path.c_str());
+    }
+}
+
+TEST(Test_mult_ccs_MPI, Test_matrix_market_symmetric) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    const std::string path = "ivlev_a_mult_ccs_sym.mtx";
+    if (rank == 0) {
+        std::ofstream out(path);
+        out << "%%MatrixMarket matrix coordinate real symmetric\n"
+            << "% comment\n"
+            << "3 3 4\n"
+            << "3 1 4\n"
+            << "1 1 1\n"
+            << "2 2 3\n"
+            << "3 3 5\n";
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    matrix_ccs b = matrix_ccs::read_mtx_dist(path).gather_columns(0);
+
+    if (rank == 0) {
+        // {{1, 0, 4}, {0, 3, 0}, {4, 0, 5}}
+        matrix_ccs a = matrix_ccs::read_mtx(path);
+        EXPECT_EQ(a.val_n, 5);
+        EXPECT_EQ(a.get(2, 0), 4);
+        EXPECT_EQ(a.get(0, 2), 4);
+        EXPECT_EQ(a.get(1, 1), 3);
+        EXPECT_EQ(a, b);
+        std::remove(path.c_str());
+    }
+}
+
+TEST(Test_mult_ccs_MPI, Test_matrix_market_bad_files) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    const std::string path = "ivlev_a_mult_ccs_bad.mtx";
+    const char* bodies[] = {
+        "0 1 1\n2 2 1\n",     // 0-based row
+        "1 1 1\n2 4 1\n",     // column past n
+        "1 1 1\n" };          // fewer entries than nnz
+    for (int t = 0; t < 3; t++) {
+        if (rank == 0) {
+            std::ofstream out(path);
+            out << "%%MatrixMarket matrix coordinate real general\n3 3 2\n";
+            // trailing comments put the bad line in the range of rank 0 only
+            out << bodies[t];
+            for (int i = 0; i < 200; i++) {
+                out << "% padding comment line\n";
+            }
+        }
+        MPI_Barrier(MPI_COMM_WORLD);
+
+        if (rank == 0) {
+            ASSERT_ANY_THROW(matrix_ccs::read_mtx(path));
+        }
+        ASSERT_ANY_THROW(matrix_ccs::read_mtx_dist(path));
+        MPI_Barrier(MPI_COMM_WORLD);
+    }
+    if (rank == 0) {
+        std::remove(path.c_str());
+    }
+    ASSERT_ANY_THROW(matrix_ccs::read_mtx_dist("ivlev_a_mult_ccs_missing.mtx"));
+}
+
+TEST(Test_mult_ccs_MPI, Test_spmv_formats) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    if (rank == 0) {
+        matrix_ccs a(37, 29, 27);
+        a.create_rand();
+
+        std::vector<double> x(a.n);
+        for (int k = 0; k < a.n; k++) {
+            x[k] = 1. / (k + 1);
+        }
+
+        std::vector<double> expected(a.m, 0.);
+        for (int i = 0; i < a.m; i++) {
+            for (int k = 0; k < a.n; k++) {
+                expected[i] += a.get(i, k) * x[k];
+            }
+        }
+
+        std::vector<double> y_ccs(a.m), y_csr(a.m), y_sell(a.m);
+        a.spmv(x.data(), y_ccs.data());
+        a.csr().spmv(x.data(), y_csr.data());
+        a.sell().spmv(x.data(), y_sell.data());
+
+        for (int i = 0; i < a.m; i++) {
+            EXPECT_NEAR(expected[i], y_ccs[i], 1e-9);
+            EXPECT_NEAR(expected[i], y_csr[i], 1e-9);
+            EXPECT_NEAR(expected[i], y_sell[i], 1e-9);
+        }
+    }
+}
+
+TEST(Test_mult_ccs_MPI, Test_dist_spmv) {
+    int size, rank;
+
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    int m = 31;
+    int n = 31;
+    matrix_ccs a(m, n, 30);
+    if (rank == 0) {
+        a.create_rand();
+    }
+
+    dist_csr d(a, 0);
+    std::vector<double> x;
+    for (int k = block_begin(n, size, rank);
+        k < block_begin(n, size, rank + 1); k++) {
+        x.push_back(1. / (k + 1));
+    }
+
+    std::vector<double> y;
+    d.apply(x, &y);
+    d.apply(x, &y);
+    // a wrong block on one rank only must not leave the others waiting
+    std::vector<double> wrong(x.size() + (rank == 0 ? 1 : 0));
+    ASSERT_ANY_THROW(d.apply(wrong, &y));
+
+    std::vector<int> counts(size), displs(size);
+    for (int i = 0; i < size; i++) {
+        displs[i] = block_begin(m, size, i);
+        counts[i] = block_begin(m, size, i + 1) - displs[i];
+    }
+    std::vector<double> y_all(m);
+    MPI_Gatherv(y.data(), static_cast<int>(y.size()), MPI_DOUBLE,
+        y_all.data(), counts.data(), displs.data(), MPI_DOUBLE, 0,
+        MPI_COMM_WORLD);
+
+    if (rank == 0) {
+        std::vector<double> x_all(n), expected(m);
+        for (int k = 0; k < n; k++) {
+            x_all[k] = 1. / (k + 1);
+        }
+        a.csr().spmv(x_all.data(), expected.data());
+        for (int i = 0; i < m; i++) {
+            EXPECT_NEAR(expected[i], y_all[i], 1e-9);
+        }
+    }
+}
+
+TEST(Test_mult_ccs_MPI, Test_cache_follows_changes) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    if (rank == 0) {
+        matrix_ccs a(25, 20, 40);
+        a.create_rand();
+        a.csr();
+        a.sell();
+
+        matrix_ccs b = a;
+        b.create_rand();
+        matrix_ccs c(25, 10, 15);
+        c.create_rand();
+        a.csr();
+        a.add_column_matrix(c);
+
+        for (matrix_ccs* t : {&a, &b}) {
+            std::vector<double> x(t->n, 1.), y_ccs(t->m), y_csr(t->m), y_sell(t->m);
+            t->spmv(x.data(), y_ccs.data());
+            t->csr().spmv(x.data(), y_csr.data());
+            t->sell().spmv(x.data(), y_sell.data());
+            ASSERT_EQ(t->n, t->csr().n);
+            for (int i = 0; i < t->m; i++) {
+                EXPECT_NEAR(y_ccs[i], y_csr[i], 1e-9);
+                EXPECT_NEAR(y_ccs[i], y_sell[i], 1e-9);
+            }
+        }
+    }
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     MPI_Init(&argc, &argv);
@@ -0,0 +1,366 @@
+// Copyright 2022 Ivlev A
+#include <mpi.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <string>
+#include <utility>
+#include <algorithm>
+#include "../../../modules/task_3/ivlev_a_mult_ccs/mult_ccs.h"
+
+namespace {
+
+// Closes the file when the reader returns or throws.
+class mtx_file {
+ public:
+    mtx_file(const std::string &path, const char* mode)
+        : file(fopen(path.c_str(), mode)) {
+        if (!file) {
+            throw "cannot open file";
+        }
+    }
+    ~mtx_file() { fclose(file); }
+    mtx_file(const mtx_file&) = delete;
+    mtx_file& operator = (const mtx_file&) = delete;
+
+    FILE* get() const { return file; }
+
+ private:
+    FILE* file;
+};
+
+// 64-bit file offsets, long is 32 bits on Windows
+int64_t file_tell(FILE* file) {
+#ifdef _WIN32
+    return _ftelli64(file);
+#else
+    return static_cast<int64_t>(ftello(file));
+#endif
+}
+
+void file_seek(FILE* file, int64_t offset, int whence) {
+#ifdef _WIN32
+    _fseeki64(file, offset, whence);
+#else
+    fseeko(file, static_cast<off_t>(offset), whence);
+#endif
+}
+
+struct mtx_header {
+    int m;
+    int n;
+    int nnz;
+    bool pattern;
+    // 0 for general, 1 for symmetric, -1 for skew-symmetric matrices
+    int mirror;
+    // byte range of the entry lines
+    int64_t data_begin;
+    int64_t data_end;
+};
+
+mtx_header read_mtx_header(FILE* file) {
+    mtx_header h;
+    char line[1024];
+
+    if (!fgets(line, sizeof(line), file)
+        || strncmp(line, "%%MatrixMarket", 14) != 0) {
+        throw "not a Matrix Market file";
+    }
+    if (!strstr(line, "coordinate") || strstr(line, "complex")) {
+        throw "only real coordinate matrices are supported";
+    }
+    h.pattern = strstr(line, "pattern") != nullptr;
+    h.mirror = strstr(line, "skew-symmetric") ? -1
+        : (strstr(line, "symmetric") ? 1 : 0);
+
+    do {
+        if (!fgets(line, sizeof(line), file)) {
+            throw "no size line in Matrix Market file";
+        }
+    } while (line[0] == '%');
+
+    if (sscanf(line, "%d %d %d", &h.m, &h.n, &h.nnz) != 3
+        || h.m < 0 || h.n < 0 || h.nnz < 0) {
+        throw "bad size line in Matrix Market file";
+    }
+    if (h.mirror != 0 && h.m != h.n) {
+        throw "symmetric Matrix Market matrix is not square";
+    }
+
+    h.data_begin = file_tell(file);
+    file_seek(file, 0, SEEK_END);
+    h.data_end = file_tell(file);
+    return h;
+}
+
+// Parses one entry line, blank and comment lines are skipped.
+// Returns the number of entry lines, 0 or 1.
+template <class F>
+int parse_line(const char* s, const mtx_header &h, F f) {
+    while (*s == ' ' || *s == '\t' || *s == '\r') {
+        s++;
+    }
+    if (*s == '\0' || *s == '%') {
+        return 0;
+    }
+
+    char* e1;
+    char* e2;
+    int row = static_cast<int>(strtol(s, &e1, 10)) - 1;
+    int col = static_cast<int>(strtol(e1, &e2, 10)) - 1;
+    if (e1 == s || e2 == e1) {
+        throw "bad entry in Matrix Market file";
+    }
+    // indices are 1-based in the file, a 0 or a value past the size would
+    // write outside the column arrays
+    if (row < 0 || row >= h.m || col < 0 || col >= h.n) {
+        throw "entry index out of range in Matrix Market file";
+    }
+    double val = h.pattern ? 1. : strtod(e2, nullptr);
+
+    f(row, col, val);
+    if (h.mirror != 0 && row != col) {
+        f(col, row, h.mirror * val);
+    }
+    return 1;
+}
+
+// Calls f(row, col, value) with zero-based indices for every entry whose
+// line starts inside [begin, end). The file is read in large chunks,
+// a line crossing begin belongs to the previous range. Returns the number
+// of entry lines in the range.
+template <class F>
+int scan_mtx(FILE* file, const mtx_header &h, int64_t begin, int64_t end,
+    F f) {
+    int entries = 0;
+    int64_t pos = begin;
+    if (begin > h.data_begin) {
+        file_seek(file, begin - 1, SEEK_SET);
+        pos = begin - 1;
+        int ch;
+        do {
+            ch = fgetc(file);
+            pos++;
+        } while (ch != EOF && ch != '\n');
+    } else {
+        file_seek(file, begin, SEEK_SET);
+    }
+
+    std::vector<char> buf(1 << 20);
+    size_t len = 0;
+    bool eof = false;
+
+    while (pos < end) {
+        if (!eof) {
+            size_t got = fread(buf.data() + len, 1, buf.size() - 1 - len,
+                file);
+            eof = (got == 0);
+            len += got;
+        }
+        buf[len] = '\0';
+
+        size_t p = 0;
+        while (pos + static_cast<int64_t>(p) < end && p < len) {
+            char* nl = static_cast<char*>(memchr(buf.data() + p, '\n',
+                len - p));
+            if (!nl && !eof) {
+                break;
+            }
+            if (nl) {
+                *nl = '\0';
+            }
+
+            entries += parse_line(buf.data() + p, h, f);
+
+            p = nl ? static_cast<size_t>(nl - buf.data()) + 1 : len;
+        }
+
+        if (eof && p >= len) {
+            break;
+        }
+        memmove(buf.data(), buf.data() + p, len - p);
+        pos += static_cast<int64_t>(p);
+        len -= p;
+        if (len + 1 == buf.size()) {
+            buf.resize(2 * buf.size());
+        }
+    }
+    return entries;
+}
+
+// Sorts the entries of every column by row.
+void sort_columns(matrix_ccs* c) {
+    std::vector<std::pair<int, double> > col;
+    for (int k = 0; k < c->n; k++) {
+        int begin = c->index[k];
+        int end = (k == c->n-1) ? c->val_n : c->index[k+1];
+        if (std::is_sorted(c->rows.begin() + begin, c->rows.begin() + end)) {
+            continue;
+        }
+
+        col.clear();
+        for (int p = begin; p < end; p++) {
+            col.push_back(std::make_pair(c->rows[p], c->values[p]));
+        }
+        std::sort(col.begin(), col.end());
+        for (int p = begin; p < end; p++) {
+            c->rows[p] = col[p - begin].first;
+            c->values[p] = col[p - begin].second;
+        }
+    }
+}
+
+// Turns per-column counts stored in (*pos)[k+1] into a matrix with
+// allocated storage. On return (*pos)[k] is the first free position of
+// column k, ready for the filling pass.
+matrix_ccs alloc_ccs(int m, std::vector<int>* pos) {
+    int n = static_cast<int>(pos->size()) - 1;
+    for (int k = 0; k < n; k++) {
+        (*pos)[k+1] += (*pos)[k];
+    }
+
+    matrix_ccs c(m, n, (*pos)[n]);
+    std::copy(pos->begin(), pos->begin() + n, c.index.begin());
+    return c;
+}
+
+}  // namespace
+
+matrix_ccs matrix_ccs::read_mtx(const std::string &path) {
+    mtx_file file(path, "rb");
+    mtx_header h = read_mtx_header(file.get());
+
+    std::vector<int> pos(h.n + 1, 0);
+    int entries = scan_mtx(file.get(), h, h.data_begin, h.data_end,
+        [&pos](int, int col, double) {
+            pos[col+1]++;
+        });
+    if (entries != h.nnz) {
+        throw "entry count does not match the Matrix Market size line";
+    }
+
+    matrix_ccs c = alloc_ccs(h.m, &pos);
+    scan_mtx(file.get(), h, h.data_begin, h.data_end,
+        [&pos, &c](int row, int col, double val) {
+            int p = pos[col]++;
+            c.rows[p] = row;
+            c.values[p] = val;
+        });
+
+    sort_columns(&c);
+    return c;
+}
+
+matrix_ccs matrix_ccs::read_mtx_dist(const std::string &path) {
+    int size, rank;
+
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    // every rank parses its own byte range and sends the entries to the
+    // owners of their columns
+    mtx_header h = mtx_header();
+    std::vector<int> send_counts(size, 0), send_displs(size, 0);
+    std::vector<int> send_rc;
+    std::vector<double> send_val;
+    int entries = 0;
+    const char* error = nullptr;
+    try {
+        mtx_file file(path, "rb");
+        h = read_mtx_header(file.get());
+
+        int64_t bytes = h.data_end - h.data_begin;
+        int64_t begin = h.data_begin + bytes * rank / size;
+        int64_t end = h.data_begin + bytes * (rank + 1) / size;
+
+        entries = scan_mtx(file.get(), h, begin, end,
+            [&send_counts, &h, size](int, int col, double) {
+                send_counts[block_owner(h.n, size, col)]++;
+            });
+        for (int i = 1; i < size; i++) {
+            send_displs[i] = send_displs[i-1] + send_counts[i-1];
+        }
+
+        int send_total = send_displs[size-1] + send_counts[size-1];
+        send_rc.resize(2 * send_total);
+        send_val.resize(send_total);
+        std::vector<int> fill(send_displs);
+        scan_mtx(file.get(), h, begin, end,
+            [&fill, &send_rc, &send_val, &h, size](int row, int col,
+                double val) {
+                int p = fill[block_owner(h.n, size, col)]++;
+                send_rc[2*p] = row;
+                send_rc[2*p+1] = col;
+                send_val[p] = val;
+            });
+    } catch (const char* message) {
+        error = message;
+    }
+
+    // a rank that failed must not leave the others waiting in the exchange
+    int failed = error != nullptr;
+    MPI_Allreduce(MPI_IN_PLACE, &failed, 1, MPI_INT, MPI_LOR, MPI_COMM_WORLD);
+    if (failed) {
+        throw error ? error : "Matrix Market file is bad on another rank";
+    }
+    MPI_Allreduce(MPI_IN_PLACE, &entries, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+    if (entries != h.nnz) {
+        throw "entry count does not match the Matrix Market size line";
+    }
+
+    std::vector<int> recv_counts(size), recv_displs(size, 0);
+    MPI_Alltoall(send_counts.data(), 1, MPI_INT, recv_counts.data(), 1,
+        MPI_INT, MPI_COMM_WORLD);
+    for (int i = 1; i < size; i++) {
+        recv_displs[i] = recv_displs[i-1] + recv_counts[i-1];
+    }
+    int recv_total = recv_displs[size-1] + recv_counts[size-1];
+
+    std::vector<double> recv_val(recv_total);
+    MPI_Alltoallv(send_val.data(), send_counts.data(), send_displs.data(),
+        MPI_DOUBLE, recv_val.data(), recv_counts.data(), recv_displs.data(),
+        MPI_DOUBLE, MPI_COMM_WORLD);
+
+    for (int i = 0; i < size; i++) {
+        send_counts[i] *= 2;
+        send_displs[i] *= 2;
+        recv_counts[i] *= 2;
+        recv_displs[i] *= 2;
+    }
+    std::vector<int> recv_rc(2 * recv_total);
+    MPI_Alltoallv(send_rc.data(), send_counts.data(), send_displs.data(),
+        MPI_INT, recv_rc.data(), recv_counts.data(), recv_displs.data(),
+        MPI_INT, MPI_COMM_WORLD);
+
+    int first = block_begin(h.n, size, rank);
+    std::vector<int> pos(block_begin(h.n, size, rank + 1) - first + 1, 0);
+    for (int t = 0; t < recv_total; t++) {
+        pos[recv_rc[2*t+1] - first + 1]++;
+    }
+
+    matrix_ccs c = alloc_ccs(h.m, &pos);
+    for (int t = 0; t < recv_total; t++) {
+        int p = pos[recv_rc[2*t+1] - first]++;
+        c.rows[p] = recv_rc[2*t];
+        c.values[p] = recv_val[t];
+    }
+
+    sort_columns(&c);
+    return c;
+}
+
+void matrix_ccs::write_mtx(const std::string &path) const {
+    mtx_file out(path, "w");
+    FILE* file = out.get();
+
+    fprintf(file, "%%%%MatrixMarket matrix coordinate real general\n");
+    fprintf(file, "%d %d %d\n", m, n, val_n);
+    for (int k = 0; k < n; k++) {
+        int end = (k == n-1) ? val_n : index[k+1];
+        for (int p = index[k]; p < end; p++) {
+            fprintf(file, "%d %d %.17g\n", rows[p] + 1, k + 1, values[p]);
+        }
+    }
+}
@@ -7,49 +7,41 @@
 #include <algorithm>
 #include "../../../modules/task_3/ivlev_a_mult_ccs/mult_ccs.h"
 
-matrix_ccs::matrix_ccs(int m_, int n_, int val_n_):
-    m(m_), n(n_), val_n(val_n_) {
-    values = new double[val_n];
-    rows = new int[val_n];
-    index = new int[n];
+ccs_view::ccs_view(const matrix_ccs &c):
+    m(c.m), n(c.n), values(c.values.data()), rows(c.rows.data()),
+    index(c.index.data()), begin(0), end(c.val_n) {}
+
+ccs_view::ccs_view(const matrix_ccs &c, int start, int col):
+    m(c.m), n(col), values(c.values.data()), rows(c.rows.data()),
+    index(c.index.data() + start) {
+    end = (start+col == c.n) ? c.val_n : c.index[start+col];
+    begin = (col == 0) ? end : index[0];
 }
 
-matrix_ccs::matrix_ccs(const matrix_ccs &c):
-    m(c.m), n(c.n), val_n(c.val_n) {
-    values = new double[val_n];
-    rows = new int[val_n];
-    index = new int[n];
-
-    for (int i = 0; i < val_n; i++) {
-        values[i] = c.values[i];
-        rows[i] = c.rows[i];
-    }
+matrix_ccs::matrix_ccs(int m_, int n_, int val_n_):
+    m(m_), n(n_), val_n(val_n_), values(val_n_), rows(val_n_), index(n_) {}
 
-    for (int i = 0; i < n; i++) {
-        index[i] = c.index[i];
+matrix_ccs::matrix_ccs(const matrix_ccs &c):
+    m(c.m), n(c.n), val_n(c.val_n), values(c.values), rows(c.rows), index(c.index) {}
+
+matrix_ccs& matrix_ccs::operator = (const matrix_ccs &c) {
+    if (this != &c) {
+        m = c.m;
+        n = c.n;
+        val_n = c.val_n;
+        values = c.values;
+        rows = c.rows;
+        index = c.index;
+        drop_cache();
     }
+    return *this;
 }
 
-void matrix_ccs::operator = (const matrix_ccs &c) {
-    this->~matrix_ccs();
-    n = c.n;
-    m = c.m;
-    val_n = c.val_n;
-    values = new double[val_n];
-    rows = new int[val_n];
-    index = new int[n];
-
-    for (int i = 0; i < val_n; i++) {
-        values[i] = c.values[i];
-        rows[i] = c.rows[i];
-    }
-
-    for (int i = 0; i < n; i++) {
-        index[i] = c.index[i];
+bool operator== (const matrix_ccs &b, const matrix_ccs &c) {
+    if (b.m != c.m || b.n != c.n || b.val_n != c.val_n) {
+        return false;
     }
-}
 
-bool operator== (const matrix_ccs &b, const matrix_ccs &c) {
     for (int i = 0; i < b.val_n; i++) {
         if (b.values[i] != c.values[i] || b.rows[i] != c.rows[i]) {
             return false;
@@ -65,7 +57,7 @@ bool operator== (const matrix_ccs &b, const matrix_ccs &c) {
     return true;
 }
 
-double matrix_ccs::get(int m_, int n_) {
+double matrix_ccs::get(int m_, int n_) const {
     if (index[n_] == val_n) {
         return(0.);
     } else {
@@ -87,6 +79,7 @@ double matrix_ccs::get(int m_, int n_) {
 }
 
 void matrix_ccs::create_rand() {
+    drop_cache();
     std::random_device rd;
     std::mt19937 gen(rd());
     std::uniform_int_distribution<> dist(0, RAND_MAX);
@@ -123,194 +116,284 @@ void matrix_ccs::create_rand() {
     }
 }
 
-matrix_ccs matrix_ccs::mult(matrix_ccs b) {
-    std::vector<double> temp_val;
-    std::vector<int> temp_row;
-    std::vector<int> temp_index;
+matrix_ccs matrix_ccs::mult(const ccs_view &b) const {
+    matrix_ccs c(m, b.n, 0);
+    c.values.reserve(val_n + b.nnz());
+    c.rows.reserve(val_n + b.nnz());
+
+    // Gustavson: column k of the result is a sum of columns of this
+    // matrix scaled by the nonzeros of column k of b. Partial sums are
+    // gathered in a dense accumulator, mark[j] == k flags row j as
+    // already touched while building column k.
+    std::vector<double> acc(m, 0.);
+    std::vector<int> mark(m, -1);
+    std::vector<int> touched;
 
-    temp_index.push_back(0);
     for (int k = 0; k < b.n; k++) {
-        for (int j = 0; j < m; j++) {
-            double sum = 0;
-            for (int i = 0; i < n; i++) {
-                sum += get(j, i) * b.get(i, k);
-            }
-            if (sum != 0) {
-                temp_val.push_back(sum);
-                temp_row.push_back(j);
+        c.index[k] = static_cast<int>(c.values.size());
+        touched.clear();
+
+        for (int p = b.index[k]; p < b.col_end(k); p++) {
+            int i = b.rows[p];
+            double b_ik = b.values[p];
+            int a_end = (i == n-1) ? val_n : index[i+1];
+            for (int q = index[i]; q < a_end; q++) {
+                int j = rows[q];
+                if (mark[j] != k) {
+                    mark[j] = k;
+                    acc[j] = 0.;
+                    touched.push_back(j);
+                }
+                acc[j] += values[q] * b_ik;
             }
         }
-        if (temp_index.back() != static_cast<int>(temp_val.size())) {
-            temp_index.push_back(static_cast<int>(temp_val.size()));
-        } else {
-            temp_index.push_back(temp_index.back());
+
+        std::sort(touched.begin(), touched.end());
+        for (size_t t = 0; t < touched.size(); t++) {
+            int j = touched[t];
+            if (acc[j] != 0) {
+                c.values.push_back(acc[j]);
+                c.rows.push_back(j);
+            }
         }
     }
 
-    matrix_ccs c(m, b.n, static_cast<int>(temp_val.size()));
-    for (int i = 0; i < c.val_n; i++) {
-        c.values[i] = temp_val[i];
-        c.rows[i] = temp_row[i];
-    }
+    c.val_n = static_cast<int>(c.values.size());
+    return c;
+}
 
-    for (int i = 0; i < c.n; i++) {
-        c.index[i] = temp_index[i];
-    }
+int block_begin(int n, int size, int rank) {
+    return rank * (n / size) + std::min(rank, n % size);
+}
 
-    return c;
+int block_owner(int n, int size, int col) {
+    int q = n / size;
+    int r = n % size;
+    if (col < r * (q + 1)) {
+        return col / (q + 1);
+    }
+    return r + (col - r * (q + 1)) / q;
 }
 
-matrix_ccs matrix_ccs::mpi_mult(matrix_ccs b) {
+matrix_ccs matrix_ccs::scatter_columns(int root) const {
     int size, rank;
 
     MPI_Comm_size(MPI_COMM_WORLD, &size);
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
 
-    int val_n_b, block_size, last_block_size;
-    int max_size = size;
-    if (m >= size) {
-        if (size != 1) {
-            block_size = m/(size-1);
-            last_block_size = m%(size-1);
-            if (last_block_size == 0) {
-                block_size -= 1;
-                last_block_size = size-1;
-            }
-        } else {
-            return mult(b);
+    int dims[2] = {m, n};
+    MPI_Bcast(dims, 2, MPI_INT, root, MPI_COMM_WORLD);
+
+    std::vector<int> col_counts(size), col_displs(size);
+    std::vector<int> val_counts(size), val_displs(size);
+    for (int i = 0; i < size; i++) {
+        col_displs[i] = block_begin(dims[1], size, i);
+        col_counts[i] = block_begin(dims[1], size, i+1) - col_displs[i];
+        if (rank == root) {
+            ccs_view v = get_column(col_displs[i], col_counts[i]);
+            val_displs[i] = v.begin;
+            val_counts[i] = v.nnz();
         }
-
-    } else {
-        block_size = 1;
-        last_block_size = 1;
-        max_size = m;
     }
-
-    if (rank == 0) {
-        for (int i = 1; i < max_size; i++) {
-            MPI_Send(values, val_n, MPI_DOUBLE, i, 0, MPI_COMM_WORLD);
-            MPI_Send(rows, val_n, MPI_INT, i, 1, MPI_COMM_WORLD);
-            MPI_Send(index, n, MPI_INT, i, 2, MPI_COMM_WORLD);
-
-            matrix_ccs d = b.get_column(last_block_size
-                + (i-1)*block_size, block_size);
-
-            int temp[1] = {d.val_n};
-            MPI_Send(temp, 1, MPI_INT, i, 6, MPI_COMM_WORLD);
-            MPI_Send(d.values, d.val_n, MPI_DOUBLE, i, 3, MPI_COMM_WORLD);
-            MPI_Send(d.rows, d.val_n, MPI_INT, i, 4, MPI_COMM_WORLD);
-            MPI_Send(d.index, d.n, MPI_INT, i, 5, MPI_COMM_WORLD);
+    MPI_Bcast(val_counts.data(), size, MPI_INT, root, MPI_COMM_WORLD);
+
+    matrix_ccs c(dims[0], col_counts[rank], val_counts[rank]);
+    MPI_Scatterv(values.data(), val_counts.data(), val_displs.data(),
+        MPI_DOUBLE, c.values.data(), c.val_n, MPI_DOUBLE, root,
+        MPI_COMM_WORLD);
+    MPI_Scatterv(rows.data(), val_counts.data(), val_displs.data(),
+        MPI_INT, c.rows.data(), c.val_n, MPI_INT, root, MPI_COMM_WORLD);
+    MPI_Scatterv(index.data(), col_counts.data(), col_displs.data(),
+        MPI_INT, c.index.data(), c.n, MPI_INT, root, MPI_COMM_WORLD);
+
+    if (c.n > 0) {
+        int base = c.index[0];
+        for (int k = 0; k < c.n; k++) {
+            c.index[k] -= base;
         }
+    }
 
-        matrix_ccs d = this->mult(b.get_column(0, last_block_size));
+    return c;
+}
 
-        for (int i = 1; i < max_size; i++) {
-            MPI_Status status;
-            int temp1[1] = {0};
-            MPI_Recv(temp1, 1, MPI_INT, i, 7, MPI_COMM_WORLD, &status);
-            int val_n_c = temp1[0];
-            matrix_ccs c(m, block_size, val_n_c);
+matrix_ccs matrix_ccs::gather_columns(int root) const {
+    int size, rank;
 
-            MPI_Recv(c.values, val_n_c, MPI_DOUBLE, i, 8,
-                MPI_COMM_WORLD, &status);
-            MPI_Recv(c.rows, val_n_c, MPI_INT, i, 9, MPI_COMM_WORLD, &status);
-            MPI_Recv(c.index, block_size, MPI_INT, i, 10,
-                MPI_COMM_WORLD, &status);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
 
-            d = d.add_column_matrix(c);
+    int local[2] = {n, val_n};
+    std::vector<int> counts(2 * size);
+    MPI_Gather(local, 2, MPI_INT, counts.data(), 2, MPI_INT, root,
+        MPI_COMM_WORLD);
+
+    std::vector<int> col_counts(size), col_displs(size, 0);
+    std::vector<int> val_counts(size), val_displs(size, 0);
+    for (int i = 0; i < size; i++) {
+        col_counts[i] = counts[2*i];
+        val_counts[i] = counts[2*i+1];
+        if (i > 0) {
+            col_displs[i] = col_displs[i-1] + col_counts[i-1];
+            val_displs[i] = val_displs[i-1] + val_counts[i-1];
         }
+    }
 
-        return d;
-    } else {
-        if (rank < max_size) {
-            MPI_Status status;
-            MPI_Recv(values, val_n, MPI_DOUBLE, 0, 0, MPI_COMM_WORLD, &status);
-            MPI_Recv(rows, val_n, MPI_INT, 0, 1, MPI_COMM_WORLD, &status);
-            MPI_Recv(index, n, MPI_INT, 0, 2, MPI_COMM_WORLD, &status);
-
-            int temp[1] = {0};
-            MPI_Recv(temp, 1, MPI_INT, 0, 6, MPI_COMM_WORLD, &status);
-            val_n_b = temp[0];
-            matrix_ccs b(n, block_size, val_n_b);
-
-            MPI_Recv(b.values, val_n_b, MPI_DOUBLE, 0, 3,
-                MPI_COMM_WORLD, &status);
-            MPI_Recv(b.rows, val_n_b, MPI_INT, 0, 4, MPI_COMM_WORLD, &status);
-            MPI_Recv(b.index, block_size, MPI_INT, 0, 5,
-                MPI_COMM_WORLD, &status);
-
-            matrix_ccs c = this->mult(b);
-
-            int temp1[1] = {c.val_n};
-            MPI_Send(temp1, 1, MPI_INT, 0, 7, MPI_COMM_WORLD);
-            MPI_Send(c.values, c.val_n, MPI_DOUBLE, 0, 8, MPI_COMM_WORLD);
-            MPI_Send(c.rows, c.val_n, MPI_INT, 0, 9, MPI_COMM_WORLD);
-            MPI_Send(c.index, c.n, MPI_INT, 0, 10, MPI_COMM_WORLD);
+    matrix_ccs c(m, 0, 0);
+    if (rank == root) {
+        c = matrix_ccs(m, col_displs[size-1] + col_counts[size-1],
+            val_displs[size-1] + val_counts[size-1]);
+    }
+
+    MPI_Gatherv(values.data(), val_n, MPI_DOUBLE, c.values.data(),
+        val_counts.data(), val_displs.data(), MPI_DOUBLE, root,
+        MPI_COMM_WORLD);
+    MPI_Gatherv(rows.data(), val_n, MPI_INT, c.rows.data(),
+        val_counts.data(), val_displs.data(), MPI_INT, root, MPI_COMM_WORLD);
+    MPI_Gatherv(index.data(), n, MPI_INT, c.index.data(),
+        col_counts.data(), col_displs.data(), MPI_INT, root, MPI_COMM_WORLD);
+
+    if (rank == root) {
+        for (int i = 0; i < size; i++) {
+            for (int k = 0; k < col_counts[i]; k++) {
+                c.index[col_displs[i] + k] += val_displs[i];
+            }
         }
-        return matrix_ccs(1, 1, 1);
     }
+
+    return c;
 }
 
-matrix_ccs matrix_ccs::get_column(int start, int col) {
-    std::vector<double> temp_val;
-    std::vector<int> temp_row;
-    std::vector<int> temp_index;
+matrix_ccs matrix_ccs::dist_mult(const matrix_ccs &b) const {
+    int size, rank;
 
-    int end = start+col;
-    for (int i = start; i < end; i++) {
-        temp_index.push_back(index[i] - index[start]);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    // Columns of a referenced by the local block of b, in ascending order.
+    // Owners of a's column blocks are ascending as well, so the requests
+    // to each rank form one contiguous run of this list.
+    std::vector<int> needed(b.rows.begin(), b.rows.begin() + b.val_n);
+    std::sort(needed.begin(), needed.end());
+    needed.erase(std::unique(needed.begin(), needed.end()), needed.end());
+
+    std::vector<int> req_counts(size, 0), req_displs(size, 0);
+    for (size_t i = 0; i < needed.size(); i++) {
+        req_counts[block_owner(b.m, size, needed[i])]++;
     }
-    if (end == n) {
-        end = val_n;
-    } else {
-        end = index[end];
+    std::vector<int> srv_counts(size), srv_displs(size, 0);
+    MPI_Alltoall(req_counts.data(), 1, MPI_INT, srv_counts.data(), 1,
+        MPI_INT, MPI_COMM_WORLD);
+    for (int i = 1; i < size; i++) {
+        req_displs[i] = req_displs[i-1] + req_counts[i-1];
+        srv_displs[i] = srv_displs[i-1] + srv_counts[i-1];
     }
 
-    for (int i = index[start]; i < end; i++) {
-        temp_val.push_back(values[i]);
-        temp_row.push_back(rows[i]);
+    // Column ids other ranks want from the local block of a
+    std::vector<int> served(srv_displs[size-1] + srv_counts[size-1]);
+    MPI_Alltoallv(needed.data(), req_counts.data(), req_displs.data(),
+        MPI_INT, served.data(), srv_counts.data(), srv_displs.data(),
+        MPI_INT, MPI_COMM_WORLD);
+
+    int first_col = block_begin(b.m, size, rank);
+    std::vector<int> srv_len(served.size());
+    std::vector<int> srv_val_counts(size, 0), srv_val_displs(size, 0);
+    for (int i = 0; i < size; i++) {
+        for (int t = srv_displs[i]; t < srv_displs[i] + srv_counts[i]; t++) {
+            int k = served[t] - first_col;
+            int k_end = (k == n-1) ? val_n : index[k+1];
+            srv_len[t] = k_end - index[k];
+            srv_val_counts[i] += srv_len[t];
+        }
+        if (i > 0) {
+            srv_val_displs[i] = srv_val_displs[i-1] + srv_val_counts[i-1];
+        }
     }
 
-    matrix_ccs c(m, col, static_cast<int>(temp_val.size()));
-    for (int i = 0; i < c.val_n; i++) {
-        c.values[i] = temp_val[i];
-        c.rows[i] = temp_row[i];
+    std::vector<int> req_len(needed.size());
+    MPI_Alltoallv(srv_len.data(), srv_counts.data(), srv_displs.data(),
+        MPI_INT, req_len.data(), req_counts.data(), req_displs.data(),
+        MPI_INT, MPI_COMM_WORLD);
+
+    std::vector<double> srv_values(srv_val_displs[size-1]
+        + srv_val_counts[size-1]);
+    std::vector<int> srv_rows(srv_values.size());
+    for (size_t t = 0, pos = 0; t < served.size(); t++) {
+        int begin = index[served[t] - first_col];
+        std::copy(values.begin() + begin, values.begin() + begin + srv_len[t],
+            srv_values.begin() + pos);
+        std::copy(rows.begin() + begin, rows.begin() + begin + srv_len[t],
+            srv_rows.begin() + pos);
+        pos += srv_len[t];
     }
 
-    for (int i = 0; i < c.n; i++) {
-        c.index[i] = temp_index[i];
+    // Needed columns of a, packed in the order of the needed list
+    matrix_ccs a(m, static_cast<int>(needed.size()), 0);
+    std::vector<int> req_val_counts(size, 0), req_val_displs(size, 0);
+    for (int i = 0; i < size; i++) {
+        for (int t = req_displs[i]; t < req_displs[i] + req_counts[i]; t++) {
+            a.index[t] = a.val_n;
+            a.val_n += req_len[t];
+            req_val_counts[i] += req_len[t];
+        }
+        if (i > 0) {
+            req_val_displs[i] = req_val_displs[i-1] + req_val_counts[i-1];
+        }
+    }
+    a.values.resize(a.val_n);
+    a.rows.resize(a.val_n);
+
+    MPI_Alltoallv(srv_values.data(), srv_val_counts.data(),
+        srv_val_displs.data(), MPI_DOUBLE, a.values.data(),
+        req_val_counts.data(), req_val_displs.data(), MPI_DOUBLE,
+        MPI_COMM_WORLD);
+    MPI_Alltoallv(srv_rows.data(), srv_val_counts.data(),
+        srv_val_displs.data(), MPI_INT, a.rows.data(),
+        req_val_counts.data(), req_val_displs.data(), MPI_INT,
+        MPI_COMM_WORLD);
+
+    // Renumber the rows of b to positions in the needed list. The map is
+    // monotonic, so row order inside the columns of b is preserved.
+    matrix_ccs b_local(b);
+    b_local.m = a.n;
+    for (int p = 0; p < b_local.val_n; p++) {
+        b_local.rows[p] = static_cast<int>(std::lower_bound(needed.begin(),
+            needed.end(), b_local.rows[p]) - needed.begin());
     }
 
-    return c;
+    return a.mult(b_local);
 }
 
-matrix_ccs matrix_ccs::add_column_matrix(matrix_ccs c) {
-    matrix_ccs d(m, n+c.n, val_n+c.val_n);
+matrix_ccs matrix_ccs::mpi_mult(const matrix_ccs &b) const {
+    int size;
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
 
-    for (int i = 0; i < d.val_n; i++) {
-        if (i < val_n) {
-            d.values[i] = values[i];
-            d.rows[i] = rows[i];
-        } else {
-            d.values[i] = c.values[i-val_n];
-            d.rows[i] = c.rows[i-val_n];
-        }
+    if (size == 1) {
+        return mult(b);
     }
 
-    for (int i = 0; i < d.n; i++) {
-        if (i < n) {
-            d.index[i] = index[i];
-            d.index[i] = index[i];
-        } else {
-            d.index[i] = c.index[i-n]+val_n;
-            d.index[i] = c.index[i-n]+val_n;
-        }
+    matrix_ccs a_local = scatter_columns(0);
+    matrix_ccs b_local = b.scatter_columns(0);
+    return a_local.dist_mult(b_local).gather_columns(0);
+}
+
+ccs_view matrix_ccs::get_column(int start, int col) const {
+    return ccs_view(*this, start, col);
+}
+
+void matrix_ccs::add_column_matrix(const ccs_view &c) {
+    drop_cache();
+    index.reserve(n + c.n);
+    for (int i = 0; i < c.n; i++) {
+        index.push_back(c.index[i] - c.begin + val_n);
     }
 
-    return d;
+    values.insert(values.end(), c.values + c.begin, c.values + c.end);
+    rows.insert(rows.end(), c.rows + c.begin, c.rows + c.end);
+    n += c.n;
+    val_n += c.nnz();
 }
 
-void matrix_ccs::print() {
+void matrix_ccs::print() const {
     std::cout << "val: ";
     for (int i = 0; i < val_n; i++) {
         std::cout << values[i] << ' ';
@@ -330,7 +413,7 @@ void matrix_ccs::print() {
     std::cout << '\n';
 }
 
-void matrix_ccs::all_print() {
+void matrix_ccs::all_print() const {
     for (int i = 0; i < m; i++) {
         for (int j = 0; j < n; j++) {
             std::cout << round(get(i, j) * 10000) / 10000 << '\t';
@@ -338,9 +421,3 @@ void matrix_ccs::all_print() {
         std::cout << '\n';
     }
 }
-
-matrix_ccs::~matrix_ccs() {
-    delete [] values;
-    delete [] rows;
-    delete [] index;
-}
@@ -5,32 +5,144 @@
 #include <mpi.h>
 #include <vector>
 #include <string>
+#include <memory>
+
+class matrix_ccs;
+
+// Non-owning view of a range of columns of a matrix_ccs.
+// index[k] and end are positions in the values/rows arrays of the
+// viewed matrix, so column k occupies [index[k], col_end(k)).
+class ccs_view {
+ public:
+    int m;
+    int n;
+    const double* values;
+    const int* rows;
+    const int* index;
+    int begin;
+    int end;
+
+    ccs_view(const matrix_ccs &c);  // NOLINT(runtime/explicit)
+    ccs_view(const matrix_ccs &c, int start, int col);
+
+    int col_end(int k) const { return k == n-1 ? end : index[k+1]; }
+    int nnz() const { return end - begin; }
+};
+
+// Compressed sparse rows, row_ptr has m+1 entries.
+class matrix_csr {
+ public:
+    int m;
+    int n;
+    std::vector<double> values;
+    std::vector<int> cols;
+    std::vector<int> row_ptr;
+
+    matrix_csr(int m_, int n_, int val_n_);
+    explicit matrix_csr(const matrix_ccs &c);
+    void spmv(const double* x, double* y) const;
+};
+
+// Sliced ELLPACK (SELL-C-sigma). Inside every window of sigma rows the
+// rows are sorted by length, then every C consecutive rows form a slice
+// stored column by column and padded to its longest row, so the kernel
+// handles C rows at once with unit-stride loads.
+class matrix_sell {
+ public:
+    static const int C = 8;
+
+    int m;
+    int n;
+    int sigma;
+    std::vector<double> values;
+    std::vector<int> cols;
+    std::vector<int> perm;
+    std::vector<int> slice_ptr;
+
+    matrix_sell(const matrix_csr &c, int sigma_);
+    void spmv(const double* x, double* y) const;
+};
 
 class matrix_ccs {
  public:
     int m;
     int n;
     int val_n;
-    double* values;
-    int* rows;
-    int* index;
+    std::vector<double> values;
+    std::vector<int> rows;
+    std::vector<int> index;
 
     matrix_ccs(int m_, int n_, int val_n_);
+    // copies start without the CSR and SELL caches, so changing a copy
+    // never leaves it with the conversions of the original
     matrix_ccs(const matrix_ccs &c);
+    matrix_ccs(matrix_ccs &&c) = default;
 
-    void operator = (const matrix_ccs &c);
+    matrix_ccs& operator = (const matrix_ccs &c);
+    matrix_ccs& operator = (matrix_ccs &&c) = default;
     friend bool operator== (const matrix_ccs &b, const matrix_ccs &c);
 
-    double get(int m_, int n_);
+    double get(int m_, int n_) const;
     void create_rand();
-    matrix_ccs mult(matrix_ccs b);
-    matrix_ccs mpi_mult(matrix_ccs b);
-    matrix_ccs get_column(int start, int col);
-    matrix_ccs add_column_matrix(matrix_ccs c);
-    void print();
-    void all_print();
-
-    ~matrix_ccs();
+    matrix_ccs mult(const ccs_view &b) const;
+    matrix_ccs mpi_mult(const matrix_ccs &b) const;
+
+    // Column-block distribution over MPI_COMM_WORLD: rank r owns the
+    // columns [block_begin(n, size, r), block_begin(n, size, r+1)).
+    matrix_ccs scatter_columns(int root) const;
+    matrix_ccs gather_columns(int root) const;
+    // this and b are local column blocks of the distributed a and b,
+    // the result is the local column block of a*b
+    matrix_ccs dist_mult(const matrix_ccs &b) const;
+    ccs_view get_column(int start, int col) const;
+    void add_column_matrix(const ccs_view &c);
+
+    // Matrix Market coordinate files. read_mtx_dist is collective, every
+    // rank parses a part of the file and gets its block of columns; if
+    // any rank finds the file bad, all of them throw.
+    static matrix_ccs read_mtx(const std::string &path);
+    static matrix_ccs read_mtx_dist(const std::string &path);
+    void write_mtx(const std::string &path) const;
+
+    // y = this * x. The CSR and SELL-C-sigma copies are built on first
+    // use and kept. The member functions that change the matrix drop them,
+    // code that writes to values, rows or index directly must call drop_cache().
+    void spmv(const double* x, double* y) const;
+    const matrix_csr& csr() const;
+    const matrix_sell& sell() const;
+    void drop_cache();
+
+    void print() const;
+    void all_print() const;
+
+ private:
+    mutable std::shared_ptr<const matrix_csr> csr_cache;
+    mutable std::shared_ptr<const matrix_sell> sell_cache;
 };
 
+// Row-block distributed CSR matrix for y = a * x. Rank r owns the rows
+// [block_begin(m, size, r), ...) of a and y and the same block of n for x.
+// The x entries of other ranks referenced by the local rows are fetched
+// in apply() with one halo exchange.
+class dist_csr {
+ public:
+    dist_csr(const matrix_ccs &a, int root);
+    void apply(const std::vector<double> &x, std::vector<double>* y);
+
+    int m;
+    int n;
+
+ private:
+    matrix_csr local;
+    int x_n;
+    std::vector<int> send_idx;
+    std::vector<int> send_counts, send_displs;
+    std::vector<int> recv_counts, recv_displs;
+    std::vector<double> send_buf;
+    std::vector<double> x_ext;
+};
+
+int block_begin(int n, int size, int rank);
+int block_owner(int n, int size, int col);
+
 #endif  // MODULES_TASK_3_IVLEV_A_MULT_CCS_MULT_CCS_H_
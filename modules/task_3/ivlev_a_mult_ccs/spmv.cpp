@@ -0,0 +1,237 @@
+// Copyright 2022 Ivlev A
+#include <mpi.h>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include "../../../modules/task_3/ivlev_a_mult_ccs/mult_ccs.h"
+
+matrix_csr::matrix_csr(int m_, int n_, int val_n_):
+    m(m_), n(n_), values(val_n_), cols(val_n_), row_ptr(m_ + 1, 0) {}
+
+matrix_csr::matrix_csr(const matrix_ccs &c):
+    m(c.m), n(c.n), values(c.val_n), cols(c.val_n), row_ptr(c.m + 1, 0) {
+    for (int p = 0; p < c.val_n; p++) {
+        row_ptr[c.rows[p] + 1]++;
+    }
+    for (int i = 0; i < m; i++) {
+        row_ptr[i+1] += row_ptr[i];
+    }
+
+    // columns are visited in order, so every row comes out sorted
+    std::vector<int> pos(row_ptr.begin(), row_ptr.end() - 1);
+    for (int k = 0; k < c.n; k++) {
+        int end = (k == c.n-1) ? c.val_n : c.index[k+1];
+        for (int p = c.index[k]; p < end; p++) {
+            int q = pos[c.rows[p]]++;
+            cols[q] = k;
+            values[q] = c.values[p];
+        }
+    }
+}
+
+void matrix_csr::spmv(const double* x, double* y) const {
+    for (int i = 0; i < m; i++) {
+        double sum = 0.;
+        for (int p = row_ptr[i]; p < row_ptr[i+1]; p++) {
+            sum += values[p] * x[cols[p]];
+        }
+        y[i] = sum;
+    }
+}
+
+matrix_sell::matrix_sell(const matrix_csr &c, int sigma_):
+    m(c.m), n(c.n), sigma(sigma_), perm(c.m) {
+    for (int i = 0; i < m; i++) {
+        perm[i] = i;
+    }
+    for (int w = 0; w < m; w += sigma) {
+        std::stable_sort(perm.begin() + w,
+            perm.begin() + std::min(w + sigma, m), [&c](int a, int b) {
+                return c.row_ptr[a+1] - c.row_ptr[a]
+                    > c.row_ptr[b+1] - c.row_ptr[b];
+            });
+    }
+
+    int slices = (m + C - 1) / C;
+    slice_ptr.assign(slices + 1, 0);
+    for (int s = 0; s < slices; s++) {
+        int width = 0;
+        for (int r = s * C; r < std::min(s * C + C, m); r++) {
+            width = std::max(width, c.row_ptr[perm[r]+1] - c.row_ptr[perm[r]]);
+        }
+        slice_ptr[s+1] = slice_ptr[s] + width * C;
+    }
+
+    // padding multiplies a zero by x[0]
+    values.assign(slice_ptr[slices], 0.);
+    cols.assign(slice_ptr[slices], 0);
+    for (int r = 0; r < m; r++) {
+        int row = perm[r];
+        int base = slice_ptr[r / C] + r % C;
+        for (int j = 0; j < c.row_ptr[row+1] - c.row_ptr[row]; j++) {
+            values[base + j * C] = c.values[c.row_ptr[row] + j];
+            cols[base + j * C] = c.cols[c.row_ptr[row] + j];
+        }
+    }
+}
+
+void matrix_sell::spmv(const double* x, double* y) const {
+    int slices = static_cast<int>(slice_ptr.size()) - 1;
+    for (int s = 0; s < slices; s++) {
+        double acc[C];
+        for (int r = 0; r < C; r++) {
+            acc[r] = 0.;
+        }
+        for (int p = slice_ptr[s]; p < slice_ptr[s+1]; p += C) {
+            for (int r = 0; r < C; r++) {
+                acc[r] += values[p + r] * x[cols[p + r]];
+            }
+        }
+        for (int r = s * C; r < std::min(s * C + C, m); r++) {
+            y[perm[r]] = acc[r - s * C];
+        }
+    }
+}
+
+void matrix_ccs::spmv(const double* x, double* y) const {
+    std::fill(y, y + m, 0.);
+    for (int k = 0; k < n; k++) {
+        int end = (k == n-1) ? val_n : index[k+1];
+        double x_k = x[k];
+        for (int p = index[k]; p < end; p++) {
+            y[rows[p]] += values[p] * x_k;
+        }
+    }
+}
+
+const matrix_csr& matrix_ccs::csr() const {
+    if (!csr_cache) {
+        csr_cache = std::make_shared<const matrix_csr>(*this);
+    }
+    return *csr_cache;
+}
+
+const matrix_sell& matrix_ccs::sell() const {
+    if (!sell_cache) {
+        sell_cache = std::make_shared<const matrix_sell>(csr(),
+            32 * matrix_sell::C);
+    }
+    return *sell_cache;
+}
+
+void matrix_ccs::drop_cache() {
+    csr_cache.reset();
+    sell_cache.reset();
+}
+
+dist_csr::dist_csr(const matrix_ccs &a, int root): local(0, 0, 0), x_n(0) {
+    int size, rank;
+
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    int dims[2] = {a.m, a.n};
+    MPI_Bcast(dims, 2, MPI_INT, root, MPI_COMM_WORLD);
+    m = dims[0];
+    n = dims[1];
+
+    const matrix_csr* full = (rank == root) ? &a.csr() : nullptr;
+    std::vector<int> row_counts(size), row_displs(size);
+    std::vector<int> val_counts(size, 0), val_displs(size, 0);
+    for (int i = 0; i < size; i++) {
+        row_displs[i] = block_begin(m, size, i);
+        row_counts[i] = block_begin(m, size, i+1) - row_displs[i];
+        if (full) {
+            val_displs[i] = full->row_ptr[row_displs[i]];
+            val_counts[i] = full->row_ptr[row_displs[i] + row_counts[i]]
+                - val_displs[i];
+        }
+    }
+    MPI_Bcast(val_counts.data(), size, MPI_INT, root, MPI_COMM_WORLD);
+
+    local = matrix_csr(row_counts[rank], n, val_counts[rank]);
+    MPI_Scatterv(full ? full->values.data() : nullptr, val_counts.data(),
+        val_displs.data(), MPI_DOUBLE, local.values.data(),
+        val_counts[rank], MPI_DOUBLE, root, MPI_COMM_WORLD);
+    MPI_Scatterv(full ? full->cols.data() : nullptr, val_counts.data(),
+        val_displs.data(), MPI_INT, local.cols.data(), val_counts[rank],
+        MPI_INT, root, MPI_COMM_WORLD);
+    MPI_Scatterv(full ? full->row_ptr.data() : nullptr, row_counts.data(),
+        row_displs.data(), MPI_INT, local.row_ptr.data(), local.m,
+        MPI_INT, root, MPI_COMM_WORLD);
+    int base = local.m > 0 ? local.row_ptr[0] : 0;
+    for (int i = 0; i < local.m; i++) {
+        local.row_ptr[i] -= base;
+    }
+    local.row_ptr[local.m] = val_counts[rank];
+
+    // x entries owned by other ranks, sorted, so the requests to every
+    // owner form one contiguous run
+    int x_begin = block_begin(n, size, rank);
+    int x_end = block_begin(n, size, rank + 1);
+    std::vector<int> halo;
+    for (size_t p = 0; p < local.cols.size(); p++) {
+        if (local.cols[p] < x_begin || local.cols[p] >= x_end) {
+            halo.push_back(local.cols[p]);
+        }
+    }
+    std::sort(halo.begin(), halo.end());
+    halo.erase(std::unique(halo.begin(), halo.end()), halo.end());
+
+    recv_counts.assign(size, 0);
+    recv_displs.assign(size, 0);
+    for (size_t t = 0; t < halo.size(); t++) {
+        recv_counts[block_owner(n, size, halo[t])]++;
+    }
+    send_counts.assign(size, 0);
+    send_displs.assign(size, 0);
+    MPI_Alltoall(recv_counts.data(), 1, MPI_INT, send_counts.data(), 1,
+        MPI_INT, MPI_COMM_WORLD);
+    for (int i = 1; i < size; i++) {
+        recv_displs[i] = recv_displs[i-1] + recv_counts[i-1];
+        send_displs[i] = send_displs[i-1] + send_counts[i-1];
+    }
+
+    send_idx.resize(send_displs[size-1] + send_counts[size-1]);
+    MPI_Alltoallv(halo.data(), recv_counts.data(), recv_displs.data(),
+        MPI_INT, send_idx.data(), send_counts.data(), send_displs.data(),
+        MPI_INT, MPI_COMM_WORLD);
+    for (size_t t = 0; t < send_idx.size(); t++) {
+        send_idx[t] -= x_begin;
+    }
+    send_buf.resize(send_idx.size());
+
+    // local columns: own x entries first, then the halo
+    x_n = x_end - x_begin;
+    for (size_t p = 0; p < local.cols.size(); p++) {
+        int col = local.cols[p];
+        if (col >= x_begin && col < x_end) {
+            local.cols[p] = col - x_begin;
+        } else {
+            local.cols[p] = x_n + static_cast<int>(std::lower_bound(
+                halo.begin(), halo.end(), col) - halo.begin());
+        }
+    }
+    local.n = x_n + static_cast<int>(halo.size());
+    x_ext.resize(local.n);
+}
+
+void dist_csr::apply(const std::vector<double> &x, std::vector<double>* y) {
+    // every rank checks its block before the exchange, so a wrong size
+    // on one rank makes all of them throw instead of waiting for it
+    int bad = static_cast<int>(x.size()) != x_n;
+    MPI_Allreduce(MPI_IN_PLACE, &bad, 1, MPI_INT, MPI_LOR, MPI_COMM_WORLD);
+    if (bad) {
+        throw "x is not the local block of its rank";
+    }
+    for (size_t t = 0; t < send_idx.size(); t++) {
+        send_buf[t] = x[send_idx[t]];
+    }
+    std::copy(x.begin(), x.end(), x_ext.begin());
+    MPI_Alltoallv(send_buf.data(), send_counts.data(), send_displs.data(),
+        MPI_DOUBLE, x_ext.data() + x.size(), recv_counts.data(),
+        recv_displs.data(), MPI_DOUBLE, MPI_COMM_WORLD);
+
+    y->resize(local.m);
+    local.spmv(x_ext.data(), y->data());
+}
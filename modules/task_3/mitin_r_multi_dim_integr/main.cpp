@@ -1,5 +1,6 @@
 // Copyright 2022 Mitin Roman
 #include <gtest/gtest.h>
+#include <array>
 #include <cmath>
 #include <gtest-mpi-listener.hpp>
 #include "./multi_dim_integr.h"
@@ -105,6 +106,58 @@ TEST(integrate_rectan_metod, test) {
 }
 
 
+TEST(integrate_nd, gauss_legendre_6d) {
+    std::array<range_t, 6> ranges;
+    for (int i = 0; i < 6; i++) ranges[i] = range_t{0.0, 1.0, 2};
+
+    auto lambda = [](const std::array<double, 6>& x) {
+        double res = 1.0;
+        for (int i = 0; i < 6; i++) res *= std::cos(x[i]);
+        return res;
+    };
+
+    double actual = integrate_nd<6>(lambda, ranges);
+
+    EXPECT_NEAR(std::pow(std::sin(1.0), 6), actual, 1e-10);
+}
+
+TEST(integrate_nd, simpson_exact_for_cubic) {
+    std::array<range_t, 2> ranges = {{range_t{-1.0, 2.0, 3}, range_t{0.0, 1.0, 1}}};
+
+    auto lambda = [](const std::array<double, 2>& x) {
+        return x[0] * x[0] * x[0] * x[1] + x[1] * x[1];
+    };
+
+    double actual = integrate_nd<2>(lambda, ranges, rule_t::simpson);
+
+    EXPECT_NEAR((16.0 - 1.0) / 4 / 2 + 3.0 / 3, actual, 1e-12);
+}
+
+TEST(integrate_nd, batch_function) {
+    std::array<range_t, 3> ranges;
+    for (int i = 0; i < 3; i++) ranges[i] = range_t{0.0, 1.0, 4};
+
+    // exp(x + y) * exp(z) with one exp per row for the outer part
+    auto batch = [](std::array<double, 3>* x, const double* inner, uint64_t count, double* out) {
+        const double outer = std::exp((*x)[0] + (*x)[1]);
+        for (uint64_t j = 0; j < count; j++) out[j] = outer * std::exp(inner[j]);
+    };
+
+    double actual = integrate_batch<3>(batch, ranges);
+
+    EXPECT_NEAR(std::pow(M_E - 1.0, 3), actual, 1e-9);
+}
+
+TEST(integrate_nd, more_ranks_than_rows) {
+    std::array<range_t, 1> ranges = {{range_t{0.0, 3.0, 1}}};
+
+    auto lambda = [](const std::array<double, 1>& x) {
+        return x[0] * x[0];
+    };
+
+    EXPECT_NEAR(9.0, integrate_nd<1>(lambda, ranges), 1e-12);
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     MPI_Init(&argc, &argv);
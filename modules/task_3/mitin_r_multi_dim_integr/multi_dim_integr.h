@@ -3,72 +3,175 @@
 #define MODULES_TASK_3_MITIN_R_MULTI_DIM_INTEGR_MULTI_DIM_INTEGR_H_
 
 #include <mpi.h>
+#include <algorithm>
+#include <array>
 #include <cinttypes>
+#include <vector>
 
 struct range_t {
     double a, b;
     uint64_t n;
 };
 
-template<typename func_t>
-double integrate_seq(func_t func, range_t ranges[3]) {
-    double h[3];
+enum class rule_t { left_rectangle, midpoint, simpson, gauss_legendre };
 
-    for (int i = 0; i < 3; i++) {
-        h[i] = (ranges[i].b - ranges[i].a) / ranges[i].n;
-    }
+// Nodes and weights of a composite rule on the n cells of a range
+struct nodes_t {
+    std::vector<double> x;
+    std::vector<double> w;
+};
 
-    double res = 0.0;
-    double elem_volume = h[0] * h[1] * h[2];
+// Every node is computed from its cell index, so there is no drift from
+// adding h in a loop. Gauss-Legendre uses 4 nodes per cell.
+inline nodes_t make_nodes(const range_t& range, rule_t rule) {
+    static const double gl_x[4] = {-0.861136311594052575, -0.339981043584856265,
+                                   0.339981043584856265, 0.861136311594052575};
+    static const double gl_w[4] = {0.347854845137453857, 0.652145154862546143,
+                                   0.652145154862546143, 0.347854845137453857};
+
+    nodes_t nodes;
+    const double h = (range.b - range.a) / range.n;
+    for (uint64_t i = 0; i < range.n; i++) {
+        const double left = range.a + h * i;
+        switch (rule) {
+        case rule_t::left_rectangle:
+            nodes.x.push_back(left);
+            nodes.w.push_back(h);
+            break;
+        case rule_t::midpoint:
+            nodes.x.push_back(left + h / 2);
+            nodes.w.push_back(h);
+            break;
+        case rule_t::simpson:
+            // neighbour cells share the node between them
+            if (i == 0) {
+                nodes.x.push_back(left);
+                nodes.w.push_back(h / 6);
+            } else {
+                nodes.w.back() += h / 6;
+            }
+            nodes.x.push_back(left + h / 2);
+            nodes.w.push_back(4 * h / 6);
+            nodes.x.push_back(range.a + h * (i + 1));
+            nodes.w.push_back(h / 6);
+            break;
+        case rule_t::gauss_legendre:
+            for (int k = 0; k < 4; k++) {
+                nodes.x.push_back(left + h / 2 * (1 + gl_x[k]));
+                nodes.w.push_back(h / 2 * gl_w[k]);
+            }
+            break;
+        }
+    }
+    return nodes;
+}
 
-    double x, y, z;
-    x = ranges[0].a;
+// Adapts func(const std::array<double, dim>&) to the batch interface
+template<int dim, typename func_t>
+struct pointwise_t {
+    func_t func;
 
-    for ( int i = 0; i < ranges[0].n; x += h[0], i++ ) {
-        y = ranges[1].a;
-        for ( int j = 0; j < ranges[1].n; y += h[1], j++ ) {
-            z = ranges[2].a;
-            for ( int k = 0; k < ranges[2].n; z += h[2], k++ ) {
-                res += func(x, y, z) * elem_volume;
-            }
+    void operator()(std::array<double, dim>* x, const double* inner, uint64_t count, double* out) const {
+        for (uint64_t j = 0; j < count; j++) {
+            (*x)[dim - 1] = inner[j];
+            out[j] = func(*x);
         }
     }
+};
 
-    return res;
+template<int dim>
+uint64_t total_nodes(const std::array<nodes_t, dim>& nodes) {
+    uint64_t total = 1;
+    for (int d = 0; d < dim; d++) total *= nodes[d].x.size();
+    return total;
 }
 
+// Sum over the nodes [begin, end) of the tensor grid numbered row by row,
+// the last dimension changing fastest. Each row part is passed to
+// batch(x, inner, count, out) at once: x holds the other coordinates,
+// out gets the values at the count innermost nodes.
+template<int dim, typename batch_t>
+double integrate_block(const batch_t& batch, const std::array<nodes_t, dim>& nodes, uint64_t begin, uint64_t end) {
+    const nodes_t& inner = nodes[dim - 1];
+    const uint64_t row_size = inner.x.size();
+    std::vector<double> values(row_size);
+    std::array<double, dim> x;
 
-template<typename func_t>
-double integrate(func_t func, range_t ranges[3]) {
+    double res = 0.0;
+    for (uint64_t pos = begin; pos < end;) {
+        const uint64_t first = pos % row_size;
+        const uint64_t count = std::min(row_size - first, end - pos);
+
+        double weight = 1.0;
+        uint64_t row = pos / row_size;
+        for (int d = dim - 2; d >= 0; d--) {
+            const uint64_t idx = row % nodes[d].x.size();
+            row /= nodes[d].x.size();
+            x[d] = nodes[d].x[idx];
+            weight *= nodes[d].w[idx];
+        }
+
+        batch(&x, inner.x.data() + first, count, values.data());
+        double row_res = 0.0;
+        for (uint64_t j = 0; j < count; j++) row_res += values[j] * inner.w[first + j];
+        res += weight * row_res;
+        pos += count;
+    }
+    return res;
+}
+
+// Tensor-product cubature over dim ranges. The grid nodes are numbered
+// row by row and every rank gets an equal contiguous block of them, so
+// the load is balanced for any number of ranks up to the number of
+// nodes. The result is returned on every rank.
+template<int dim, typename batch_t>
+double integrate_batch(const batch_t& batch, const std::array<range_t, dim>& ranges,
+                       rule_t rule = rule_t::gauss_legendre) {
     int size;
     int rank;
 
     MPI_Comm_size(MPI_COMM_WORLD, &size);
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
 
-    double lenght = (ranges[0].b - ranges[0].a) / size;
+    std::array<nodes_t, dim> nodes;
+    for (int d = 0; d < dim; d++) nodes[d] = make_nodes(ranges[d], rule);
 
-    ranges[0].a += lenght * rank;
-    ranges[0].b = ranges[0].a + lenght;
-    ranges[0].n = (ranges[0].n + size - 1) / size;
+    const uint64_t total = total_nodes<dim>(nodes);
+    const uint64_t block = total / size, rem = total % size;
+    const uint64_t begin = block * rank + std::min<uint64_t>(rank, rem);
+    const uint64_t end = begin + block + (static_cast<uint64_t>(rank) < rem);
 
-    static int c = 0;
-    c++;
-
-    // if ( c < 10)
-    //     printf("HELLO from %lf\n", ranges[0].a);
+    double local_res = integrate_block<dim>(batch, nodes, begin, end);
+    double global_res = 0;
+    MPI_Allreduce(&local_res, &global_res, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    return global_res;
+}
 
+template<int dim, typename func_t>
+double integrate_nd(func_t func, const std::array<range_t, dim>& ranges, rule_t rule = rule_t::gauss_legendre) {
+    return integrate_batch<dim>(pointwise_t<dim, func_t>{func}, ranges, rule);
+}
 
-    double local_res = integrate_seq(func, ranges);
-    double global_res = 0;
+template<typename func_t>
+struct xyz_t {
+    func_t func;
 
-    // printf("local res = %lf\n", local_res);
+    double operator()(const std::array<double, 3>& x) const { return func(x[0], x[1], x[2]); }
+};
 
-    MPI_Allreduce(&local_res, &global_res, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+template<typename func_t>
+double integrate_seq(func_t func, range_t ranges[3]) {
+    std::array<nodes_t, 3> nodes;
+    for (int d = 0; d < 3; d++) nodes[d] = make_nodes(ranges[d], rule_t::left_rectangle);
 
-    // printf("global res = %lf\n", global_res);
+    pointwise_t<3, xyz_t<func_t>> batch{xyz_t<func_t>{func}};
+    return integrate_block<3>(batch, nodes, 0, total_nodes<3>(nodes));
+}
 
-    return global_res;
+template<typename func_t>
+double integrate(func_t func, range_t ranges[3]) {
+    std::array<range_t, 3> r = {{ranges[0], ranges[1], ranges[2]}};
+    return integrate_nd<3>(xyz_t<func_t>{func}, r, rule_t::left_rectangle);
 }
 
 #endif  // MODULES_TASK_3_MITIN_R_MULTI_DIM_INTEGR_MULTI_DIM_INTEGR_H_
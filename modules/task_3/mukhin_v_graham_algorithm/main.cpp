@@ -1,5 +1,6 @@
 // Copyright 2022 MUKHIN VADIM
 #include <gtest/gtest.h>
+#include <random>
 #include <vector>
 #include "./ops_mpi.h"
 #include <gtest-mpi-listener.hpp>
@@ -109,6 +110,45 @@ TEST(Parallel_Operations_MPI, GrahamParallel_Method_4) {
     }
 }
 
+TEST(Parallel_Operations_MPI, Merge_Hulls) {
+    vector<Point> first = random(40), second = random(90);
+    for (size_t i = 0; i < second.size(); ++i) second[i].x += 5;
+    vector<Point> all = first;
+    all.insert(all.end(), second.begin(), second.end());
+
+    vector<Point> merged = MergeHulls(GrahamMethod(first), GrahamMethod(second));
+    vector<Point> expected = GrahamMethod(all);
+    ASSERT_EQ(expected.size(), merged.size());
+    for (vector<int>::size_type i = 0; i < expected.size(); ++i) {
+        ASSERT_EQ(expected[i].x, merged[i].x);
+        ASSERT_EQ(expected[i].y, merged[i].y);
+    }
+}
+
+TEST(Parallel_Operations_MPI, GrahamParallel_Method_Wide) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    std::vector<Point> global_vec;
+    const vector<int>::size_type size = 20000;
+
+    if (rank == 0) {
+        std::mt19937 gen(3);
+        for (vector<int>::size_type i = 0; i < size; i++)
+            global_vec.push_back(Point(gen() % 100000, gen() % 100000));
+    }
+
+    vector<Point> parallel = parallelGrahamMethod(global_vec, size);
+
+    if (rank == 0) {
+        vector<Point> not_parallel = GrahamMethod(global_vec);
+        ASSERT_EQ(parallel.size(), not_parallel.size());
+        for (vector<int>::size_type i = 0; i < parallel.size(); ++i) {
+            ASSERT_EQ(parallel[i].x, not_parallel[i].x);
+            ASSERT_EQ(parallel[i].y, not_parallel[i].y);
+        }
+    }
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     MPI_Init(&argc, &argv);
@@ -6,16 +6,20 @@
 #include <random>
 #include <algorithm>
 #include <numeric>
+#include <cstdint>
 
 bool cmp(Point a, Point b) { return a.x < b.x || a.x == b.x && a.y < b.y; }
 
-bool cw(Point a, Point b, Point c) {
-    return a.x * (b.y - c.y) + b.x * (c.y - a.y) + c.x * (a.y - b.y) < 0;
+// Twice the signed area of abc in 64 bits, so the products of the
+// coordinates do not overflow
+static int64_t area(Point a, Point b, Point c) {
+    return static_cast<int64_t>(b.x - a.x) * (c.y - a.y) -
+        static_cast<int64_t>(b.y - a.y) * (c.x - a.x);
 }
 
-bool ccw(Point a, Point b, Point c) {
-    return a.x * (b.y - c.y) + b.x * (c.y - a.y) + c.x * (a.y - b.y) > 0;
-}
+bool cw(Point a, Point b, Point c) { return area(a, b, c) < 0; }
+
+bool ccw(Point a, Point b, Point c) { return area(a, b, c) > 0; }
 
 vector<Point> random(const vector<int>::size_type Size) {
     std::mt19937 gen(10);
@@ -39,9 +43,10 @@ void StructPoint(MPI_Datatype* structPoint) {
     MPI_Type_commit(structPoint);
 }
 
-vector<Point> GrahamMethod(vector<Point> VertexVector) {
-    if (VertexVector.size() == 1) return VertexVector;
-    sort(VertexVector.begin(), VertexVector.end(), &cmp);
+// Convex hull of points sorted by cmp: the upper chain from left to
+// right, then the lower chain back, collinear points are dropped
+vector<Point> GrahamSorted(const vector<Point>& VertexVector) {
+    if (VertexVector.size() <= 1) return VertexVector;
     Point p1 = VertexVector[0], p2 = VertexVector.back();
 
     vector<Point> up, down;
@@ -69,6 +74,89 @@ vector<Point> GrahamMethod(vector<Point> VertexVector) {
     return Vertex;
 }
 
+vector<Point> GrahamMethod(vector<Point> VertexVector) {
+    sort(VertexVector.begin(), VertexVector.end(), &cmp);
+    return GrahamSorted(VertexVector);
+}
+
+// The vertices of a hull go by cmp up to the rightmost one and back, so
+// the two runs are merged into sorted order in linear time
+static vector<Point> SortedVertices(const vector<Point>& hull) {
+    if (hull.empty()) return hull;
+    size_t right = 0;
+    while (right + 1 < hull.size() && cmp(hull[right], hull[right + 1]))
+        right++;
+
+    vector<Point> res(hull.size());
+    std::merge(hull.begin(), hull.begin() + right + 1, hull.rbegin(),
+        hull.rend() - right - 1, res.begin(), &cmp);
+    return res;
+}
+
+vector<Point> MergeHulls(const vector<Point>& first,
+    const vector<Point>& second) {
+    vector<Point> a = SortedVertices(first), b = SortedVertices(second);
+    vector<Point> VertexVector(a.size() + b.size());
+    std::merge(a.begin(), a.end(), b.begin(), b.end(), VertexVector.begin(),
+        &cmp);
+    return GrahamSorted(VertexVector);
+}
+
+vector<Point> FilterInterior(const vector<Point>& VertexVector,
+    const vector<Point>& polygon) {
+    if (polygon.size() < 3) return VertexVector;
+
+    vector<Point> res;
+    for (size_t i = 0; i < VertexVector.size(); ++i) {
+        bool inside = true;
+        for (size_t j = 0; j < polygon.size() && inside; ++j) {
+            const Point& next = polygon[j + 1 < polygon.size() ? j + 1 : 0];
+            inside = cw(polygon[j], next, VertexVector[i]);
+        }
+        if (!inside) res.push_back(VertexVector[i]);
+    }
+    return res;
+}
+
+// Extreme points in the directions -y, x - y, x, x + y, y, y - x, -x,
+// -x - y. The x of the last element is 0 if a process has no points.
+static const int extremeCount = 8;
+
+static int64_t DirectionKey(int dir, const Point& p) {
+    const int64_t x = p.x, y = p.y;
+    switch (dir) {
+        case 0: return -y;
+        case 1: return x - y;
+        case 2: return x;
+        case 3: return x + y;
+        case 4: return y;
+        case 5: return y - x;
+        case 6: return -x;
+        default: return -x - y;
+    }
+}
+
+// Ties are broken by cmp, so the result does not depend on the order of
+// the operands of the reduction
+static void MergeExtremes(const Point* in, Point* inout) {
+    if (in[extremeCount].x == 0) return;
+    if (inout[extremeCount].x == 0) {
+        std::copy(in, in + extremeCount + 1, inout);
+        return;
+    }
+    for (int dir = 0; dir < extremeCount; dir++) {
+        int64_t a = DirectionKey(dir, in[dir]);
+        int64_t b = DirectionKey(dir, inout[dir]);
+        if (a > b || (a == b && cmp(in[dir], inout[dir]))) inout[dir] = in[dir];
+    }
+}
+
+static void ExtremesOp(void* in, void* inout, int* len, MPI_Datatype*) {
+    for (int i = 0; i < *len; i++)
+        MergeExtremes(static_cast<Point*>(in) + i * (extremeCount + 1),
+            static_cast<Point*>(inout) + i * (extremeCount + 1));
+}
+
 vector<Point> parallelGrahamMethod(vector<Point> VertexVector,
     vector<int>::size_type vectorSize) {
     int size, rank;
@@ -78,59 +166,61 @@ vector<Point> parallelGrahamMethod(vector<Point> VertexVector,
     MPI_Datatype structPoint;
     StructPoint(&structPoint);
 
-    if (rank == 0) {
-        Point x = VertexVector[vectorSize - 1];
-        if (vectorSize < size) {
-            for (int i = vectorSize; i < size; i++) {
-                VertexVector.push_back(x);
-                vectorSize++;
-            }
-        }
+    vector<int> counts(size), displs(size, 0);
+    for (int i = 0; i < size; i++) {
+        counts[i] = vectorSize / size + (i < static_cast<int>(vectorSize % size));
+        if (i > 0) displs[i] = displs[i - 1] + counts[i - 1];
     }
 
-    int delta = vectorSize / size;
-    if (delta == 0) delta = 1;
+    vector<Point> localVectorOfVertex(counts[rank]);
+    MPI_Scatterv(VertexVector.data(), counts.data(), displs.data(), structPoint,
+        localVectorOfVertex.data(), counts[rank], structPoint, 0,
+        MPI_COMM_WORLD);
 
-    vector<Point> localVectorOfVertex(delta);
-    vector<Point> localGrahamMethod, globalGrahamMethod;
+    // Akl-Toussaint heuristic: the points strictly inside the polygon of
+    // the extreme points are not on the hull
+    vector<Point> extremes(extremeCount + 1);
+    for (size_t i = 0; i < localVectorOfVertex.size(); ++i) {
+        vector<Point> single(extremeCount + 1, localVectorOfVertex[i]);
+        single[extremeCount] = Point(1, 0);
+        MergeExtremes(single.data(), extremes.data());
+    }
 
-    MPI_Scatter(VertexVector.data(), delta, structPoint,
-        localVectorOfVertex.data(), delta, structPoint, 0,
+    MPI_Datatype extremesType;
+    MPI_Type_contiguous(extremeCount + 1, structPoint, &extremesType);
+    MPI_Type_commit(&extremesType);
+    MPI_Op op;
+    MPI_Op_create(ExtremesOp, 1, &op);
+    MPI_Allreduce(MPI_IN_PLACE, extremes.data(), 1, extremesType, op,
         MPI_COMM_WORLD);
-    localGrahamMethod = GrahamMethod(localVectorOfVertex);
-
-    if (rank != 0) {
-        MPI_Send(localGrahamMethod.data(), localGrahamMethod.size(), structPoint, 0,
-            0, MPI_COMM_WORLD);
-    } else {
-        for (int i = 1; i < size; i++) {
+    MPI_Op_free(&op);
+    MPI_Type_free(&extremesType);
+
+    extremes.pop_back();
+    vector<Point> localGrahamMethod = GrahamMethod(
+        FilterInterior(localVectorOfVertex, GrahamMethod(extremes)));
+
+    // Binomial tree: at step s the process r + s sends its hull to r
+    for (int step = 1; step < size; step *= 2) {
+        if (rank % (2 * step) == step) {
+            MPI_Send(localGrahamMethod.data(), localGrahamMethod.size(),
+                structPoint, rank - step, 0, MPI_COMM_WORLD);
+            localGrahamMethod.clear();
+            break;
+        }
+        if (rank + step < size) {
             MPI_Status status;
             int sendElements = 0;
-            MPI_Probe(i, 0, MPI_COMM_WORLD, &status);
+            MPI_Probe(rank + step, 0, MPI_COMM_WORLD, &status);
             MPI_Get_count(&status, structPoint, &sendElements);
 
-            vector<int>::size_type oldSize = localGrahamMethod.size();
-            localGrahamMethod.resize(oldSize + sendElements);
-            MPI_Recv(localGrahamMethod.data() + oldSize, sendElements, structPoint, i,
-                0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-        }
-        if (size != 1) {
-            int tail = vectorSize - size * delta;
-            if (tail) {
-                localVectorOfVertex = vector<Point>(
-                    VertexVector.begin() + (vectorSize - tail), VertexVector.end());
-                globalGrahamMethod = GrahamMethod(localVectorOfVertex);
-
-                vector<int>::size_type oldSize = localGrahamMethod.size();
-                localGrahamMethod.resize(oldSize + globalGrahamMethod.size());
-                for (vector<int>::size_type i = oldSize, j = 0;
-                    i < localGrahamMethod.size(); i++, j++) {
-                    localGrahamMethod[i] = globalGrahamMethod[j];
-                }
-            }
+            vector<Point> other(sendElements);
+            MPI_Recv(other.data(), sendElements, structPoint, rank + step, 0,
+                MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            localGrahamMethod = MergeHulls(localGrahamMethod, other);
         }
-        globalGrahamMethod = GrahamMethod(localGrahamMethod);
     }
 
-    return globalGrahamMethod;
+    MPI_Type_free(&structPoint);
+    return localGrahamMethod;
 }
@@ -1,6 +1,8 @@
 // Copyright 2022 Pronina Tatiana
 
 #include <gtest/gtest.h>
+#include <cstdio>
+#include <string>
 #include <vector>
 #include "./pronina_t_matrix_multiplication.h"
 #include <gtest-mpi-listener.hpp>
@@ -15,10 +17,24 @@ TEST(CCS_Matrix_mult, Sequential_multiplication) {
     A = CCS(std::vector<double>{0, 0, 1, 0, 2, 0, 0, 0, 3, 0, 0, 0}, 3, 4);
     B = CCS(std::vector<double>{3, 0, 0, 0, 4, 0}, 2, 3);
 
-    std::vector<double> result = A * B;
+    SparseMatrix result = A * B;
     std::vector<double> exp_result{ 4, 0, 0, 0, 12, 0, 0, 0 };
 
-    ASSERT_EQ(result, exp_result);
+    ASSERT_EQ(result.non_zero, 2);
+    ASSERT_EQ(Dense(result), exp_result);
+  }
+}
+
+TEST(CCS_Matrix_mult, Matrix_vector_multiplication) {
+  int ProcRank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &ProcRank);
+
+  if (ProcRank == 0) {
+    SparseMatrix A = CCS(std::vector<double>{0, 0, 1, 0, 2, 0, 0, 0, 3, 0, 0, 0}, 3, 4);
+    std::vector<double> x{ 1, 2, 3 };
+
+    std::vector<double> exp_result{ 3, 4, 9, 0 };
+    ASSERT_EQ(A * x, exp_result);
   }
 }
 
@@ -32,12 +48,12 @@ TEST(CCS_Matrix_mult, Parallel_multiplication) {
     B = CCS(std::vector<double>{3, 0, 0, 0, 4, 0}, 2, 3);
   }
 
-  std::vector<double> result = Multiply(A, B);
+  SparseMatrix result = Multiply(A, B);
 
   if (ProcRank == 0) {
     std::vector<double> exp_result{ 4, 0, 0, 0, 12, 0, 0, 0 };
 
-    ASSERT_EQ(result, exp_result);
+    ASSERT_EQ(Dense(result), exp_result);
   }
 }
 
@@ -51,10 +67,10 @@ TEST(CCS_Matrix_mult, Random_20x20) {
     B = CCS(RandMatrix(20, 20), 20, 20);
   }
 
-  std::vector<double> result = Multiply(A, B);
+  SparseMatrix result = Multiply(A, B);
 
   if (ProcRank == 0) {
-    std::vector<double> exp_result = A * B;
+    SparseMatrix exp_result = A * B;
 
     ASSERT_EQ(result, exp_result);
   }
@@ -70,10 +86,10 @@ TEST(CCS_Matrix_mult, Random_50x50) {
     B = CCS(RandMatrix(50, 50), 50, 50);
   }
 
-  std::vector<double> result = Multiply(A, B);
+  SparseMatrix result = Multiply(A, B);
 
   if (ProcRank == 0) {
-    std::vector<double> exp_result = A * B;
+    SparseMatrix exp_result = A * B;
 
     ASSERT_EQ(result, exp_result);
   }
@@ -88,14 +104,90 @@ TEST(CCS_Matrix_mult, Random_75x75) {
     A = CCS(RandMatrix(75, 75), 75, 75);
     B = CCS(RandMatrix(75, 75), 75, 75);
   }
-  std::vector<double> result = Multiply(A, B);
+  SparseMatrix result = Multiply(A, B);
 
   if (ProcRank == 0) {
-    std::vector<double> exp_result = A * B;
+    SparseMatrix exp_result = A * B;
     ASSERT_EQ(result, exp_result);
   }
 }
 
+TEST(CCS_Matrix_mult, Distributed_rectangular) {
+  int ProcRank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &ProcRank);
+
+  SparseMatrix A, B;
+  if (ProcRank == 0) {
+    A = CCS(RandMatrix(30, 17), 30, 17);
+    B = CCS(RandMatrix(11, 30), 11, 30);
+  }
+
+  SparseMatrix localA = ScatterColumns(A);
+  SparseMatrix localB = ScatterColumns(B);
+  SparseMatrix localC = DistributedMultiply(localA, localB);
+  ASSERT_EQ(localC.columns, localB.columns);
+
+  SparseMatrix C = GatherColumns(localC);
+
+  if (ProcRank == 0) {
+    ASSERT_EQ(C, A * B);
+  }
+}
+
+TEST(CCS_Matrix_mult, Matrix_Market_read_write) {
+  int ProcRank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &ProcRank);
+
+  const std::string path = "pronina_t_matrix_multiplication_test.mtx";
+  SparseMatrix A;
+  if (ProcRank == 0) {
+    A = CCS(RandMatrix(23, 31), 23, 31);
+    WriteMatrixMarket(A, path);
+  }
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  SparseMatrix B = GatherColumns(ReadMatrixMarketDistributed(path));
+
+  if (ProcRank == 0) {
+    ASSERT_EQ(ReadMatrixMarket(path), A);
+    ASSERT_EQ(B, A);
+    std::remove(path.c_str());
+  }
+}
+
+TEST(CCS_Matrix_mult, Matrix_Market_bad_entries) {
+  int ProcRank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &ProcRank);
+
+  const std::string path = "pronina_t_matrix_multiplication_bad.mtx";
+  // zero-based index, column past the size, missing entry
+  const std::string entries[] = {"2 0 1.5\n", "2 5 1.5\n", ""};
+  for (const std::string& bad : entries) {
+    if (ProcRank == 0) {
+      FILE* file = fopen(path.c_str(), "w");
+      fputs("%%MatrixMarket matrix coordinate real general\n4 4 2\n", file);
+      fputs("1 1 2.0\n", file);
+      fputs(bad.c_str(), file);
+      // the bad line stays in the byte range of the first process
+      for (int i = 0; i < 100; i++) {
+        fputs("%\n", file);
+      }
+      fclose(file);
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    if (ProcRank == 0) {
+      ASSERT_ANY_THROW(ReadMatrixMarket(path));
+    }
+    ASSERT_ANY_THROW(ReadMatrixMarketDistributed(path));
+    MPI_Barrier(MPI_COMM_WORLD);
+  }
+
+  if (ProcRank == 0) {
+    std::remove(path.c_str());
+  }
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   MPI_Init(&argc, &argv);
@@ -0,0 +1,374 @@
+// Copyright 2022 Pronina Tatiana
+#include <mpi.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../../../modules/task_3/pronina_t_matrix_multiplication/pronina_t_matrix_multiplication.h"
+
+namespace {
+
+// The file is closed by the pointer, also when a reader throws
+typedef std::unique_ptr<FILE, int (*)(FILE*)> FilePtr;
+
+FilePtr OpenFile(const std::string& _path, const char* _mode) {
+  FilePtr file(fopen(_path.c_str(), _mode), fclose);
+  if (!file) {
+    throw "cannot open file";
+  }
+  return file;
+}
+
+// Offsets past 2 GB need 64 bits, also where long has 32
+int64_t Tell(FILE* _file) {
+#ifdef _WIN32
+  return _ftelli64(_file);
+#else
+  return static_cast<int64_t>(ftello(_file));
+#endif
+}
+
+void Seek(FILE* _file, int64_t _offset, int _origin) {
+#ifdef _WIN32
+  _fseeki64(_file, _offset, _origin);
+#else
+  fseeko(_file, static_cast<off_t>(_offset), _origin);
+#endif
+}
+
+struct MatrixMarketHeader {
+  int rows = 0, columns = 0, non_zero = 0;
+  bool pattern = false;
+  // 0 for general, 1 for symmetric, -1 for skew-symmetric matrices
+  int mirror = 0;
+  // Byte range of the lines with entries
+  int64_t dataBegin = 0, dataEnd = 0;
+};
+
+MatrixMarketHeader ReadHeader(FILE* _file) {
+  MatrixMarketHeader header;
+  char line[1024];
+
+  if (!fgets(line, sizeof(line), _file) ||
+    strncmp(line, "%%MatrixMarket", 14) != 0) {
+    throw "not a Matrix Market file";
+  }
+  if (!strstr(line, "coordinate") || strstr(line, "complex")) {
+    throw "only real coordinate matrices are supported";
+  }
+  header.pattern = strstr(line, "pattern") != nullptr;
+  if (strstr(line, "skew-symmetric")) {
+    header.mirror = -1;
+  } else if (strstr(line, "symmetric")) {
+    header.mirror = 1;
+  }
+
+  do {
+    if (!fgets(line, sizeof(line), _file)) {
+      throw "no size line in Matrix Market file";
+    }
+  } while (line[0] == '%');
+
+  if (sscanf(line, "%d %d %d", &header.rows, &header.columns,
+    &header.non_zero) != 3 || header.rows < 0 || header.columns < 0 ||
+    header.non_zero < 0) {
+    throw "bad size line in Matrix Market file";
+  }
+  if (header.mirror != 0 && header.rows != header.columns) {
+    throw "symmetric Matrix Market matrix is not square";
+  }
+
+  header.dataBegin = Tell(_file);
+  Seek(_file, 0, SEEK_END);
+  header.dataEnd = Tell(_file);
+  return header;
+}
+
+// Parsing one line with an entry, empty lines and comments are skipped.
+// Returns true for a line with an entry.
+template <class Callback>
+bool ParseLine(const char* _line, const MatrixMarketHeader& _header,
+  Callback _callback) {
+  while (*_line == ' ' || *_line == '\t' || *_line == '\r') {
+    _line++;
+  }
+  if (*_line == '\0' || *_line == '%') {
+    return false;
+  }
+
+  char* rowEnd;
+  char* colEnd;
+  int row = static_cast<int>(strtol(_line, &rowEnd, 10)) - 1;
+  int col = static_cast<int>(strtol(rowEnd, &colEnd, 10)) - 1;
+  if (rowEnd == _line || colEnd == rowEnd) {
+    throw "bad entry in Matrix Market file";
+  }
+  // the callbacks index the column arrays with these directly
+  if (row < 0 || row >= _header.rows || col < 0 || col >= _header.columns) {
+    throw "entry index out of range in Matrix Market file";
+  }
+  double value = _header.pattern ? 1 : strtod(colEnd, nullptr);
+
+  _callback(row, col, value);
+  if (_header.mirror != 0 && row != col) {
+    _callback(col, row, _header.mirror * value);
+  }
+  return true;
+}
+
+// Calls _callback(row, col, value) with zero-based indexes for every entry
+// whose line starts in [_begin, _end) of the file. The line crossing
+// _begin belongs to the previous range. Returns the number of entry lines.
+template <class Callback>
+int ScanEntries(FILE* _file, const MatrixMarketHeader& _header,
+  int64_t _begin, int64_t _end, Callback _callback) {
+  int entries = 0;
+  int64_t pos = _begin;
+  if (_begin > _header.dataBegin) {
+    Seek(_file, _begin - 1, SEEK_SET);
+    pos = _begin - 1;
+    int ch;
+    do {
+      ch = fgetc(_file);
+      pos++;
+    } while (ch != EOF && ch != '\n');
+  } else {
+    Seek(_file, _begin, SEEK_SET);
+  }
+
+  std::vector<char> buf(1 << 20);
+  size_t len = 0;
+  bool eof = false;
+
+  while (pos < _end) {
+    if (!eof) {
+      size_t got = fread(buf.data() + len, 1, buf.size() - 1 - len, _file);
+      eof = (got == 0);
+      len += got;
+    }
+    buf[len] = '\0';
+
+    size_t p = 0;
+    while (pos + static_cast<int64_t>(p) < _end && p < len) {
+      char* newLine = static_cast<char*>(memchr(buf.data() + p, '\n',
+        len - p));
+      if (!newLine && !eof) {
+        break;
+      }
+      if (newLine) {
+        *newLine = '\0';
+      }
+
+      if (ParseLine(buf.data() + p, _header, _callback)) {
+        entries++;
+      }
+
+      p = newLine ? static_cast<size_t>(newLine - buf.data()) + 1 : len;
+    }
+
+    if (eof && p >= len) {
+      break;
+    }
+    memmove(buf.data(), buf.data() + p, len - p);
+    pos += static_cast<int64_t>(p);
+    len -= p;
+    if (len + 1 == buf.size()) {
+      buf.resize(2 * buf.size());
+    }
+  }
+  return entries;
+}
+
+// Turning the counts of non-zeros stored in col_ptr[col + 1] into offsets
+// and allocating the storage. Returns the first free position of every
+// column for the filling pass.
+std::vector<int> Allocate(SparseMatrix* _M) {
+  for (int col = 0; col < _M->columns; col++) {
+    _M->col_ptr[col + 1] += _M->col_ptr[col];
+  }
+  _M->non_zero = _M->col_ptr[_M->columns];
+  _M->val.resize(_M->non_zero);
+  _M->row_index.resize(_M->non_zero);
+  return std::vector<int>(_M->col_ptr.begin(), _M->col_ptr.end() - 1);
+}
+
+// Sorting the entries of every column by rows
+void SortColumns(SparseMatrix* _M) {
+  std::vector<std::pair<int, double> > column;
+  for (int col = 0; col < _M->columns; col++) {
+    int begin = _M->col_ptr[col], end = _M->col_ptr[col + 1];
+    if (std::is_sorted(_M->row_index.begin() + begin,
+      _M->row_index.begin() + end)) {
+      continue;
+    }
+
+    column.clear();
+    for (int i = begin; i < end; i++) {
+      column.push_back(std::make_pair(_M->row_index[i], _M->val[i]));
+    }
+    std::sort(column.begin(), column.end());
+    for (int i = begin; i < end; i++) {
+      _M->row_index[i] = column[i - begin].first;
+      _M->val[i] = column[i - begin].second;
+    }
+  }
+}
+
+}  // namespace
+
+SparseMatrix ReadMatrixMarket(const std::string& _path) {
+  FilePtr file = OpenFile(_path, "rb");
+  MatrixMarketHeader header = ReadHeader(file.get());
+
+  SparseMatrix res;
+  res.rows = header.rows;
+  res.columns = header.columns;
+  res.col_ptr.assign(res.columns + 1, 0);
+
+  // the first pass counts, the second one fills
+  int entries = ScanEntries(file.get(), header, header.dataBegin,
+    header.dataEnd, [&res](int, int col, double) {
+      res.col_ptr[col + 1]++;
+    });
+  if (entries != header.non_zero) {
+    throw "entry count does not match the Matrix Market size line";
+  }
+  std::vector<int> pos = Allocate(&res);
+  ScanEntries(file.get(), header, header.dataBegin, header.dataEnd,
+    [&res, &pos](int row, int col, double value) {
+      res.row_index[pos[col]] = row;
+      res.val[pos[col]] = value;
+      pos[col]++;
+    });
+
+  SortColumns(&res);
+  return res;
+}
+
+SparseMatrix ReadMatrixMarketDistributed(const std::string& _path) {
+  int ProcRank, ProcNum;
+  MPI_Comm_rank(MPI_COMM_WORLD, &ProcRank);
+  MPI_Comm_size(MPI_COMM_WORLD, &ProcNum);
+
+  MatrixMarketHeader header;
+  std::vector<int> sendCounts(ProcNum, 0), sendDispls(ProcNum, 0);
+  std::vector<int> sendRowCol;
+  std::vector<double> sendVal;
+  int entries = 0;
+  const char* error = nullptr;
+  try {
+    FilePtr file = OpenFile(_path, "rb");
+    header = ReadHeader(file.get());
+
+    // every process parses its own byte range of the file
+    int64_t bytes = header.dataEnd - header.dataBegin;
+    int64_t begin = header.dataBegin + bytes * ProcRank / ProcNum;
+    int64_t end = header.dataBegin + bytes * (ProcRank + 1) / ProcNum;
+
+    // owners of the columns
+    std::vector<int> owner(header.columns);
+    for (int proc = 0; proc < ProcNum; proc++) {
+      for (int col = BlockBegin(header.columns, ProcNum, proc);
+        col < BlockBegin(header.columns, ProcNum, proc + 1); col++) {
+        owner[col] = proc;
+      }
+    }
+
+    entries = ScanEntries(file.get(), header, begin, end,
+      [&sendCounts, &owner](int, int col, double) {
+        sendCounts[owner[col]]++;
+      });
+    for (int proc = 1; proc < ProcNum; proc++) {
+      sendDispls[proc] = sendDispls[proc - 1] + sendCounts[proc - 1];
+    }
+
+    int sendTotal = sendDispls[ProcNum - 1] + sendCounts[ProcNum - 1];
+    sendRowCol.resize(2 * sendTotal);
+    sendVal.resize(sendTotal);
+    std::vector<int> fill(sendDispls);
+    ScanEntries(file.get(), header, begin, end,
+      [&sendRowCol, &sendVal, &fill, &owner](int row, int col, double value) {
+        int i = fill[owner[col]]++;
+        sendRowCol[2 * i] = row;
+        sendRowCol[2 * i + 1] = col;
+        sendVal[i] = value;
+      });
+  } catch (const char* message) {
+    error = message;
+  }
+
+  // the processes agree on failure before the first exchange, otherwise
+  // the ones that parsed their range would wait in it forever
+  int failed = error != nullptr;
+  MPI_Allreduce(MPI_IN_PLACE, &failed, 1, MPI_INT, MPI_LOR, MPI_COMM_WORLD);
+  if (failed) {
+    throw error ? error : "bad Matrix Market file on another process";
+  }
+  MPI_Allreduce(MPI_IN_PLACE, &entries, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+  if (entries != header.non_zero) {
+    throw "entry count does not match the Matrix Market size line";
+  }
+
+  std::vector<int> recvCounts(ProcNum), recvDispls(ProcNum, 0);
+  MPI_Alltoall(sendCounts.data(), 1, MPI_INT, recvCounts.data(), 1, MPI_INT,
+    MPI_COMM_WORLD);
+  for (int proc = 1; proc < ProcNum; proc++) {
+    recvDispls[proc] = recvDispls[proc - 1] + recvCounts[proc - 1];
+  }
+  int recvTotal = recvDispls[ProcNum - 1] + recvCounts[ProcNum - 1];
+
+  std::vector<double> recvVal(recvTotal);
+  MPI_Alltoallv(sendVal.data(), sendCounts.data(), sendDispls.data(),
+    MPI_DOUBLE, recvVal.data(), recvCounts.data(), recvDispls.data(),
+    MPI_DOUBLE, MPI_COMM_WORLD);
+
+  for (int proc = 0; proc < ProcNum; proc++) {
+    sendCounts[proc] *= 2;
+    sendDispls[proc] *= 2;
+    recvCounts[proc] *= 2;
+    recvDispls[proc] *= 2;
+  }
+  std::vector<int> recvRowCol(2 * recvTotal);
+  MPI_Alltoallv(sendRowCol.data(), sendCounts.data(), sendDispls.data(),
+    MPI_INT, recvRowCol.data(), recvCounts.data(), recvDispls.data(),
+    MPI_INT, MPI_COMM_WORLD);
+
+  // building the local block of columns
+  const int firstCol = BlockBegin(header.columns, ProcNum, ProcRank);
+  SparseMatrix local;
+  local.rows = header.rows;
+  local.columns = BlockBegin(header.columns, ProcNum, ProcRank + 1)
+    - firstCol;
+  local.col_ptr.assign(local.columns + 1, 0);
+  for (int i = 0; i < recvTotal; i++) {
+    local.col_ptr[recvRowCol[2 * i + 1] - firstCol + 1]++;
+  }
+  std::vector<int> pos = Allocate(&local);
+  for (int i = 0; i < recvTotal; i++) {
+    int col = recvRowCol[2 * i + 1] - firstCol;
+    local.row_index[pos[col]] = recvRowCol[2 * i];
+    local.val[pos[col]] = recvVal[i];
+    pos[col]++;
+  }
+
+  SortColumns(&local);
+  return local;
+}
+
+void WriteMatrixMarket(const SparseMatrix& _M, const std::string& _path) {
+  FilePtr out = OpenFile(_path, "w");
+  FILE* file = out.get();
+
+  fprintf(file, "%%%%MatrixMarket matrix coordinate real general\n");
+  fprintf(file, "%d %d %d\n", _M.rows, _M.columns, _M.non_zero);
+  for (int col = 0; col < _M.columns; col++) {
+    for (int i = _M.col_ptr[col]; i < _M.col_ptr[col + 1]; i++) {
+      fprintf(file, "%d %d %.17g\n", _M.row_index[i] + 1, col + 1, _M.val[i]);
+    }
+  }
+}
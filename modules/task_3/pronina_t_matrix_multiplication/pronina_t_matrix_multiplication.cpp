@@ -1,6 +1,7 @@
 // Copyright 2022 Pronina Tatiana
 #include "../../../modules/task_3/pronina_t_matrix_multiplication/pronina_t_matrix_multiplication.h"
 #include <mpi.h>
+#include <algorithm>
 #include <ctime>
 #include <random>
 #include <vector>
@@ -11,167 +12,381 @@ SparseMatrix CCS(const std::vector<double>& _newMatrix, const int _newColumns,
   SparseMatrix res;
   res.columns = _newColumns;
   res.rows = _newRows;
-  res.non_zero = 0;
 
-  res.col_ptr.push_back(0);
+  // counting the non-zeros of every column
+  res.col_ptr.assign(_newColumns + 1, 0);
+  for (int i = 0; i < _newRows * _newColumns; i++) {
+    if (_newMatrix[i] != 0) {
+      res.col_ptr[i % _newColumns + 1]++;
+    }
+  }
   for (int col = 0; col < _newColumns; col++) {
+    res.col_ptr[col + 1] += res.col_ptr[col];
+  }
+  res.non_zero = res.col_ptr[_newColumns];
+
+  // filling, rows are visited in ascending order
+  res.val.resize(res.non_zero);
+  res.row_index.resize(res.non_zero);
+  std::vector<int> pos(res.col_ptr.begin(), res.col_ptr.end() - 1);
+  for (int i = 0; i < _newRows * _newColumns; i++) {
+    if (_newMatrix[i] != 0) {
+      int col = i % _newColumns;
+      res.val[pos[col]] = _newMatrix[i];
+      res.row_index[pos[col]] = i / _newColumns;
+      pos[col]++;
+    }
+  }
+
+  return res;
+}
+
+bool operator==(const SparseMatrix& _A, const SparseMatrix& _B) {
+  return _A.columns == _B.columns && _A.rows == _B.rows &&
+    _A.non_zero == _B.non_zero && _A.col_ptr == _B.col_ptr &&
+    _A.row_index == _B.row_index && _A.val == _B.val;
+}
+
+// Dense row-major copy of a sparse matrix
+std::vector<double> Dense(const SparseMatrix& _M) {
+  std::vector<double> res(_M.rows * _M.columns, 0);
+  for (int col = 0; col < _M.columns; col++) {
+    for (int i = _M.col_ptr[col]; i < _M.col_ptr[col + 1]; i++) {
+      res[_M.row_index[i] * _M.columns + col] = _M.val[i];
+    }
+  }
+  return res;
+}
+
+// Gustavson multiplication: column b_col of the result is a sum of the
+// columns of _A selected and scaled by the non-zeros of column b_col of _B.
+// _B.row_index[j] is looked up in _A through a_map, so only the needed
+// columns of _A have to be present.
+// The symbolic phase counts the non-zeros of every column of the result,
+// so the numeric phase fills preallocated storage.
+static SparseMatrix LocalMultiply(const SparseMatrix& _A,
+  const SparseMatrix& _B, const std::vector<int>& a_map) {
+  SparseMatrix res;
+  res.rows = _A.rows;
+  res.columns = _B.columns;
+  res.col_ptr.assign(_B.columns + 1, 0);
+
+  std::vector<int> mark(_A.rows, -1);
+
+  // symbolic phase
+  for (int b_col = 0; b_col < _B.columns; b_col++) {
     int nnzCount = 0;
-    for (int i = col; i <= (_newRows - 1) * _newColumns + col;
-      i += _newColumns) {
-      if (_newMatrix[i] == 0) {
-        continue;
+    for (int j = _B.col_ptr[b_col]; j < _B.col_ptr[b_col + 1]; j++) {
+      int a_col = a_map[j];
+      for (int i = _A.col_ptr[a_col]; i < _A.col_ptr[a_col + 1]; i++) {
+        if (mark[_A.row_index[i]] != b_col) {
+          mark[_A.row_index[i]] = b_col;
+          nnzCount++;
+        }
+      }
+    }
+    res.col_ptr[b_col + 1] = res.col_ptr[b_col] + nnzCount;
+  }
+  res.non_zero = res.col_ptr[_B.columns];
+  res.val.resize(res.non_zero);
+  res.row_index.resize(res.non_zero);
+
+  // numeric phase, the rows of the column are collected in place
+  std::vector<double> acc(_A.rows, 0);
+  std::fill(mark.begin(), mark.end(), -1);
+
+  for (int b_col = 0; b_col < _B.columns; b_col++) {
+    int* rowsBegin = res.row_index.data() + res.col_ptr[b_col];
+    int* rowsEnd = rowsBegin;
+    for (int j = _B.col_ptr[b_col]; j < _B.col_ptr[b_col + 1]; j++) {
+      int a_col = a_map[j];
+      for (int i = _A.col_ptr[a_col]; i < _A.col_ptr[a_col + 1]; i++) {
+        int row = _A.row_index[i];
+        if (mark[row] != b_col) {
+          mark[row] = b_col;
+          acc[row] = 0;
+          *rowsEnd++ = row;
+        }
+        acc[row] += _A.val[i] * _B.val[j];
       }
-      nnzCount++;
-      res.val.push_back(_newMatrix[i]);
-      res.row_index.push_back((i - col) / _newColumns);
     }
-    res.col_ptr.push_back(res.col_ptr.back() + nnzCount);
-    res.non_zero += nnzCount;
+
+    std::sort(rowsBegin, rowsEnd);
+    for (int i = res.col_ptr[b_col]; i < res.col_ptr[b_col + 1]; i++) {
+      res.val[i] = acc[res.row_index[i]];
+    }
   }
 
   return res;
 }
 
 // Multiplication operator
-const std::vector<double> operator*(const SparseMatrix& _A,
-  const SparseMatrix& _B) {
+SparseMatrix operator*(const SparseMatrix& _A, const SparseMatrix& _B) {
   if (_A.columns != _B.rows) {
     throw "incorrect size";
   }
 
-  std::vector<double> res(_A.rows * _B.columns, 0);
+  return LocalMultiply(_A, _B, _B.row_index);
+}
 
-  for (int a_col = 0; a_col < _A.columns; a_col++) {
-    for (int b_col = 0; b_col < _B.columns; b_col++) {
-      for (int i = _A.col_ptr[a_col]; i <= _A.col_ptr[a_col + 1] - 1; i++) {
-        if (_B.col_ptr[b_col + 1] - _B.col_ptr[b_col] == 0) {
-          continue;
-        }
+// Matrix-vector multiplication, every column of _A is scaled by its
+// element of _x and added to the result
+std::vector<double> operator*(const SparseMatrix& _A,
+  const std::vector<double>& _x) {
+  if (_A.columns != static_cast<int>(_x.size())) {
+    throw "incorrect size";
+  }
 
-        for (int j = _B.col_ptr[b_col];
-          j < _B.col_ptr[b_col + 1]; j++) {
-          if (_B.row_index[j] == a_col) {
-            // [interpreting a two-dimensional array into a one-dimensional one]
-            res[_A.row_index[i] * _B.columns + b_col]
-              += _A.val[i] * _B.val[j];
-          }
-        }
-      }
+  std::vector<double> res(_A.rows, 0);
+  for (int col = 0; col < _A.columns; col++) {
+    for (int i = _A.col_ptr[col]; i < _A.col_ptr[col + 1]; i++) {
+      res[_A.row_index[i]] += _A.val[i] * _x[col];
     }
   }
-
   return res;
 }
 
-// Parallel multiplication
-std::vector<double> Multiply(SparseMatrix _A, SparseMatrix _B) {
+// First column of the block owned by the process ProcRank
+int BlockBegin(const int _columns, const int ProcNum, const int ProcRank) {
+  return ProcRank * (_columns / ProcNum)
+    + std::min(ProcRank, _columns % ProcNum);
+}
+
+// Splitting the matrix into blocks of columns, one per process
+SparseMatrix ScatterColumns(const SparseMatrix& _M) {
   int ProcRank, ProcNum;
   MPI_Comm_rank(MPI_COMM_WORLD, &ProcRank);
   MPI_Comm_size(MPI_COMM_WORLD, &ProcNum);
 
-  if (ProcNum == 1) {
-    return _A * _B;
+  int sizes[2] = { _M.columns, _M.rows };
+  MPI_Bcast(sizes, 2, MPI_INT, 0, MPI_COMM_WORLD);
+
+  std::vector<int> colCounts(ProcNum), colDispls(ProcNum);
+  std::vector<int> nzCounts(ProcNum, 0), nzDispls(ProcNum, 0);
+  for (int proc = 0; proc < ProcNum; proc++) {
+    colDispls[proc] = BlockBegin(sizes[0], ProcNum, proc);
+    colCounts[proc] = BlockBegin(sizes[0], ProcNum, proc + 1)
+      - colDispls[proc];
+    if (ProcRank == 0 && colCounts[proc] > 0) {
+      nzDispls[proc] = _M.col_ptr[colDispls[proc]];
+      nzCounts[proc] = _M.col_ptr[colDispls[proc] + colCounts[proc]]
+        - nzDispls[proc];
+    }
   }
+  MPI_Bcast(nzCounts.data(), ProcNum, MPI_INT, 0, MPI_COMM_WORLD);
 
-  // Data is sent to all processes
-  MPI_Bcast(&_A.columns, 1, MPI_INT, 0, MPI_COMM_WORLD);
-  MPI_Bcast(&_A.rows, 1, MPI_INT, 0, MPI_COMM_WORLD);
-  MPI_Bcast(&_A.non_zero, 1, MPI_INT, 0, MPI_COMM_WORLD);
+  SparseMatrix local;
+  local.columns = colCounts[ProcRank];
+  local.rows = sizes[1];
+  local.non_zero = nzCounts[ProcRank];
+  local.val.resize(local.non_zero);
+  local.row_index.resize(local.non_zero);
+  local.col_ptr.resize(local.columns + 1);
 
-  MPI_Bcast(&_B.columns, 1, MPI_INT, 0, MPI_COMM_WORLD);
-  MPI_Bcast(&_B.rows, 1, MPI_INT, 0, MPI_COMM_WORLD);
-  MPI_Bcast(&_B.non_zero, 1, MPI_INT, 0, MPI_COMM_WORLD);
+  MPI_Scatterv(_M.val.data(), nzCounts.data(), nzDispls.data(), MPI_DOUBLE,
+    local.val.data(), local.non_zero, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+  MPI_Scatterv(_M.row_index.data(), nzCounts.data(), nzDispls.data(),
+    MPI_INT, local.row_index.data(), local.non_zero, MPI_INT, 0,
+    MPI_COMM_WORLD);
+  MPI_Scatterv(_M.col_ptr.data(), colCounts.data(), colDispls.data(),
+    MPI_INT, local.col_ptr.data(), local.columns, MPI_INT, 0,
+    MPI_COMM_WORLD);
 
-  if (_A.non_zero == 0 || _B.non_zero == 0) {
-    // The main process does the multiplication sequentially
-    if (ProcRank == 0) {
-      return _A * _B;
-    } else {
-      // the rest of the processes get an empty vector to get something,
-      // in order to avoid an error
-      return std::vector<double>();
+  // Offsets are received relative to the whole matrix
+  int base = local.columns > 0 ? local.col_ptr[0] : 0;
+  for (int col = 0; col < local.columns; col++) {
+    local.col_ptr[col] -= base;
+  }
+  local.col_ptr[local.columns] = local.non_zero;
+
+  return local;
+}
+
+// Collecting the blocks of columns on the main process
+SparseMatrix GatherColumns(const SparseMatrix& _local) {
+  int ProcRank, ProcNum;
+  MPI_Comm_rank(MPI_COMM_WORLD, &ProcRank);
+  MPI_Comm_size(MPI_COMM_WORLD, &ProcNum);
+
+  int sizes[2] = { _local.columns, _local.non_zero };
+  std::vector<int> allSizes(2 * ProcNum);
+  MPI_Gather(sizes, 2, MPI_INT, allSizes.data(), 2, MPI_INT, 0,
+    MPI_COMM_WORLD);
+
+  std::vector<int> colCounts(ProcNum), colDispls(ProcNum, 0);
+  std::vector<int> nzCounts(ProcNum), nzDispls(ProcNum, 0);
+  for (int proc = 0; proc < ProcNum; proc++) {
+    colCounts[proc] = allSizes[2 * proc];
+    nzCounts[proc] = allSizes[2 * proc + 1];
+    if (proc > 0) {
+      colDispls[proc] = colDispls[proc - 1] + colCounts[proc - 1];
+      nzDispls[proc] = nzDispls[proc - 1] + nzCounts[proc - 1];
     }
   }
 
-  if (_A.columns != _B.rows) {
-    throw "incorrect size";
+  SparseMatrix res;
+  res.rows = _local.rows;
+  if (ProcRank == 0) {
+    res.columns = colDispls[ProcNum - 1] + colCounts[ProcNum - 1];
+    res.non_zero = nzDispls[ProcNum - 1] + nzCounts[ProcNum - 1];
+    res.val.resize(res.non_zero);
+    res.row_index.resize(res.non_zero);
+    res.col_ptr.resize(res.columns + 1);
   }
-  // if the number of columns is less than the number of processes
-  if (_A.columns < ProcNum) {
-    if (ProcRank == 0) {
-      return _A * _B;  // The main process does the multiplication sequentially
-    } else {
-      // the rest of the processes get an empty vector to get something,
-      // in order to avoid an error
-      return std::vector<double>();
+
+  MPI_Gatherv(_local.val.data(), _local.non_zero, MPI_DOUBLE,
+    res.val.data(), nzCounts.data(), nzDispls.data(), MPI_DOUBLE, 0,
+    MPI_COMM_WORLD);
+  MPI_Gatherv(_local.row_index.data(), _local.non_zero, MPI_INT,
+    res.row_index.data(), nzCounts.data(), nzDispls.data(), MPI_INT, 0,
+    MPI_COMM_WORLD);
+  MPI_Gatherv(_local.col_ptr.data(), _local.columns, MPI_INT,
+    res.col_ptr.data(), colCounts.data(), colDispls.data(), MPI_INT, 0,
+    MPI_COMM_WORLD);
+
+  if (ProcRank == 0) {
+    for (int proc = 0; proc < ProcNum; proc++) {
+      for (int col = 0; col < colCounts[proc]; col++) {
+        res.col_ptr[colDispls[proc] + col] += nzDispls[proc];
+      }
     }
+    res.col_ptr[res.columns] = res.non_zero;
   }
 
-  if (ProcRank != 0) {
-    _A.val.resize(_A.non_zero);  // Changing the size
-    _A.row_index.resize(_A.non_zero);
-    _A.col_ptr.resize(_A.columns + 1);
-    _B.val.resize(_B.non_zero);
-    _B.row_index.resize(_B.non_zero);
-    _B.col_ptr.resize(_B.columns + 1);
+  return res;
+}
+
+// Distributed multiplication. _A and _B are the blocks of columns owned by
+// this process, the result is the same block of columns of A * B.
+// Only the columns of A referenced by the local block of B are fetched
+// from their owners with MPI_Alltoallv.
+SparseMatrix DistributedMultiply(const SparseMatrix& _A,
+  const SparseMatrix& _B) {
+  int ProcRank, ProcNum;
+  MPI_Comm_rank(MPI_COMM_WORLD, &ProcRank);
+  MPI_Comm_size(MPI_COMM_WORLD, &ProcNum);
+
+  // the number of columns of the whole A
+  const int aColumns = _B.rows;
+
+  // Needed columns of A in ascending order, the requests to every owner
+  // form one contiguous part of this list
+  std::vector<int> needed(_B.row_index);
+  std::sort(needed.begin(), needed.end());
+  needed.erase(std::unique(needed.begin(), needed.end()), needed.end());
+
+  std::vector<int> reqCounts(ProcNum, 0), reqDispls(ProcNum, 0);
+  for (int proc = 0, i = 0; proc < ProcNum; proc++) {
+    int end = BlockBegin(aColumns, ProcNum, proc + 1);
+    reqDispls[proc] = i;
+    while (i < static_cast<int>(needed.size()) && needed[i] < end) {
+      i++;
+    }
+    reqCounts[proc] = i - reqDispls[proc];
   }
-  // send data about matrix A to all processes
-  MPI_Bcast(&_A.val[0], _A.non_zero, MPI_DOUBLE, 0, MPI_COMM_WORLD);
-  MPI_Bcast(&_A.row_index[0], _A.non_zero, MPI_INT, 0, MPI_COMM_WORLD);
-  MPI_Bcast(&_A.col_ptr[0], _A.columns + 1, MPI_INT, 0, MPI_COMM_WORLD);
 
-  // send data about matrix B to all processes
-  MPI_Bcast(&_B.val[0], _B.non_zero, MPI_DOUBLE, 0, MPI_COMM_WORLD);
-  MPI_Bcast(&_B.row_index[0], _B.non_zero, MPI_INT, 0, MPI_COMM_WORLD);
-  MPI_Bcast(&_B.col_ptr[0], _B.columns + 1, MPI_INT, 0, MPI_COMM_WORLD);
+  std::vector<int> srvCounts(ProcNum), srvDispls(ProcNum, 0);
+  MPI_Alltoall(reqCounts.data(), 1, MPI_INT, srvCounts.data(), 1, MPI_INT,
+    MPI_COMM_WORLD);
+  for (int proc = 1; proc < ProcNum; proc++) {
+    srvDispls[proc] = srvDispls[proc - 1] + srvCounts[proc - 1];
+  }
 
-  // distribute to each process its own piece of the matrix A
-  int delta = _A.columns / ProcNum;
-  // Denoting the boundaries
-  int leftBound = ProcRank * delta;
-  int rightBound = (ProcRank + 1) * delta;
+  // Columns of the local block of A requested by the other processes
+  std::vector<int> served(srvDispls[ProcNum - 1] + srvCounts[ProcNum - 1]);
+  MPI_Alltoallv(needed.data(), reqCounts.data(), reqDispls.data(), MPI_INT,
+    served.data(), srvCounts.data(), srvDispls.data(), MPI_INT,
+    MPI_COMM_WORLD);
 
-  if (ProcRank == ProcNum - 1) {
-    rightBound = _A.columns;
+  const int firstCol = BlockBegin(aColumns, ProcNum, ProcRank);
+  std::vector<int> srvLen(served.size());
+  std::vector<int> srvNzCounts(ProcNum, 0), srvNzDispls(ProcNum, 0);
+  for (int proc = 0; proc < ProcNum; proc++) {
+    for (int t = srvDispls[proc]; t < srvDispls[proc] + srvCounts[proc];
+      t++) {
+      int col = served[t] - firstCol;
+      srvLen[t] = _A.col_ptr[col + 1] - _A.col_ptr[col];
+      srvNzCounts[proc] += srvLen[t];
+    }
+    if (proc > 0) {
+      srvNzDispls[proc] = srvNzDispls[proc - 1] + srvNzCounts[proc - 1];
+    }
   }
 
-  // Declaring a vector to store the local result
-  // (each process has its own result)
-  std::vector<double> localResult(_A.rows * _B.columns);
+  std::vector<double> srvVal(srvNzDispls[ProcNum - 1]
+    + srvNzCounts[ProcNum - 1]);
+  std::vector<int> srvRowIndex(srvVal.size());
+  for (size_t t = 0, pos = 0; t < served.size(); t++) {
+    int col = served[t] - firstCol;
+    std::copy(_A.val.begin() + _A.col_ptr[col],
+      _A.val.begin() + _A.col_ptr[col + 1], srvVal.begin() + pos);
+    std::copy(_A.row_index.begin() + _A.col_ptr[col],
+      _A.row_index.begin() + _A.col_ptr[col + 1],
+      srvRowIndex.begin() + pos);
+    pos += srvLen[t];
+  }
 
-  for (int a_col = leftBound; a_col < rightBound; a_col++) {
-    for (int b_col = 0; b_col < _B.columns; b_col++) {
-      for (int i = _A.col_ptr[a_col]; i <= _A.col_ptr[a_col + 1] - 1; i++) {
-        if (_B.col_ptr[b_col + 1] - _B.col_ptr[b_col] == 0) {
-          continue;
-        }
+  // The needed columns of A, stored in the order of the needed list
+  SparseMatrix neededA;
+  neededA.rows = _A.rows;
+  neededA.columns = static_cast<int>(needed.size());
+  neededA.col_ptr.resize(neededA.columns + 1, 0);
+  MPI_Alltoallv(srvLen.data(), srvCounts.data(), srvDispls.data(), MPI_INT,
+    neededA.col_ptr.data() + 1, reqCounts.data(), reqDispls.data(), MPI_INT,
+    MPI_COMM_WORLD);
 
-        for (int j = _B.col_ptr[b_col];
-          j <= _B.col_ptr[b_col + 1] - 1; j++) {
-          if (_B.row_index[j] == a_col) {
-            localResult[_A.row_index[i] * _B.columns + b_col]
-              += _A.val[i] * _B.val[j];
-          }
-        }
-      }
+  std::vector<int> reqNzCounts(ProcNum, 0), reqNzDispls(ProcNum, 0);
+  for (int proc = 0; proc < ProcNum; proc++) {
+    for (int t = reqDispls[proc]; t < reqDispls[proc] + reqCounts[proc];
+      t++) {
+      reqNzCounts[proc] += neededA.col_ptr[t + 1];
+      neededA.col_ptr[t + 1] += neededA.col_ptr[t];
+    }
+    if (proc > 0) {
+      reqNzDispls[proc] = reqNzDispls[proc - 1] + reqNzCounts[proc - 1];
     }
   }
+  neededA.non_zero = neededA.col_ptr[neededA.columns];
+  neededA.val.resize(neededA.non_zero);
+  neededA.row_index.resize(neededA.non_zero);
 
-  // Declaring a vector to collect local results
-  std::vector<double> globalResult;
-  if (ProcRank == 0) {
-    globalResult.resize(_A.rows * _B.columns);
+  MPI_Alltoallv(srvVal.data(), srvNzCounts.data(), srvNzDispls.data(),
+    MPI_DOUBLE, neededA.val.data(), reqNzCounts.data(), reqNzDispls.data(),
+    MPI_DOUBLE, MPI_COMM_WORLD);
+  MPI_Alltoallv(srvRowIndex.data(), srvNzCounts.data(), srvNzDispls.data(),
+    MPI_INT, neededA.row_index.data(), reqNzCounts.data(),
+    reqNzDispls.data(), MPI_INT, MPI_COMM_WORLD);
+
+  // Positions of the rows of B in the needed list
+  std::vector<int> aMap(_B.non_zero);
+  for (int j = 0; j < _B.non_zero; j++) {
+    aMap[j] = static_cast<int>(std::lower_bound(needed.begin(), needed.end(),
+      _B.row_index[j]) - needed.begin());
   }
 
-  if (ProcRank == 0) {
-    MPI_Reduce(&localResult[0], &globalResult[0], _A.rows * _B.columns,
-      MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
-  } else {
-    MPI_Reduce(&localResult[0], MPI_IN_PLACE, _A.rows * _B.columns,
-      MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+  return LocalMultiply(neededA, _B, aMap);
+}
+
+// Parallel multiplication
+SparseMatrix Multiply(const SparseMatrix& _A, const SparseMatrix& _B) {
+  int ProcNum;
+  MPI_Comm_size(MPI_COMM_WORLD, &ProcNum);
+
+  if (ProcNum == 1) {
+    return _A * _B;
+  }
+
+  int sizes[2] = { _A.columns, _B.rows };
+  MPI_Bcast(sizes, 2, MPI_INT, 0, MPI_COMM_WORLD);
+  if (sizes[0] != sizes[1]) {
+    throw "incorrect size";
   }
 
-  return globalResult;
+  SparseMatrix localA = ScatterColumns(_A);
+  SparseMatrix localB = ScatterColumns(_B);
+  // the result is collected on the main process,
+  // the rest of the processes get an empty matrix
+  return GatherColumns(DistributedMultiply(localA, localB));
 }
 
 std::vector<double> RandMatrix(const int _columns, const int _rows) {
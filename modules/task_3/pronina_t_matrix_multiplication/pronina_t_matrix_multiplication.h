@@ -3,6 +3,7 @@
 #ifndef MODULES_TASK_3_PRONINA_T_MATRIX_MULTIPLICATION_PRONINA_T_MATRIX_MULTIPLICATION_H_
 #define MODULES_TASK_3_PRONINA_T_MATRIX_MULTIPLICATION_PRONINA_T_MATRIX_MULTIPLICATION_H_
 
+#include <string>
 #include <vector>
 
 struct SparseMatrix {
@@ -14,14 +15,34 @@ struct SparseMatrix {
   std::vector<int> row_index;
   int columns = 0, rows = 0, non_zero = 0;
 
-  friend const std::vector<double> operator*(const SparseMatrix& _A,
+  friend SparseMatrix operator*(const SparseMatrix& _A,
     const SparseMatrix& _B);
+  friend std::vector<double> operator*(const SparseMatrix& _A,
+    const std::vector<double>& _x);
+  friend bool operator==(const SparseMatrix& _A, const SparseMatrix& _B);
 };
 
 SparseMatrix CCS(const std::vector<double>& _newMatrix,
   const int _newColumns, const int _newRows);
 
-std::vector<double> Multiply(SparseMatrix _A, SparseMatrix _B);
+std::vector<double> Dense(const SparseMatrix& _M);
+
+// Distribution of the matrix by blocks of columns: the process ProcRank
+// owns the columns [BlockBegin(.., ProcRank), BlockBegin(.., ProcRank + 1))
+int BlockBegin(const int _columns, const int ProcNum, const int ProcRank);
+SparseMatrix ScatterColumns(const SparseMatrix& _M);
+SparseMatrix GatherColumns(const SparseMatrix& _local);
+SparseMatrix DistributedMultiply(const SparseMatrix& _A,
+  const SparseMatrix& _B);
+
+SparseMatrix Multiply(const SparseMatrix& _A, const SparseMatrix& _B);
+// Matrix Market coordinate files. ReadMatrixMarketDistributed must be
+// called by all processes, each of them parses a part of the file and
+// gets its own block of columns. A bad file throws on every process.
+SparseMatrix ReadMatrixMarket(const std::string& _path);
+SparseMatrix ReadMatrixMarketDistributed(const std::string& _path);
+void WriteMatrixMarket(const SparseMatrix& _M, const std::string& _path);
+
 std::vector<double> RandMatrix(const int _columns, const int _rows);
 
 #endif  // MODULES_TASK_3_PRONINA_T_MATRIX_MULTIPLICATION_PRONINA_T_MATRIX_MULTIPLICATION_H_
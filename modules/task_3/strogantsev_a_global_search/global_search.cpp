@@ -2,172 +2,189 @@
 #include <mpi.h>
 #include <vector>
 #include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <unordered_map>
 #include "../../../modules/task_3/strogantsev_a_global_search/global_search.h"
 
-const int maxIterationCount = 50000;
-
-double getMiddle(double a, double b) {
-    return (a + b) / 2.0;
+TrialStore::TrialStore(double a, double valueA, double b, double valueB, int dimension, double reliability)
+    : power(1.0 / dimension), reliability(reliability) {
+    trials[a] = valueA;
+    trials[b] = valueB;
+    parameterM = std::abs(valueB - valueA) / getDistance(a, b);
+    rebuildQueue();
 }
 
-double getParameterM(const std::vector<double>& points, std::function<double(double)> fun) {
-    double M = std::numeric_limits<double>::min();
-    for (size_t i = 1; i < points.size(); i++) {
-        double z1 = fun(points[i]);
-        double z0 = fun(points[i - 1]);
-        double currentM = std::abs((z1 - z0) / (points[i] - points[i - 1]));
-        M = std::max(currentM, M);
+void TrialStore::insert(double x, double value) {
+    // the trial of a given out interval has come back, its parts can be given out again
+    auto contains = trials.upper_bound(x);
+    if (contains != trials.begin()) pending.erase(std::prev(contains)->first);
+
+    auto inserted = trials.insert(std::make_pair(x, value));
+    TrialIterator current = inserted.first;
+    TrialIterator next = std::next(current);
+    TrialIterator prev = current == trials.begin() ? trials.end() : std::prev(current);
+
+    // in one dimension the slope of the split interval lies between the slopes of its parts,
+    // so M over the neighbouring points never decreases, otherwise M is the largest slope seen
+    double oldM = parameterM;
+    if (inserted.second && prev != trials.end())
+        parameterM = std::max(parameterM, std::abs(value - prev->second) / getDistance(prev->first, x));
+    if (inserted.second && next != trials.end())
+        parameterM = std::max(parameterM, std::abs(next->second - value) / getDistance(x, next->first));
+
+    if (parameterM != oldM) {
+        rebuildQueue();
+    } else {
+        if (prev != trials.end()) pushInterval(prev);
+        pushInterval(current);
     }
-    return M;
 }
 
-double getParameterLipschitz(double parameterM, double parameterR) {
-    return (parameterM == 0) ? 1 : parameterR * parameterM;
+bool TrialStore::popBest(double* point0, double* value0, double* point1, double* value1) {
+    while (!queue.empty()) {
+        std::pop_heap(queue.begin(), queue.end());
+        Interval best = queue.back();
+        queue.pop_back();
+
+        // the interval could be split after it was pushed
+        TrialIterator left = trials.find(best.point0);
+        if (left == trials.end()) continue;
+        TrialIterator right = std::next(left);
+        if (right == trials.end() || right->first != best.point1) continue;
+        if (!pending.insert(left->first).second) continue;
+
+        *point0 = left->first;
+        *value0 = left->second;
+        *point1 = right->first;
+        *value1 = right->second;
+        return true;
+    }
+    return false;
 }
 
-std::vector<RAndIndex> getParametersR(
-    const std::vector<double>& points,
-    std::function<double(double)> fun,
-    double parameter_m
-) {
-    std::vector<RAndIndex> characteristicR;
-    for (size_t i = 1; i < points.size(); i++) {
-        double z1 = fun(points[i]);
-        double z0 = fun(points[i - 1]);
-        double pointsDiff = (points[i] - points[i - 1]);
-        double currentR = parameter_m * pointsDiff +
-            (z1 - z0) * (z1 - z0) / (parameter_m * pointsDiff) -
-            2 * (z1 + z0);
-        characteristicR.push_back(std::make_pair(currentR, i));
-    }
-    return characteristicR;
+double TrialStore::getLipschitz() const {
+    return getParameterLipschitz(parameterM, reliability);
 }
 
-double getNextX(
-    double point0,
-    double point1,
-    std::function<double(double)> fun,
-    double parameter_m
-) {
-    double z1 = fun(point0);
-    double z0 = fun(point1);
-    return point0 + (point1 - point0) / 2.0 +
-        (z1 - z0) / (2.0 * parameter_m);
+bool TrialStore::isBest(double x) const {
+    TrialIterator right = trials.upper_bound(x);
+    if (right == trials.begin() || right == trials.end()) return false;
+    double characteristicR = getCharacteristic(std::prev(right));
+    for (double point0 : pending) {
+        if (getCharacteristic(trials.find(point0)) > characteristicR) return false;
+    }
+    return queue.empty() || queue.front().characteristicR <= characteristicR;
 }
 
-double getNextX(
-    const std::vector<double>& points,
-    std::function<double(double)> fun,
-    int indexOfMaxR,
-    double parameter_m
-) {
-    return getNextX(points[indexOfMaxR - 1], points[indexOfMaxR], fun, parameter_m);
+double TrialStore::getCharacteristic(TrialIterator left) const {
+    TrialIterator right = std::next(left);
+    double parameter_m = getLipschitz();
+    double z1 = right->second;
+    double z0 = left->second;
+    double pointsDiff = getDistance(left->first, right->first);
+    return parameter_m * pointsDiff +
+        (z1 - z0) * (z1 - z0) / (parameter_m * pointsDiff) -
+        2 * (z1 + z0);
 }
 
-double globalSearchParallel(std::function<double(double)> fun, double a, double b, double epsilone) {
-    int rank, count;
-    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
-    MPI_Comm_size(MPI_COMM_WORLD, &count);
+void TrialStore::pushInterval(TrialIterator left) {
+    TrialIterator right = std::next(left);
+    if (right == trials.end() || pending.count(left->first)) return;
 
-    std::vector<double> sortedX = { a, b };
+    queue.push_back({ getCharacteristic(left), left->first, right->first });
+    std::push_heap(queue.begin(), queue.end());
+}
 
-    int iterationCount = 0;
-    while (iterationCount++ < maxIterationCount) {
-        std::vector<double> inputBuffer(3);
-        int workedProcessCount = count;
+// m has changed, the characteristics of all intervals are computed again
+void TrialStore::rebuildQueue() {
+    queue.clear();
+    for (TrialIterator it = trials.begin(); it != trials.end(); ++it) pushInterval(it);
+}
 
-        if (rank == 0) {
-            double M = getParameterM(sortedX, fun);
-            double m = getParameterLipschitz(M, parameterR);
-            auto characteristicR = getParametersR(sortedX, fun, m);
+double getMiddle(double a, double b) {
+    return (a + b) / 2.0;
+}
 
-            std::sort(characteristicR.begin(), characteristicR.end(), [](const RAndIndex& p1, const RAndIndex& p2) {
-                return p1.first > p2.first;
-            });
+double getParameterLipschitz(double parameterM, double parameterR) {
+    return (parameterM == 0) ? 1 : parameterR * parameterM;
+}
 
-            int indexOfMaxR = characteristicR.front().second;
-            inputBuffer = { sortedX[indexOfMaxR - 1], sortedX[indexOfMaxR], m };
+double getNextX(double point0, double value0, double point1, double value1, double parameter_m, int dimension) {
+    if (dimension == 1)
+        return point0 + (point1 - point0) / 2.0 + (value0 - value1) / (2.0 * parameter_m);
+    double shift = std::pow(std::abs(value1 - value0) / parameter_m, dimension) / 2.0;
+    return point0 + (point1 - point0) / 2.0 - (value1 > value0 ? shift : -shift);
+}
 
-            workedProcessCount = std::min(static_cast<size_t>(count), characteristicR.size());
-            for (int i = 1; i < workedProcessCount; i++) {
-                RAndIndex r = characteristicR[i];
-                std::vector<double> outputBuffer = { sortedX[r.second - 1], sortedX[r.second],  m };
-                MPI_Send(outputBuffer.data(), 3, MPI_DOUBLE, i, 0, MPI_COMM_WORLD);
-            }
-        }
+HilbertEvolvent::HilbertEvolvent(const std::vector<double>& lower, const std::vector<double>& upper)
+    : lower(lower), upper(upper), bits(std::min(20, 52 / static_cast<int>(lower.size()))) {}
 
-        MPI_Bcast(&workedProcessCount, 1, MPI_INT, 0, MPI_COMM_WORLD);
+uint64_t HilbertEvolvent::getCell(double t) const {
+    const uint64_t cellCount = uint64_t(1) << (getDimension() * bits);
+    double cell = std::floor(t * static_cast<double>(cellCount));
+    if (cell < 0) return 0;
+    if (cell >= static_cast<double>(cellCount)) return cellCount - 1;
+    return static_cast<uint64_t>(cell);
+}
 
-        if (rank != 0 && rank < workedProcessCount) {
-            MPI_Status status;
-            MPI_Recv(inputBuffer.data(), 3, MPI_DOUBLE, 0, 0, MPI_COMM_WORLD, &status);
+// Skilling's algorithm: the bits of the cell number are dealt to the coordinates in turn starting from
+// the top level, then the Gray code and the rotations of the subcubes are undone
+std::vector<double> HilbertEvolvent::getPoint(uint64_t cell) const {
+    const int dimension = getDimension();
+    std::vector<uint64_t> coordinates(dimension, 0);
+    int position = dimension * bits - 1;
+    for (int level = bits - 1; level >= 0; level--) {
+        for (int i = 0; i < dimension; i++, position--) {
+            coordinates[i] |= ((cell >> position) & 1) << level;
         }
+    }
 
-        bool isResultFinded = false;
-        double result = 0.0;
-        if (rank < workedProcessCount) {
-            double nextX = getNextX(inputBuffer[0], inputBuffer[1], fun, inputBuffer[2]);
-
-            int tag = TAG::UNFINDED;
-            if (std::abs(nextX - inputBuffer[0]) < epsilone) {
-                tag = TAG::FINDED;
-            }
-
-            if (rank != 0) {
-                MPI_Send(&nextX, 1, MPI_DOUBLE, 0, tag, MPI_COMM_WORLD);
+    uint64_t temp = coordinates[dimension - 1] >> 1;
+    for (int i = dimension - 1; i > 0; i--) coordinates[i] ^= coordinates[i - 1];
+    coordinates[0] ^= temp;
+    for (uint64_t bit = 2; bit != (uint64_t(1) << bits); bit <<= 1) {
+        uint64_t lowerBits = bit - 1;
+        for (int i = dimension - 1; i >= 0; i--) {
+            if (coordinates[i] & bit) {
+                coordinates[0] ^= lowerBits;
             } else {
-                for (int i = 1; i < workedProcessCount; i++) {
-                    double inputNextX;
-                    MPI_Status status;
-                    MPI_Recv(&inputNextX, 1, MPI_DOUBLE, i, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
-
-                    if (status.MPI_TAG == TAG::FINDED) {
-                        result = inputNextX;
-                        isResultFinded = true;
-                    }
-
-                    auto upperBound = std::upper_bound(sortedX.begin(), sortedX.end(), inputNextX);
-                    sortedX.insert(upperBound, inputNextX);
-                }
-
-                if (tag == TAG::FINDED) {
-                    result = nextX;
-                    isResultFinded = true;
-                }
-
-                auto upperBound = std::upper_bound(sortedX.begin(), sortedX.end(), nextX);
-                sortedX.insert(upperBound, nextX);
+                temp = (coordinates[0] ^ coordinates[i]) & lowerBits;
+                coordinates[0] ^= temp;
+                coordinates[i] ^= temp;
             }
         }
+    }
 
-        MPI_Bcast(&isResultFinded, 1, MPI_BYTE, 0, MPI_COMM_WORLD);
-        if (isResultFinded) return fun(result);
+    std::vector<double> point(dimension);
+    const double side = static_cast<double>(uint64_t(1) << bits);
+    for (int i = 0; i < dimension; i++) {
+        point[i] = lower[i] + (upper[i] - lower[i]) * (static_cast<double>(coordinates[i]) + 0.5) / side;
     }
-    return std::numeric_limits<double>::max();
+    return point;
 }
 
-double globalSearchSequentially(std::function<double(double)> fun, double a, double b, double epsilone) {
-    std::vector<double> sortedX = { a, b };
-
-    while (sortedX.size() < maxIterationCount) {
-        double M = getParameterM(sortedX, fun);
-        double m = getParameterLipschitz(M, parameterR);
-        auto characteristicR = getParametersR(sortedX, fun, m);
-
-        std::sort(characteristicR.begin(), characteristicR.end(), [](const RAndIndex& p1, const RAndIndex& p2) {
-            return p1.first > p2.first;
-        });
-
-        size_t indexOfMaxR = characteristicR.front().second;
-
-        double nextX = getNextX(sortedX, fun, indexOfMaxR, m);
-
-        if (std::abs(nextX - sortedX[indexOfMaxR - 1]) < epsilone)
-            return fun(nextX);
-
-        auto upperBound = std::upper_bound(sortedX.begin(), sortedX.end(), nextX);
+double globalSearchMultidimensional(std::function<double(const std::vector<double>&)> fun,
+    const std::vector<double>& lower, const std::vector<double>& upper, double epsilone,
+    std::vector<double>* argmin) {
+    HilbertEvolvent evolvent(lower, upper);
+
+    // close trials often fall into the same cell of the curve
+    std::unordered_map<uint64_t, double> cache;
+    auto curveFun = [&fun, &evolvent, &cache](const double* ts, double* values, int n) {
+        for (int i = 0; i < n; i++) {
+            uint64_t cell = evolvent.getCell(ts[i]);
+            auto cached = cache.find(cell);
+            if (cached == cache.end()) {
+                cached = cache.insert(std::make_pair(cell, fun(evolvent.getPoint(cell)))).first;
+            }
+            values[i] = cached->second;
+        }
+    };
 
-        sortedX.insert(upperBound, nextX);
-    }
-    return std::numeric_limits<double>::max();
+    double t = 0;
+    double result = searchParallel(curveFun, 0, 1, epsilone, 1, evolvent.getDimension(), &t);
+    if (argmin) *argmin = evolvent.getPoint(evolvent.getCell(t));
+    return result;
 }
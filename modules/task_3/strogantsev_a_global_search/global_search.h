@@ -2,36 +2,343 @@
 #ifndef MODULES_TASK_3_STROGANTSEV_A_GLOBAL_SEARCH_GLOBAL_SEARCH_H_
 #define MODULES_TASK_3_STROGANTSEV_A_GLOBAL_SEARCH_GLOBAL_SEARCH_H_
 
+#include <mpi.h>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <limits>
+#include <map>
+#include <set>
 #include <utility>
 #include <vector>
 
 namespace TAG {
     const int FINDED = 1;
     const int UNFINDED = 2;
+    const int STOP = 3;
 }
 
 const double parameterR = 2.0;
+// The async search takes new intervals while the trials of others are still out, so its estimate of M lags
+// behind more and needs a larger parameter
+const double parameterRAsync = 2.5;
 
-using RAndIndex = std::pair<double, int>;
+// Trial points (x, f(x)) sorted by x. The parameter M and the characteristics R of the intervals are updated
+// only around the inserted point, so the function is called once per point. For a function of dimension
+// variables composed with a space-filling curve the distances are |x1 - x0|^(1 / dimension). An interval
+// given out by popBest stays out of the queue, even when the queue is rebuilt, until a point inside it is
+// inserted.
+class TrialStore {
+ public:
+    TrialStore(double a, double valueA, double b, double valueB, int dimension = 1,
+        double reliability = parameterR);
+
+    void insert(double x, double value);
+    // Takes the interval with the largest R out of the queue, false if there are no intervals that are not
+    // given out already
+    bool popBest(double* point0, double* value0, double* point1, double* value1);
+    // Whether the given out interval around x has the largest R of all intervals, given out or queued
+    bool isBest(double x) const;
+    double getLipschitz() const;
+    size_t size() const { return trials.size(); }
+
+ private:
+    struct Interval {
+        double characteristicR;
+        double point0;
+        double point1;
+        bool operator<(const Interval& other) const { return characteristicR < other.characteristicR; }
+    };
+    using TrialIterator = std::map<double, double>::const_iterator;
+
+    double getDistance(double point0, double point1) const { return std::pow(point1 - point0, power); }
+    double getCharacteristic(TrialIterator left) const;
+    void pushInterval(TrialIterator left);
+    void rebuildQueue();
+
+    std::map<double, double> trials;
+    std::vector<Interval> queue;
+    // left ends of the intervals given out by popBest that wait for their trial
+    std::set<double> pending;
+    double parameterM;
+    double power;
+    double reliability;
+};
+
+// Hilbert curve that fills the box [lower, upper]: t from [0, 1] goes to the centre of the cell number
+// getCell(t) of the 2^(dimension * bits) cells of the box.
+class HilbertEvolvent {
+ public:
+    HilbertEvolvent(const std::vector<double>& lower, const std::vector<double>& upper);
+
+    uint64_t getCell(double t) const;
+    std::vector<double> getPoint(uint64_t cell) const;
+    int getDimension() const { return static_cast<int>(lower.size()); }
+
+ private:
+    std::vector<double> lower;
+    std::vector<double> upper;
+    int bits;
+};
+
+const int maxIterationCount = 50000;
 
 double getMiddle(double a, double b);
-double getParameterM(const std::vector<double>& points, std::function<double(double)> fun);
 double getParameterLipschitz(double parameterM, double parameterR);
-std::vector<RAndIndex> getParametersR(
-    const std::vector<double>& points,
-    std::function<double(double)> fun,
-    double parameter_m
-);
-double getNextX(double point0, double point1, std::function<double(double)> fun, double parameter_m);
-double getNextX(
-    const std::vector<double>& points,
-    std::function<double(double)> fun,
-    int indexOfMaxR,
-    double parameter_m
-);
-
-double globalSearchParallel(std::function<double(double)> fun, double a, double b, double epsilone);
-double globalSearchSequentially(std::function<double(double)> fun, double a, double b, double epsilone);
+
+double getNextX(double point0, double value0, double point1, double value1, double parameter_m, int dimension = 1);
+
+// Batch form of a function of one variable, the calls of fun are inlined into the loop
+template <class Function>
+struct PointwiseBatch {
+    Function fun;
+    void operator()(const double* points, double* values, int n) const {
+        for (int i = 0; i < n; i++) values[i] = fun(points[i]);
+    }
+};
+
+// Process 0 takes up to batch best intervals for every process, every process computes the new points of its
+// intervals (x0, f(x0), x1, f(x1), m), evaluates them with one call of fun and sends back (x, f(x), tag).
+// fun(points, values, n) computes values[i] = f(points[i]) for i < n.
+template <class Batch>
+double searchParallel(const Batch& fun, double a, double b, double epsilone, int batch,
+    int dimension, double* resultPoint) {
+    int rank, count;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &count);
+
+    double bounds[2] = { a, b };
+    double boundValues[2] = { 0.0, 0.0 };
+    if (rank == 0) fun(bounds, boundValues, 2);
+    TrialStore trials(a, boundValues[0], b, boundValues[1], dimension);
+
+    std::vector<double> inputBuffer(5 * batch), outputBuffer(5 * batch);
+    std::vector<double> nextX(batch), nextValues(batch), nextTrials(3 * batch), inputTrials(3 * batch);
+
+    int iterationCount = 0;
+    while (iterationCount++ < maxIterationCount) {
+        int workedProcessCount = 0;
+        int intervalCount = 0;
+
+        if (rank == 0) {
+            for (int process = 0; process < count; process++) {
+                int k = 0;
+                while (k < batch &&
+                    trials.popBest(&outputBuffer[5 * k], &outputBuffer[5 * k + 1], &outputBuffer[5 * k + 2],
+                        &outputBuffer[5 * k + 3])) {
+                    outputBuffer[5 * k + 4] = trials.getLipschitz();
+                    k++;
+                }
+                if (k == 0) break;
+
+                if (process == 0) {
+                    inputBuffer = outputBuffer;
+                    intervalCount = k;
+                } else {
+                    MPI_Send(outputBuffer.data(), 5 * k, MPI_DOUBLE, process, 0, MPI_COMM_WORLD);
+                }
+                workedProcessCount++;
+            }
+        }
+
+        MPI_Bcast(&workedProcessCount, 1, MPI_INT, 0, MPI_COMM_WORLD);
+        if (workedProcessCount == 0) break;
+
+        if (rank != 0 && rank < workedProcessCount) {
+            MPI_Status status;
+            MPI_Recv(inputBuffer.data(), 5 * batch, MPI_DOUBLE, 0, 0, MPI_COMM_WORLD, &status);
+            MPI_Get_count(&status, MPI_DOUBLE, &intervalCount);
+            intervalCount /= 5;
+        }
+
+        bool isResultFinded = false;
+        double result[2] = { 0.0, 0.0 };
+        if (rank < workedProcessCount) {
+            for (int k = 0; k < intervalCount; k++) {
+                nextX[k] = getNextX(inputBuffer[5 * k], inputBuffer[5 * k + 1], inputBuffer[5 * k + 2],
+                    inputBuffer[5 * k + 3], inputBuffer[5 * k + 4], dimension);
+            }
+            fun(nextX.data(), nextValues.data(), intervalCount);
+            for (int k = 0; k < intervalCount; k++) {
+                nextTrials[3 * k] = nextX[k];
+                nextTrials[3 * k + 1] = nextValues[k];
+                nextTrials[3 * k + 2] = std::pow(std::abs(nextX[k] - inputBuffer[5 * k]), 1.0 / dimension) < epsilone
+                    ? TAG::FINDED : TAG::UNFINDED;
+            }
+
+            if (rank != 0) {
+                MPI_Send(nextTrials.data(), 3 * intervalCount, MPI_DOUBLE, 0, 0, MPI_COMM_WORLD);
+            } else {
+                for (int i = 0; i < workedProcessCount; i++) {
+                    int inputCount = 3 * intervalCount;
+                    if (i == 0) {
+                        inputTrials = nextTrials;
+                    } else {
+                        MPI_Status status;
+                        MPI_Recv(inputTrials.data(), 3 * batch, MPI_DOUBLE, i, 0, MPI_COMM_WORLD, &status);
+                        MPI_Get_count(&status, MPI_DOUBLE, &inputCount);
+                    }
+
+                    for (int k = 0; k < inputCount; k += 3) {
+                        if (inputTrials[k + 2] == TAG::FINDED && !isResultFinded) {
+                            result[0] = inputTrials[k];
+                            result[1] = inputTrials[k + 1];
+                            isResultFinded = true;
+                        }
+                        trials.insert(inputTrials[k], inputTrials[k + 1]);
+                    }
+                }
+            }
+        }
+
+        MPI_Bcast(&isResultFinded, 1, MPI_BYTE, 0, MPI_COMM_WORLD);
+        if (isResultFinded) {
+            MPI_Bcast(result, 2, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+            if (resultPoint) *resultPoint = result[0];
+            return result[1];
+        }
+    }
+    return std::numeric_limits<double>::max();
+}
+
+// fun(points, values, n) computes values[i] = f(points[i]) for i < n, so every iteration each process evaluates
+// the new points of up to batch best intervals with one call of fun. The type of fun is a template parameter,
+// so its calls are not made through a pointer and can be inlined.
+template <class Batch>
+double globalSearchParallelBatch(const Batch& fun, double a, double b, double epsilone, int batch = 1) {
+    return searchParallel(fun, a, b, epsilone, batch, 1, nullptr);
+}
+
+template <class Function>
+double globalSearchParallel(Function fun, double a, double b, double epsilone, int batch = 1) {
+    return globalSearchParallelBatch(PointwiseBatch<Function>{ fun }, a, b, epsilone, batch);
+}
+
+// Process 0 keeps the trials and sends the best intervals to a worker as soon as it returns its previous
+// points, so the workers do not wait for each other
+template <class Batch>
+double globalSearchAsyncBatch(const Batch& fun, double a, double b, double epsilone, int batch = 1) {
+    int rank, count;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &count);
+
+    if (count == 1) return searchParallel(fun, a, b, epsilone, batch, 1, nullptr);
+
+    double result = std::numeric_limits<double>::max();
+    if (rank == 0) {
+        double bounds[2] = { a, b };
+        double boundValues[2];
+        fun(bounds, boundValues, 2);
+        TrialStore trials(a, boundValues[0], b, boundValues[1], 1, parameterRAsync);
+        std::vector<double> outputBuffer(5 * batch), inputTrials(3 * batch);
+        std::vector<char> isWorking(count, 0);
+        int workingCount = 0;
+        bool isResultFinded = false;
+
+        auto sendIntervals = [&](int worker) {
+            int k = 0;
+            while (!isResultFinded && k < batch && trials.size() < maxIterationCount &&
+                trials.popBest(&outputBuffer[5 * k], &outputBuffer[5 * k + 1], &outputBuffer[5 * k + 2],
+                    &outputBuffer[5 * k + 3])) {
+                outputBuffer[5 * k + 4] = trials.getLipschitz();
+                k++;
+            }
+            if (k == 0) return;
+            MPI_Send(outputBuffer.data(), 5 * k, MPI_DOUBLE, worker, 0, MPI_COMM_WORLD);
+            isWorking[worker] = 1;
+            workingCount++;
+        };
+
+        for (int i = 1; i < count; i++) sendIntervals(i);
+
+        while (workingCount > 0) {
+            MPI_Status status;
+            int inputCount;
+            MPI_Recv(inputTrials.data(), 3 * batch, MPI_DOUBLE, MPI_ANY_SOURCE, 0, MPI_COMM_WORLD, &status);
+            MPI_Get_count(&status, MPI_DOUBLE, &inputCount);
+            isWorking[status.MPI_SOURCE] = 0;
+            workingCount--;
+            if (isResultFinded) continue;
+
+            // a small interval ends the search only if it is still the best one, the better ones can be out
+            // at other workers
+            for (int k = 0; k < inputCount; k += 3) {
+                if (inputTrials[k + 2] == TAG::FINDED && !isResultFinded && trials.isBest(inputTrials[k])) {
+                    result = inputTrials[k + 1];
+                    isResultFinded = true;
+                }
+                trials.insert(inputTrials[k], inputTrials[k + 1]);
+            }
+            if (isResultFinded) continue;
+
+            sendIntervals(status.MPI_SOURCE);
+            for (int i = 1; i < count; i++) {
+                if (!isWorking[i]) sendIntervals(i);
+            }
+        }
+
+        std::vector<MPI_Request> requests(count - 1);
+        for (int i = 1; i < count; i++) {
+            MPI_Isend(nullptr, 0, MPI_DOUBLE, i, TAG::STOP, MPI_COMM_WORLD, &requests[i - 1]);
+        }
+        MPI_Waitall(count - 1, requests.data(), MPI_STATUSES_IGNORE);
+    } else {
+        std::vector<double> inputBuffer(5 * batch);
+        std::vector<double> nextX(batch), nextValues(batch), nextTrials(3 * batch);
+        while (true) {
+            MPI_Status status;
+            int intervalCount;
+            MPI_Recv(inputBuffer.data(), 5 * batch, MPI_DOUBLE, 0, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
+            if (status.MPI_TAG == TAG::STOP) break;
+            MPI_Get_count(&status, MPI_DOUBLE, &intervalCount);
+            intervalCount /= 5;
+
+            for (int k = 0; k < intervalCount; k++) {
+                nextX[k] = getNextX(inputBuffer[5 * k], inputBuffer[5 * k + 1], inputBuffer[5 * k + 2],
+                    inputBuffer[5 * k + 3], inputBuffer[5 * k + 4]);
+            }
+            fun(nextX.data(), nextValues.data(), intervalCount);
+            for (int k = 0; k < intervalCount; k++) {
+                nextTrials[3 * k] = nextX[k];
+                nextTrials[3 * k + 1] = nextValues[k];
+                nextTrials[3 * k + 2] = std::abs(nextX[k] - inputBuffer[5 * k]) < epsilone
+                    ? TAG::FINDED : TAG::UNFINDED;
+            }
+            MPI_Send(nextTrials.data(), 3 * intervalCount, MPI_DOUBLE, 0, 0, MPI_COMM_WORLD);
+        }
+    }
+
+    MPI_Bcast(&result, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    return result;
+}
+
+template <class Function>
+double globalSearchAsync(Function fun, double a, double b, double epsilone, int batch = 1) {
+    return globalSearchAsyncBatch(PointwiseBatch<Function>{ fun }, a, b, epsilone, batch);
+}
+
+// Minimum of fun over the box [lower, upper]. The parallel search runs over the parameter of the Hilbert curve,
+// the values are cached per cell of the curve. The found point is stored to argmin.
+double globalSearchMultidimensional(std::function<double(const std::vector<double>&)> fun,
+    const std::vector<double>& lower, const std::vector<double>& upper, double epsilone,
+    std::vector<double>* argmin = nullptr);
+
+template <class Function>
+double globalSearchSequentially(Function fun, double a, double b, double epsilone) {
+    TrialStore trials(a, fun(a), b, fun(b));
+
+    double point0, value0, point1, value1;
+    while (trials.size() < maxIterationCount && trials.popBest(&point0, &value0, &point1, &value1)) {
+        double nextX = getNextX(point0, value0, point1, value1, trials.getLipschitz());
+
+        if (std::abs(nextX - point0) < epsilone)
+            return fun(nextX);
+
+        trials.insert(nextX, fun(nextX));
+    }
+    return std::numeric_limits<double>::max();
+}
 
 #endif  // MODULES_TASK_3_STROGANTSEV_A_GLOBAL_SEARCH_GLOBAL_SEARCH_H_
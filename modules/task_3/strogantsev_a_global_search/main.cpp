@@ -1,7 +1,11 @@
 // Copyright 2022 Strogantsev Anton
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <iostream>
 #include <cmath>
+#include <random>
+#include <set>
+#include <vector>
 #include "./global_search.h"
 #include <gtest-mpi-listener.hpp>
 
@@ -110,6 +114,138 @@ TEST(GlobalSearch, ComplexFun) {
     }
 }
 
+TEST(GlobalSearch, TrialStoreKeepsParameterM) {
+    TrialStore trials(0, 0, 1, 3);
+    ASSERT_DOUBLE_EQ(parameterR * 3, trials.getLipschitz());
+    trials.insert(0.5, 1.5);
+    ASSERT_DOUBLE_EQ(parameterR * 3, trials.getLipschitz());
+    trials.insert(0.75, 0);
+    ASSERT_DOUBLE_EQ(parameterR * 12, trials.getLipschitz());
+    ASSERT_EQ(4u, trials.size());
+}
+
+TEST(GlobalSearch, TrialStoreGivesOutIntervalOnce) {
+    // process 0 of the async search: four intervals are out at a time and come back in a random order,
+    // the parameter M grows often and the queue is rebuilt while intervals are out
+    auto fun = [](double x) { return std::sin(20 * x) * x * x; };
+    TrialStore trials(-3, fun(-3), 3, fun(3));
+    struct OutInterval { double point0, point1, nextX; };
+    std::vector<OutInterval> out;
+    std::mt19937 gen(7);
+
+    double point0, value0, point1, value1;
+    for (int step = 0; step < 2000; step++) {
+        while (out.size() < 4 && trials.popBest(&point0, &value0, &point1, &value1)) {
+            for (const OutInterval& interval : out) {
+                ASSERT_TRUE(point1 <= interval.point0 || interval.point1 <= point0) << step;
+            }
+            out.push_back({ point0, point1, getNextX(point0, value0, point1, value1, trials.getLipschitz()) });
+        }
+        ASSERT_FALSE(out.empty());
+        size_t k = gen() % out.size();
+        trials.insert(out[k].nextX, fun(out[k].nextX));
+        out.erase(out.begin() + k);
+    }
+    ASSERT_EQ(2002u, trials.size());
+
+    // only the given out interval with the largest R can end the search
+    TrialStore two(0, 0, 4, 0);
+    ASSERT_TRUE(two.popBest(&point0, &value0, &point1, &value1));
+    two.insert(1, -1);
+    ASSERT_TRUE(two.popBest(&point0, &value0, &point1, &value1));
+    ASSERT_DOUBLE_EQ(1, point0);
+    ASSERT_TRUE(two.popBest(&point0, &value0, &point1, &value1));
+    ASSERT_FALSE(two.isBest(0.5));
+    ASSERT_TRUE(two.isBest(2));
+}
+
+TEST(GlobalSearch, SequentialCallsFunctionOncePerPoint) {
+    int calls = 0;
+    std::set<double> points;
+    auto fun = [&calls, &points](double x) {
+        calls++;
+        points.insert(x);
+        return std::sin(x);
+    };
+
+    double result = globalSearchSequentially(fun, -pi, pi, epsilon * 0.1);
+
+    ASSERT_NEAR(-1, result, epsilon);
+    ASSERT_EQ(static_cast<int>(points.size()), calls);
+}
+
+TEST(GlobalSearch, AsyncComplexFun) {
+    auto fun = [](double x) { return std::sin(2 * x * std::sin(x) * std::cos(x)) + std::sin(-x * std::cos(x)); };
+
+    double result = globalSearchAsync(fun, 2 * pi, 3 * pi, epsilon * 0.1);
+
+    ASSERT_NEAR(-2, result, epsilon);
+}
+
+TEST(GlobalSearch, AsyncVariableCost) {
+    // evaluations near the right end are much slower
+    auto fun = [](double x) {
+        double sum = 0;
+        for (int i = 0; i < static_cast<int>(1000 * x); i++) sum += std::sin(i);
+        return std::cos(x) + 1e-12 * sum;
+    };
+
+    double result = globalSearchAsync(fun, 0, 2 * pi, epsilon * 0.1);
+
+    ASSERT_NEAR(-1, result, epsilon);
+}
+
+TEST(GlobalSearch, HilbertNeighbourCells) {
+    HilbertEvolvent evolvent({ -1, -1 }, { 1, 1 });
+    const double side = 2.0 / (1 << 20);
+    for (uint64_t cell = 0; cell < 10000; cell += 13) {
+        std::vector<double> point0 = evolvent.getPoint(cell);
+        std::vector<double> point1 = evolvent.getPoint(cell + 1);
+        double shift = std::abs(point1[0] - point0[0]) + std::abs(point1[1] - point0[1]);
+        ASSERT_NEAR(side, shift, 1e-12);
+    }
+}
+
+TEST(GlobalSearch, MultidimensionalQuadratic) {
+    auto fun = [](const std::vector<double>& x) {
+        return (x[0] - 0.5) * (x[0] - 0.5) + (x[1] - 0.25) * (x[1] - 0.25) + x[2] * x[2];
+    };
+    std::vector<double> argmin;
+
+    double result = globalSearchMultidimensional(fun, { -1, -1, -1 }, { 1, 1, 1 }, epsilon, &argmin);
+
+    ASSERT_NEAR(0, result, epsilon);
+    ASSERT_EQ(3u, argmin.size());
+    ASSERT_NEAR(0.5, argmin[0], 0.1);
+    ASSERT_NEAR(0.25, argmin[1], 0.1);
+    ASSERT_NEAR(0, argmin[2], 0.1);
+}
+
+TEST(GlobalSearch, BatchFunction) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    int largestBatch = 0;
+    auto fun = [&largestBatch](const double* points, double* values, int n) {
+        largestBatch = std::max(largestBatch, n);
+        for (int i = 0; i < n; i++) values[i] = std::sin(points[i]);
+    };
+
+    double result = globalSearchParallelBatch(fun, -pi, pi, epsilon * 0.1, 5);
+
+    ASSERT_NEAR(-1, result, epsilon);
+    if (rank == 0) {
+        ASSERT_EQ(5, largestBatch);
+    }
+}
+
+TEST(GlobalSearch, AsyncBatches) {
+    auto fun = [](double x) { return x * x; };
+
+    double result = globalSearchAsync(fun, -3, 2, epsilon * 0.1, 4);
+
+    ASSERT_NEAR(0, result, epsilon);
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     MPI_Init(&argc, &argv);
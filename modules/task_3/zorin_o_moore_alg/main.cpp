@@ -1,5 +1,7 @@
 // Copyright 2022 Zorin Oleg
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
 #include <vector>
 #include "./moore_alg.h"
 #include <gtest-mpi-listener.hpp>
@@ -66,6 +68,67 @@ TEST(moore_algo, big_test_neg_weigh) {
     }
 }
 
+TEST(moore_algo, negative_cycle_throws) {
+    int size = 50;
+    std::vector<std::vector<int>> matrix(size, std::vector<int>(size, INF));
+    for (int i = 0; i < size - 1; i++) matrix[i][i + 1] = 2;
+    matrix[size - 1][size / 2] = -2 * (size - size / 2);
+    ASSERT_ANY_THROW(moore_algorithm(matrix, 0, size - 1, size));
+    // the same cycle does not matter when it can't be reached
+    matrix[0][1] = INF;
+    matrix[0][size - 1] = -1;
+    matrix[size - 1][size / 2] = INF;
+    matrix[size - 2][size / 2] = -2 * (size - size / 2);
+    ASSERT_EQ(-1, moore_algorithm(matrix, 0, size - 1, size));
+}
+
+TEST(moore_algo, delta_stepping_random_graph) {
+    int size = 60;
+    int prank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &prank);
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> weight(1, 100);
+    std::vector<std::vector<int>> matrix(size, std::vector<int>(size, INF));
+    for (int i = 0; i < size; i++)
+        for (int j = 0; j < size; j++)
+            if (i != j && gen() % 10 < 2) matrix[i][j] = weight(gen);
+
+    std::vector<int> expected(size, INF);
+    expected[0] = 0;
+    for (int k = 0; k < size - 1; k++)
+        for (int i = 0; i < size; i++)
+            for (int j = 0; j < size; j++)
+                if (expected[i] != INF && matrix[i][j] != INF)
+                    expected[j] = std::min(expected[j], expected[i] + matrix[i][j]);
+
+    csr_graph graph = local_csr_graph(matrix, size);
+    for (int delta : {0, 1, 25, 1000}) {
+        std::vector<int> dist = delta_stepping(graph, 0, delta);
+        for (size_t v = 0; v < dist.size(); v++) {
+            ASSERT_EQ(expected[graph.first + v], dist[v]);
+        }
+    }
+}
+
+TEST(moore_algo, multiple_starts) {
+    int size = 40;
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<int> weight(1, 50);
+    std::vector<std::vector<int>> matrix(size, std::vector<int>(size, INF));
+    for (int i = 0; i < size; i++)
+        for (int j = 0; j < size; j++)
+            if (i != j && gen() % 10 < 3) matrix[i][j] = weight(gen);
+
+    std::vector<int> starts = {0, 13, 39};
+    std::vector<std::vector<int>> dist = moore_algorithm(matrix, starts, size);
+    ASSERT_EQ(starts.size(), dist.size());
+    for (size_t s = 0; s < starts.size(); s++) {
+        for (int v = 0; v < size; v++) {
+            ASSERT_EQ(moore_algorithm(matrix, starts[s], v, size), dist[s][v]);
+        }
+    }
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     MPI_Init(&argc, &argv);
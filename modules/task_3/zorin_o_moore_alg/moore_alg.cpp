@@ -1,104 +1,216 @@
 // Copyright 2022 Zorin Oleg
 #include "../../modules/task_3/zorin_o_moore_alg/moore_alg.h"
 #include <mpi.h>
-#include <deque>
-
-std::vector<int> update(std::vector<int> *dist, const int size, const std::vector<int> &range, const int d) {
-    std::vector<int> update;
-    for (int i = 0; i < size; i++) {
-        if (d + range[i] < dist->at(i) && range[i] != INF) {
-            dist->at(i) = d + range[i];
-            update.push_back(i);
+#include <algorithm>
+#include <climits>
+#include <vector>
+
+int block_first(int size, int pcount, int prank) {
+    return prank * (size / pcount) + std::min(prank, size % pcount);
+}
+
+int block_owner(int v, int size, int pcount) {
+    int block = size / pcount;
+    int rem = size % pcount;
+    if (v < rem * (block + 1)) return v / (block + 1);
+    return rem + (v - rem * (block + 1)) / block;
+}
+
+csr_graph local_csr_graph(const std::vector<std::vector<int>> &adjacency_matrix, int size) {
+    int prank, pcount;
+    MPI_Comm_rank(MPI_COMM_WORLD, &prank);
+    MPI_Comm_size(MPI_COMM_WORLD, &pcount);
+
+    csr_graph graph;
+    graph.size = size;
+    graph.first = block_first(size, pcount, prank);
+    int last = block_first(size, pcount, prank + 1);
+    graph.row_ptr.push_back(0);
+    for (int v = graph.first; v < last; v++) {
+        for (int u = 0; u < size; u++) {
+            if (adjacency_matrix[v][u] != INF) {
+                graph.adj.push_back(u);
+                graph.weight.push_back(adjacency_matrix[v][u]);
+            }
         }
+        graph.row_ptr.push_back(graph.adj.size());
     }
-    return update;
+    return graph;
 }
 
-void side_process_work(int prank) {
-    while (true) {
-        int size;
-        MPI_Status status;
-        MPI_Recv(&size, 1, MPI_INT, 0, 0, MPI_COMM_WORLD, &status);
-        if (size == EXIT_PROCESS) return;
-        std::vector<int> dist(size);
-        MPI_Recv(dist.data(), size, MPI_INT, 0, 0, MPI_COMM_WORLD, &status);
-        std::vector<int> range(size);
-        MPI_Recv(range.data(), size, MPI_INT, 0, 0, MPI_COMM_WORLD, &status);
-        int d;
-        MPI_Recv(&d, 1, MPI_INT, 0, 0, MPI_COMM_WORLD, &status);
-        std::vector<int> updated = update(&dist, size, range, d);
-        int up_size = updated.size();
-        MPI_Send(&up_size, 1, MPI_INT, 0, 0, MPI_COMM_WORLD);
-        if (up_size != 0)
-            MPI_Send(updated.data(), up_size, MPI_INT, 0, 0, MPI_COMM_WORLD);
-        MPI_Send(dist.data(), size, MPI_INT, 0, 0, MPI_COMM_WORLD);
+// Sends every process its (vertex, distance) requests with one MPI_Alltoallv,
+// returns the requests addressed to this process.
+static std::vector<int> exchange_requests(std::vector<std::vector<int>> *out) {
+    int pcount;
+    MPI_Comm_size(MPI_COMM_WORLD, &pcount);
+
+    std::vector<int> send_counts(pcount), send_displs(pcount, 0);
+    std::vector<int> recv_counts(pcount), recv_displs(pcount, 0);
+    for (int i = 0; i < pcount; i++) send_counts[i] = (*out)[i].size();
+    MPI_Alltoall(send_counts.data(), 1, MPI_INT, recv_counts.data(), 1, MPI_INT, MPI_COMM_WORLD);
+    for (int i = 1; i < pcount; i++) {
+        send_displs[i] = send_displs[i - 1] + send_counts[i - 1];
+        recv_displs[i] = recv_displs[i - 1] + recv_counts[i - 1];
+    }
+
+    std::vector<int> send(send_displs[pcount - 1] + send_counts[pcount - 1]);
+    for (int i = 0; i < pcount; i++) {
+        std::copy((*out)[i].begin(), (*out)[i].end(), send.begin() + send_displs[i]);
+        (*out)[i].clear();
     }
+    std::vector<int> recv(recv_displs[pcount - 1] + recv_counts[pcount - 1]);
+    MPI_Alltoallv(send.data(), send_counts.data(), send_displs.data(), MPI_INT,
+                  recv.data(), recv_counts.data(), recv_displs.data(), MPI_INT, MPI_COMM_WORLD);
+    return recv;
 }
 
-int moore_algorithm(const std::vector<std::vector<int>> &adjacency_matrix, int start, int end, int size) {
+std::vector<int> delta_stepping(const csr_graph &graph, int start, int delta) {
     int prank, pcount;
     MPI_Comm_rank(MPI_COMM_WORLD, &prank);
     MPI_Comm_size(MPI_COMM_WORLD, &pcount);
-    if (prank != 0) {
-        side_process_work(prank);
-        return 0;
+
+    const int local_size = graph.row_ptr.size() - 1;
+
+    int min_w = 0, max_w = 1;
+    for (size_t i = 0; i < graph.weight.size(); i++) {
+        min_w = std::min(min_w, graph.weight[i]);
+        max_w = std::max(max_w, graph.weight[i]);
+    }
+    int edges = graph.adj.size();
+    MPI_Allreduce(MPI_IN_PLACE, &min_w, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+    MPI_Allreduce(MPI_IN_PLACE, &max_w, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+    MPI_Allreduce(MPI_IN_PLACE, &edges, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+
+    const bool single_bucket = min_w < 0;
+    if (delta <= 0) {
+        int degree = std::max(1, edges / std::max(1, graph.size));
+        delta = std::max(1, max_w / degree);
+    }
+
+    std::vector<int> dist(local_size, INF);
+    std::vector<std::vector<int>> buckets;
+    auto insert = [&](int v, int d) {
+        size_t b = single_bucket ? 0 : d / delta;
+        if (b >= buckets.size()) buckets.resize(b + 1);
+        buckets[b].push_back(v);
+    };
+    auto relax = [&](const std::vector<int> &requests) {
+        for (size_t i = 0; i < requests.size(); i += 2) {
+            int v = requests[i] - graph.first;
+            if (requests[i + 1] < dist[v]) {
+                dist[v] = requests[i + 1];
+                insert(v, dist[v]);
+            }
+        }
+    };
+
+    if (block_owner(start, graph.size, pcount) == prank) {
+        dist[start - graph.first] = 0;
+        insert(start - graph.first, 0);
     }
-    std::deque<int> q;
-    q.push_back(start);
-
-    std::vector<int> dist(size, INF);
-    dist[start] = 0;
-    std::vector<int> was(size, 0);
-    while (!q.empty()) {
-        int current = q.front();
-        q.pop_front();
-        int block = size / pcount;
-        for (int i = 1; i < pcount; i++) {
-            int start = i * block + size % pcount;
-            MPI_Send(&block, 1, MPI_INT, i, 0, MPI_COMM_WORLD);
-            MPI_Send(dist.data() + start, block, MPI_INT, i, 0, MPI_COMM_WORLD);
-            MPI_Send(adjacency_matrix[current].data() + start, block, MPI_INT, i, 0,
-                     MPI_COMM_WORLD);
-            MPI_Send(&dist[current], 1, MPI_INT, i, 0, MPI_COMM_WORLD);
+
+    std::vector<std::vector<int>> out(pcount);
+    std::vector<int> frontier, settled;
+    std::vector<int> seen(local_size, -1), settled_in(local_size, -1);
+    int cursor = 0, round = 0;
+
+    while (true) {
+        int b = INT_MAX;
+        for (size_t i = cursor; i < buckets.size(); i++) {
+            if (!buckets[i].empty()) {
+                b = i;
+                break;
+            }
         }
-        std::vector<int> upd = update(&dist, block + size % pcount,
-                                      adjacency_matrix[current], dist[current]);
-        for (auto v : upd) {
-            v = v + start;
-            if (was[v] == 0) {
-                q.push_back(v);
-                was[v] = 1;
-            } else {
-                q.push_front(v);
+        MPI_Allreduce(MPI_IN_PLACE, &b, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+        if (b == INT_MAX) break;
+        cursor = b;
+
+        // light edges may refill the bucket, so it is emptied in rounds
+        settled.clear();
+        int more = 1;
+        while (more) {
+            round++;
+            frontier.clear();
+            if (static_cast<size_t>(b) < buckets.size()) frontier.swap(buckets[b]);
+            for (size_t i = 0; i < frontier.size(); i++) {
+                int v = frontier[i];
+                int d = dist[v];
+                if (seen[v] == round || (!single_bucket && d / delta != b)) continue;
+                seen[v] = round;
+                if (settled_in[v] != b) {
+                    settled_in[v] = b;
+                    settled.push_back(v);
+                }
+                for (int e = graph.row_ptr[v]; e < graph.row_ptr[v + 1]; e++) {
+                    if (single_bucket || graph.weight[e] <= delta) {
+                        std::vector<int> &req = out[block_owner(graph.adj[e], graph.size, pcount)];
+                        req.push_back(graph.adj[e]);
+                        req.push_back(d + graph.weight[e]);
+                    }
+                }
+            }
+            relax(exchange_requests(&out));
+
+            more = static_cast<size_t>(b) < buckets.size() && !buckets[b].empty();
+            MPI_Allreduce(MPI_IN_PLACE, &more, 1, MPI_INT, MPI_LOR, MPI_COMM_WORLD);
+            // round r settles the paths of r edges, so a distance that still
+            // drops after size - 1 rounds lies on a negative cycle; more is
+            // the same on every process, so they all throw together
+            if (single_bucket && more && round >= graph.size) {
+                throw "Negative cycle reachable from the start vertex";
             }
         }
-        for (int i = 1; i < pcount; i++) {
-            int start = i * block + size % pcount;
-            int resv_size;
-            MPI_Status status;
-            MPI_Recv(&resv_size, 1, MPI_INT, i, 0, MPI_COMM_WORLD, &status);
-            std::vector<int> update(resv_size);
-            if (resv_size != 0)
-                MPI_Recv(update.data(), resv_size, MPI_INT, i, 0, MPI_COMM_WORLD,
-                         &status);
-            MPI_Recv(dist.data() + start, block, MPI_INT, i, 0, MPI_COMM_WORLD,
-                     &status);
-            for (auto v : update) {
-                v = v + start;
-                if (was[v] == 0) {
-                    q.push_back(v);
-                    was[v] = 1;
-                } else {
-                    q.push_front(v);
+        if (single_bucket) break;
+
+        // heavy edges lead to later buckets and are relaxed once
+        for (size_t i = 0; i < settled.size(); i++) {
+            int v = settled[i];
+            for (int e = graph.row_ptr[v]; e < graph.row_ptr[v + 1]; e++) {
+                if (graph.weight[e] > delta) {
+                    std::vector<int> &req = out[block_owner(graph.adj[e], graph.size, pcount)];
+                    req.push_back(graph.adj[e]);
+                    req.push_back(dist[v] + graph.weight[e]);
                 }
             }
         }
+        relax(exchange_requests(&out));
     }
 
-    for (int i = 1; i < pcount; i++) {
-        int ext = EXIT_PROCESS;
-        MPI_Send(&ext, 1, MPI_INT, i, 0, MPI_COMM_WORLD);
+    return dist;
+}
+
+int moore_algorithm(const std::vector<std::vector<int>> &adjacency_matrix, int start, int end, int size) {
+    int prank, pcount;
+    MPI_Comm_rank(MPI_COMM_WORLD, &prank);
+    MPI_Comm_size(MPI_COMM_WORLD, &pcount);
+
+    csr_graph graph = local_csr_graph(adjacency_matrix, size);
+    std::vector<int> dist = delta_stepping(graph, start);
+
+    int owner = block_owner(end, size, pcount);
+    int ans = owner == prank ? dist[end - graph.first] : 0;
+    MPI_Bcast(&ans, 1, MPI_INT, owner, MPI_COMM_WORLD);
+    return ans;
+}
+
+std::vector<std::vector<int>> moore_algorithm(const std::vector<std::vector<int>> &adjacency_matrix,
+                                              const std::vector<int> &starts, int size) {
+    int pcount;
+    MPI_Comm_size(MPI_COMM_WORLD, &pcount);
+
+    std::vector<int> counts(pcount), displs(pcount);
+    for (int i = 0; i < pcount; i++) {
+        displs[i] = block_first(size, pcount, i);
+        counts[i] = block_first(size, pcount, i + 1) - displs[i];
     }
 
-    return dist[end];
+    csr_graph graph = local_csr_graph(adjacency_matrix, size);
+    std::vector<std::vector<int>> res(starts.size(), std::vector<int>(size));
+    for (size_t s = 0; s < starts.size(); s++) {
+        std::vector<int> dist = delta_stepping(graph, starts[s]);
+        MPI_Allgatherv(dist.data(), dist.size(), MPI_INT, res[s].data(), counts.data(), displs.data(), MPI_INT,
+                       MPI_COMM_WORLD);
+    }
+    return res;
 }
@@ -3,11 +3,38 @@
 #define MODULES_TASK_3_ZORIN_O_MOORE_ALG_MOORE_ALG_H_
 
 #include <vector>
-#include <deque>
 
 #define INF 1000000
-#define EXIT_PROCESS -1
+
+// Out-edges of the vertices [first, first + row_ptr.size() - 1) of a graph
+// with size vertices: edges of v go to adj[i] with weight[i] for
+// row_ptr[v - first] <= i < row_ptr[v - first + 1].
+struct csr_graph {
+    int size = 0;
+    int first = 0;
+    std::vector<int> row_ptr;
+    std::vector<int> adj;
+    std::vector<int> weight;
+};
+
+// Vertices are split between processes in contiguous blocks
+int block_first(int size, int pcount, int prank);
+int block_owner(int v, int size, int pcount);
+
+// Block of rows of the current process, INF means no edge
+csr_graph local_csr_graph(const std::vector<std::vector<int>> &adjacency_matrix, int size);
+
+// Distributed delta-stepping, returns the distances of the vertices of the
+// local block. delta <= 0 picks max weight / average degree. With negative
+// weights a single bucket is used, which is a frontier Bellman-Ford; if a
+// negative cycle is reachable from start it throws on every process.
+std::vector<int> delta_stepping(const csr_graph &graph, int start, int delta = 0);
 
 int moore_algorithm(const std::vector<std::vector<int>> &adjacency_matrix, int start, int end, int size);
 
+// Distances from every start to all vertices. The local graph is built once
+// for the whole batch, every process gets the full rows.
+std::vector<std::vector<int>> moore_algorithm(const std::vector<std::vector<int>> &adjacency_matrix,
+                                              const std::vector<int> &starts, int size);
+
 #endif  // MODULES_TASK_3_ZORIN_O_MOORE_ALG_MOORE_ALG_H_